@@ -0,0 +1,162 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+AssetLoader::AssetLoader(unsigned int numWorkers)
+	: m_stop(false),
+	m_numPending(0),
+	m_stagingBytes(0)
+{
+	if (numWorkers == 0) {
+		numWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+	}
+
+	for (unsigned int i = 0; i < numWorkers; i++) {
+		m_workers.emplace_back(&AssetLoader::WorkerLoop, this);
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		m_stop = true;
+		m_jobs.clear();
+	}
+	m_jobsCondition.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+void AssetLoader::WorkerLoop()
+{
+	while (true) {
+		Task job;
+		{
+			std::unique_lock<std::mutex> lock(m_jobsMutex);
+			m_jobsCondition.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+
+			if (m_stop) {
+				return;
+			}
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+		job();
+	}
+}
+
+void AssetLoader::Submit(Task job)
+{
+	m_numPending++;
+	{
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_jobsCondition.notify_one();
+}
+
+void AssetLoader::QueueUpload(Task upload)
+{
+	std::lock_guard<std::mutex> lock(m_uploadsMutex);
+	m_uploads.push_back(std::move(upload));
+}
+
+void AssetLoader::LoadMesh(const std::string& filepath,
+	const std::shared_ptr<MeshObject>& mesh,
+	GLint positionShaderAttribute,
+	GLint normalShaderAttribute,
+	GLint texelShaderAttribute)
+{
+	std::weak_ptr<MeshObject> target = mesh;
+
+	Submit([=]() {
+		try {
+			// std::function must be copyable
+			auto source = std::make_shared<MeshSource>(filepath);
+			auto size = source->GetSize();
+			m_stagingBytes += size;
+
+			QueueUpload([=]() {
+				m_stagingBytes -= size;
+
+				if (auto mesh = target.lock()) {
+					mesh->Create(*source, positionShaderAttribute, normalShaderAttribute, texelShaderAttribute);
+				}
+			});
+		}
+		catch (const std::exception& ex) {
+			std::string message = ex.what();
+			QueueUpload([=]() { throw std::runtime_error(message); });
+		}
+	});
+}
+
+void AssetLoader::LoadTexture(const std::string& filepath, const std::shared_ptr<Texture>& texture)
+{
+	std::weak_ptr<Texture> target = texture;
+
+	Submit([=]() {
+		try {
+			auto image = std::make_shared<Utils::TextureImage>(Utils::LoadTextureImage(filepath));
+			auto size = image->pixels.size();
+			m_stagingBytes += size;
+
+			QueueUpload([=]() {
+				m_stagingBytes -= size;
+
+				if (auto texture = target.lock()) {
+					texture->SetImage(*image);
+				}
+			});
+		}
+		catch (const std::exception& ex) {
+			std::string message = ex.what();
+			QueueUpload([=]() { throw std::runtime_error(message); });
+		}
+	});
+}
+
+void AssetLoader::LoadJob(Job job)
+{
+	Submit([=]() {
+		try {
+			QueueUpload(job());
+		}
+		catch (const std::exception& ex) {
+			std::string message = ex.what();
+			QueueUpload([=]() { throw std::runtime_error(message); });
+		}
+	});
+}
+
+void AssetLoader::ProcessUploads(float budgetMilliseconds)
+{
+	using Clock = std::chrono::steady_clock;
+
+	auto&& deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<float, std::milli>(budgetMilliseconds));
+
+	do {
+		Task upload;
+		{
+			std::lock_guard<std::mutex> lock(m_uploadsMutex);
+
+			if (m_uploads.empty()) {
+				return;
+			}
+
+			upload = std::move(m_uploads.front());
+			m_uploads.pop_front();
+		}
+
+		m_numPending--;
+		upload();
+	} while (Clock::now() < deadline);
+}
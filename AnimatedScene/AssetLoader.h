@@ -0,0 +1,90 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "MeshObject.h"
+#include "Texture.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads assets in the background
+// Files are decoded on worker threads, the GL uploads are queued and run on the main (GL) thread
+// Targets are held weakly, upload of already released target is skipped
+class AssetLoader final {
+public:
+
+	using Task = std::function<void()>;
+
+	// Runs on a worker, returned task is run on the GL thread like uploads
+	using Job = std::function<Task()>;
+
+private:
+
+	std::vector<std::thread> m_workers;
+
+	std::deque<Task> m_jobs;
+	std::mutex m_jobsMutex;
+	std::condition_variable m_jobsCondition;
+	bool m_stop;
+
+	std::deque<Task> m_uploads;
+	std::mutex m_uploadsMutex;
+
+	// Assets requested, but not uploaded yet (main thread only)
+	size_t m_numPending;
+
+	// Decoded buffers waiting for upload
+	std::atomic<size_t> m_stagingBytes;
+
+	void WorkerLoop();
+	void Submit(Task job);
+	void QueueUpload(Task upload);
+
+public:
+
+	// Zero means one worker less than hardware threads (the main thread keeps rendering)
+	AssetLoader(unsigned int numWorkers = 0);
+
+	// Unfinished jobs and uploads are dropped
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// Mesh stays empty (not drawn) until it's uploaded
+	void LoadMesh(const std::string& filepath,
+		const std::shared_ptr<MeshObject>& mesh,
+		GLint positionShaderAttribute,
+		GLint normalShaderAttribute,
+		GLint texelShaderAttribute);
+
+	// Texture stays without image (not loaded) until it's uploaded
+	void LoadTexture(const std::string& filepath, const std::shared_ptr<Texture>& texture);
+
+	// Load anything else in the background (e.g. solver tables), the job is pending until it's task is run
+	void LoadJob(Job job);
+
+	// Run queued GL uploads, must be called on the GL thread
+	// Stops when the budget is spent, but always does at least one upload
+	// Rethrows loading errors
+	void ProcessUploads(float budgetMilliseconds);
+
+	size_t GetNumPending() const { return m_numPending; }
+	bool IsIdle() const { return m_numPending == 0; }
+
+	// CPU memory held by decoded, not yet uploaded assets
+	size_t GetStagingBytes() const { return m_stagingBytes; }
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "AssetRegistry.h"
+
+namespace {
+	template<typename T>
+	void RemoveExpiredEntries(std::unordered_map<std::string, std::weak_ptr<T>>& assets)
+	{
+		for (auto it = assets.begin(); it != assets.end();) {
+			if (it->second.expired()) {
+				it = assets.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+}
+
+std::string AssetRegistry::GetMeshKey(const std::string& filepath,
+	GLint positionShaderAttribute,
+	GLint normalShaderAttribute,
+	GLint texelShaderAttribute)
+{
+	// VAO depends on attribute locations
+	return filepath + '|' + std::to_string(positionShaderAttribute)
+		+ '|' + std::to_string(normalShaderAttribute)
+		+ '|' + std::to_string(texelShaderAttribute);
+}
+
+void AssetRegistry::RemoveExpired()
+{
+	RemoveExpiredEntries(m_meshes);
+	RemoveExpiredEntries(m_textures);
+}
+
+std::shared_ptr<MeshObject> AssetRegistry::GetMesh(const std::string& filepath,
+	GLint positionShaderAttribute,
+	GLint normalShaderAttribute,
+	GLint texelShaderAttribute)
+{
+	auto& entry = m_meshes[GetMeshKey(filepath, positionShaderAttribute, normalShaderAttribute, texelShaderAttribute)];
+
+	if (auto mesh = entry.lock()) {
+		return mesh;
+	}
+
+	auto mesh = std::make_shared<MeshObject>();
+	m_loader.LoadMesh(filepath, mesh, positionShaderAttribute, normalShaderAttribute, texelShaderAttribute);
+	entry = mesh;
+	return mesh;
+}
+
+std::shared_ptr<Texture> AssetRegistry::GetTexture(const std::string& filepath)
+{
+	auto& entry = m_textures[filepath];
+
+	if (auto texture = entry.lock()) {
+		return texture;
+	}
+
+	auto texture = std::make_shared<Texture>();
+	texture->SetMinMagBilinearFilter();
+	texture->SetWrapRepeat();
+	m_loader.LoadTexture(filepath, texture);
+	entry = texture;
+	return texture;
+}
+
+void AssetRegistry::Update(float uploadBudgetMilliseconds)
+{
+	m_loader.ProcessUploads(uploadBudgetMilliseconds);
+	RemoveExpired();
+}
+
+AssetMemoryStats AssetRegistry::GetMemoryStats() const
+{
+	AssetMemoryStats stats = {};
+	stats.cpuBytes = m_loader.GetStagingBytes();
+
+	for (const auto& entry : m_meshes) {
+		if (auto mesh = entry.second.lock()) {
+			stats.numMeshes++;
+			stats.gpuBytes += mesh->GetGpuSize();
+		}
+	}
+	for (const auto& entry : m_textures) {
+		if (auto texture = entry.second.lock()) {
+			stats.numTextures++;
+			stats.gpuBytes += texture->GetGpuSize();
+		}
+	}
+	return stats;
+}
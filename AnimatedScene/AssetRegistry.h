@@ -0,0 +1,65 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include "AssetLoader.h"
+#include "MeshObject.h"
+#include "Texture.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Resident asset memory
+struct AssetMemoryStats {
+	size_t numMeshes;
+	size_t numTextures;
+	size_t cpuBytes; // decoded, waiting for upload
+	size_t gpuBytes; // VBOs and textures
+};
+
+// Hands out shared handles to meshes and textures, each file (with the same load parameters) is loaded once
+// Registry keeps weak references only, asset is unloaded when it's last handle is released
+// Loading is asynchronous, see AssetLoader
+class AssetRegistry final {
+private:
+
+	AssetLoader m_loader;
+
+	std::unordered_map<std::string, std::weak_ptr<MeshObject>> m_meshes;
+	std::unordered_map<std::string, std::weak_ptr<Texture>> m_textures;
+
+	static std::string GetMeshKey(const std::string& filepath,
+		GLint positionShaderAttribute,
+		GLint normalShaderAttribute,
+		GLint texelShaderAttribute);
+
+	// Remove entries of released assets
+	void RemoveExpired();
+
+public:
+
+	AssetRegistry() = default;
+
+	AssetRegistry(const AssetRegistry&) = delete;
+	AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+	std::shared_ptr<MeshObject> GetMesh(const std::string& filepath,
+		GLint positionShaderAttribute,
+		GLint normalShaderAttribute,
+		GLint texelShaderAttribute);
+
+	// Texture is created with bilinear filter and repeat wrap
+	std::shared_ptr<Texture> GetTexture(const std::string& filepath);
+
+	// Non-GL asset loaded in the background, see AssetLoader::LoadJob
+	void LoadJob(AssetLoader::Job job) { m_loader.LoadJob(std::move(job)); }
+
+	// Must be called on the GL thread every frame, see AssetLoader::ProcessUploads
+	void Update(float uploadBudgetMilliseconds);
+
+	AssetMemoryStats GetMemoryStats() const;
+
+	bool IsLoading() const { return !m_loader.IsIdle(); }
+};
+
+#endif
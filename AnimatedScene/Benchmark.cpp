@@ -0,0 +1,768 @@
+#include "Benchmark.h"
+#include "CubeBatch.h"
+#include "CubeScrambler.h"
+#include "CubeSolver.h"
+#include "ReductionSolver.h"
+#include "PocketCubeSolver.h"
+#include "FixedCubeState.h"
+#include "RubikCube.h"
+#include "ShaderProgram.h"
+#include "Camera.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+	const auto DATA_DIRECTORY = "Data";
+	const auto OBJ_PARSER_ITERATIONS = 20u;
+	const auto LARGE_OBJ_ITERATIONS = 3u;
+	const auto LARGE_OBJ_SOURCE = "Data/Lamp.obj";
+	const size_t LARGE_OBJ_SIZE = 256u * 1024u * 1024u;
+	const auto CUBE_FRAMES = 200u;
+	const unsigned int CUBE_SIZES[] = { 3, 5, 10, 15, 32, 64, 100, 128, 256 };
+	const auto MAX_INSTANCED_CUBE_SIZE = 64u;
+	const auto CUBE_DELTA_TIME = 0.5f; // every rotation takes two frames
+	const unsigned int CUBE_DRAW_SIZES[] = { 3, 15 };
+	const auto CUBE_MOVES = 4000000u;
+	const auto CUBE_BATCH_SIZE = 8192u;
+	const auto CUBE_BATCH_MOVES = 200u;
+	const unsigned int CUBE_BATCH_SIZES[] = { 2, 3, 4, 5 };
+	const auto CUBE_SOLVER_STATES = 100u;
+	const auto CUBE_SOLVER_SEED = 42u;
+	const auto REDUCTION_MIN_SIZE = 4u;
+	const auto REDUCTION_MAX_SIZE = 15u;
+	const auto REDUCTION_STATES = 10u;
+	const auto RANDOM_MOVES_PER_LAYER = 20u;
+	const unsigned int SCRAMBLE_SIZES[] = { 2, 3, 4, 5, 7, 10, 15, 32 };
+	const auto SCRAMBLE_STATES = 20000u;
+	const auto POCKET_CUBE_STATES = 10000u;
+	const auto POCKET_CUBE_TABLE_PATH = "PocketCubeBenchmark.tables";
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// Rewrite face indices of .obj content into negative ones, relative to the last read vertex, texel and normal
+	std::string MakeIndicesRelative(const std::string& content)
+	{
+		std::istringstream input(content);
+		std::ostringstream output;
+		std::string line;
+		long long numVertices = 0, numTexels = 0, numNormals = 0;
+
+		while (std::getline(input, line)) {
+			if (line.compare(0, 2, "v ") == 0) {
+				numVertices++;
+			}
+			else if (line.compare(0, 3, "vt ") == 0) {
+				numTexels++;
+			}
+			else if (line.compare(0, 3, "vn ") == 0) {
+				numNormals++;
+			}
+			else if (line.compare(0, 2, "f ") == 0) {
+				std::istringstream corners(line.substr(2));
+				std::string corner;
+				line = "f";
+
+				while (corners >> corner) {
+					std::istringstream indices(corner);
+					std::string index;
+					const long long counts[] = { numVertices, numTexels, numNormals };
+
+					line += ' ';
+					for (auto i = 0; std::getline(indices, index, '/'); i++) {
+						line += (i > 0 ? "/" : "") + (index.empty() ? index : std::to_string(std::stoll(index) - counts[i] - 1));
+					}
+				}
+			}
+			output << line << '\n';
+		}
+		return output.str();
+	}
+
+	// Return average time of one call in milliseconds
+	double MeasureMilliseconds(unsigned int iterations, const std::function<void()>& function)
+	{
+		auto start = Clock::now();
+
+		for (auto i = 0u; i < iterations; i++) {
+			function();
+		}
+
+		std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+		return elapsed.count() / iterations;
+	}
+
+	std::vector<std::string> GetDataFiles(const std::string& extension)
+	{
+		std::vector<std::string> files;
+
+		for (const auto& entry : std::filesystem::directory_iterator(DATA_DIRECTORY)) {
+			if (entry.path().extension() == extension) {
+				files.push_back(entry.path().string());
+			}
+		}
+
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	// GL benchmarks need a context, the window stays hidden
+	void CreateHiddenContext()
+	{
+		static auto created = false;
+
+		if (created) {
+			return;
+		}
+
+		int argc = 1;
+		char name[] = "AnimatedScene";
+		char* argv[] = { name, nullptr };
+
+		glutInit(&argc, argv);
+		glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGBA);
+		glutInitContextVersion(3, 3);
+		glutInitContextProfile(GLUT_COMPATIBILITY_PROFILE);
+		glutInitWindowSize(800, 600);
+		glutCreateWindow("Benchmark");
+		glutHideWindow();
+
+		glewExperimental = GL_TRUE;
+		if (glewInit() != GLEW_OK) {
+			throw std::runtime_error("Unable to initialize GLEW");
+		}
+
+		glEnable(GL_DEPTH_TEST);
+		created = true;
+	}
+
+	std::vector<CubeState::Move> GetRandomMoves(unsigned int numStickersEdge, size_t numMoves)
+	{
+		std::vector<CubeState::Move> moves(numMoves);
+
+		for (auto& move : moves) {
+			move = CubeState::Move{ static_cast<CubeState::Axis>(rand() % 3), rand() % numStickersEdge, rand() % 2 == 0 };
+		}
+		return moves;
+	}
+
+	// Return millions of moves per second
+	template<typename State>
+	double MeasureCubeMoves(State& state, const std::vector<CubeState::Move>& moves)
+	{
+		auto time = MeasureMilliseconds(1, [&]() {
+			for (const auto& move : moves) {
+				state.RotateLayer(move);
+			}
+		});
+		return moves.size() / time / 1000.0;
+	}
+
+	template<unsigned int N>
+	void MeasureCubeMoves(std::ostream& out)
+	{
+		auto&& moves = GetRandomMoves(N, CUBE_MOVES);
+		CubeState generic(N, false);
+		CubeState specialized(N);
+		FixedCubeState<N> fixed;
+
+		auto genericSpeed = MeasureCubeMoves(generic, moves);
+		auto specializedSpeed = MeasureCubeMoves(specialized, moves);
+		auto fixedSpeed = MeasureCubeMoves(fixed, moves);
+
+		auto identical = FixedCubeState<N>(generic) == fixed && FixedCubeState<N>(specialized) == fixed;
+
+		out << std::setw(8) << N << std::fixed << std::setprecision(1)
+			<< std::setw(12) << genericSpeed << std::setw(14) << specializedSpeed << std::setw(12) << fixedSpeed
+			<< std::setw(9) << std::setprecision(2) << fixedSpeed / genericSpeed << "x"
+			<< (identical ? "" : "  STATE MISMATCH") << "\n";
+	}
+
+	// Rotate a random layer and draw the cube in the middle and at the end of the rotation
+	// Return average time of one frame in milliseconds
+	double MeasureRubikCube(RubikCube& cube,
+		const Camera& camera,
+		const MatrixShaderUniforms& matrixUniforms,
+		const MaterialShaderUniforms& materialUniforms,
+		const InstanceShaderUniforms& instanceUniforms)
+	{
+		auto numStickers = cube.GetNumStickersPerEdge();
+
+		return MeasureMilliseconds(CUBE_FRAMES, [&]() {
+			if (!cube.IsRotating()) {
+				cube.Rotate(static_cast<RubikCube::RotationType>(rand() % 3), rand() % numStickers, rand() % 2 == 0);
+			}
+			cube.Update(CUBE_DELTA_TIME);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			cube.Draw(camera, matrixUniforms, materialUniforms, instanceUniforms);
+			glFinish();
+		});
+	}
+
+	// Scene's shader with attributes and uniforms of Rubik's cube, needs GL context
+	struct RubikCubeShader {
+		ShaderProgram shader;
+		GLint positionAttribute;
+		GLint normalAttribute;
+		GLint texelAttribute;
+		GLint instanceModelMatrixAttribute;
+		GLint instanceMaterialIndexAttribute;
+		MatrixShaderUniforms matrixUniforms;
+		MaterialShaderUniforms materialUniforms;
+		InstanceShaderUniforms instanceUniforms;
+
+		RubikCubeShader()
+			: shader("VertexShader.glsl", "FragmentShader.glsl"),
+			positionAttribute(shader.GetAttribLocation("position")),
+			normalAttribute(shader.GetAttribLocation("normal")),
+			texelAttribute(shader.GetAttribLocation("texel")),
+			instanceModelMatrixAttribute(shader.GetAttribLocation("instance_model_matrix")),
+			instanceMaterialIndexAttribute(shader.GetAttribLocation("instance_material_index")),
+			matrixUniforms(shader.GetUniformLocation("pvm_matrix"),
+				shader.GetUniformLocation("normal_matrix"),
+				shader.GetUniformLocation("model_matrix")),
+			materialUniforms(shader.GetUniformLocation("material_ambient_color"),
+				shader.GetUniformLocation("material_diffuse_color"),
+				shader.GetUniformLocation("material_specular_color"),
+				shader.GetUniformLocation("material_shininess")),
+			instanceUniforms(shader.GetUniformLocation("instanced"),
+				shader.GetUniformLocation("palette_ambient_colors"),
+				shader.GetUniformLocation("palette_diffuse_colors"),
+				shader.GetUniformLocation("palette_specular_colors"),
+				shader.GetUniformLocation("palette_shininess"),
+				shader.GetUniformLocation("sticker_state"),
+				shader.GetUniformLocation("sticker_state_sampler"))
+		{
+		}
+	};
+
+	// Average CPU time of updating and drawing the cube with rotating layers, GPU is not waited for
+	double MeasureRubikCubeDraw(RubikCube& cube, const Camera& camera, const RubikCubeShader& cubeShader)
+	{
+		cube.QueueMoves(GetRandomMoves(cube.GetNumStickersPerEdge(), CUBE_FRAMES));
+
+		auto time = MeasureMilliseconds(CUBE_FRAMES, [&]() {
+			cube.Update(CUBE_DELTA_TIME);
+			cube.Draw(camera, cubeShader.matrixUniforms, cubeShader.materialUniforms, cubeShader.instanceUniforms);
+		});
+
+		glFinish();
+		return time;
+	}
+}
+
+void Benchmark::ObjParsers(std::ostream& out)
+{
+	std::vector<GLfloat> vertices, normals, texels;
+	std::vector<GLfloat> mappedVertices, mappedNormals, mappedTexels;
+	double totalStream = 0.0;
+	double totalMapped = 0.0;
+
+	out << "OBJ parsers (" << OBJ_PARSER_ITERATIONS << " iterations, ms per file)\n";
+	out << std::setw(40) << std::left << "file" << std::right
+		<< std::setw(12) << "iostream" << std::setw(12) << "mapped" << std::setw(10) << "speedup" << "\n";
+
+	for (const auto& file : GetDataFiles(".obj")) {
+		auto streamTime = MeasureMilliseconds(OBJ_PARSER_ITERATIONS, [&]() {
+			Utils::LoadObjFileStream(file, vertices, normals, texels);
+		});
+		auto mappedTime = MeasureMilliseconds(OBJ_PARSER_ITERATIONS, [&]() {
+			Utils::LoadObjFile(file, mappedVertices, mappedNormals, mappedTexels);
+		});
+
+		auto identical = vertices == mappedVertices && normals == mappedNormals && texels == mappedTexels;
+
+		out << std::setw(40) << std::left << file << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(12) << streamTime << std::setw(12) << mappedTime
+			<< std::setw(9) << std::setprecision(2) << streamTime / mappedTime << "x"
+			<< (identical ? "" : "  OUTPUT MISMATCH") << "\n";
+
+		totalStream += streamTime;
+		totalMapped += mappedTime;
+	}
+
+	out << std::setw(40) << std::left << "total" << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << totalStream << std::setw(12) << totalMapped
+		<< std::setw(9) << std::setprecision(2) << totalStream / totalMapped << "x\n";
+}
+
+void Benchmark::LargeObjParser(std::ostream& out)
+{
+	// Synthetic large export: the same mesh repeated, indices stay valid since they are absolute
+	// The second file uses negative indices, which point into previous chunks after the split
+	auto largeFile = (std::filesystem::temp_directory_path() / "AnimatedSceneLarge.obj").string();
+	auto largeRelativeFile = (std::filesystem::temp_directory_path() / "AnimatedSceneLargeRelative.obj").string();
+	{
+		std::ifstream source(LARGE_OBJ_SOURCE, std::ios::binary);
+		std::stringstream content;
+		content << source.rdbuf();
+		auto&& chunk = content.str();
+		auto&& relativeChunk = MakeIndicesRelative(chunk);
+
+		std::ofstream target(largeFile, std::ios::binary);
+		std::ofstream relativeTarget(largeRelativeFile, std::ios::binary);
+		for (size_t written = 0; written < LARGE_OBJ_SIZE; written += chunk.size()) {
+			target.write(chunk.data(), chunk.size());
+			relativeTarget.write(relativeChunk.data(), relativeChunk.size());
+		}
+	}
+
+	std::vector<GLfloat> vertices, normals, texels;
+	std::vector<GLfloat> parallelVertices, parallelNormals, parallelTexels;
+
+	auto sequentialTime = MeasureMilliseconds(LARGE_OBJ_ITERATIONS, [&]() {
+		Utils::LoadObjFile(largeFile, vertices, normals, texels, Utils::ObjLoadMode::SEQUENTIAL);
+	});
+	auto parallelTime = MeasureMilliseconds(LARGE_OBJ_ITERATIONS, [&]() {
+		Utils::LoadObjFile(largeFile, parallelVertices, parallelNormals, parallelTexels, Utils::ObjLoadMode::PARALLEL);
+	});
+
+	auto identical = vertices == parallelVertices && normals == parallelNormals && texels == parallelTexels;
+
+	auto relativeTime = MeasureMilliseconds(LARGE_OBJ_ITERATIONS, [&]() {
+		Utils::LoadObjFile(largeRelativeFile, parallelVertices, parallelNormals, parallelTexels, Utils::ObjLoadMode::PARALLEL);
+	});
+
+	auto relativeIdentical = vertices == parallelVertices && normals == parallelNormals && texels == parallelTexels;
+
+	out << "Large OBJ parser (" << std::filesystem::file_size(largeFile) / (1024 * 1024) << " MB, "
+		<< std::thread::hardware_concurrency() << " hardware threads, ms per file)\n";
+	out << std::fixed << std::setprecision(1)
+		<< "sequential " << sequentialTime << "\n"
+		<< "parallel   " << parallelTime << " (" << std::setprecision(2) << sequentialTime / parallelTime << "x)"
+		<< (identical ? "" : "  OUTPUT MISMATCH") << "\n"
+		<< std::setprecision(1) << "parallel   " << relativeTime << " (negative indices)"
+		<< (relativeIdentical ? "" : "  OUTPUT MISMATCH") << "\n";
+
+	std::filesystem::remove(largeFile);
+	std::filesystem::remove(largeRelativeFile);
+}
+
+void Benchmark::RubikCubeSizes(std::ostream& out)
+{
+	CreateHiddenContext();
+
+	RubikCubeShader cubeShader;
+	cubeShader.shader.SetActive();
+	glUniform1i(cubeShader.instanceUniforms.stickerStateSamplerUniform, StickerSurface::STATE_TEXTURE_UNIT);
+
+	Camera camera(800.f, 600.f);
+
+	out << "Rubik's cube (" << CUBE_FRAMES << " frames, rotate + update + draw, ms per frame)\n";
+	out << std::setw(8) << "size" << std::setw(12) << "stickers"
+		<< std::setw(14) << "state texture" << std::setw(12) << "instanced" << "\n";
+
+	auto maxSurfaceSize = StickerSurface::GetMaxStickersPerEdge();
+
+	for (auto size : CUBE_SIZES) {
+		out << std::setw(8) << size << std::setw(12) << 6u * size * size << std::fixed << std::setprecision(3);
+
+		// State texture has to fit into GL_MAX_TEXTURE_SIZE
+		if (size <= maxSurfaceSize) {
+			RubikCube surfaceCube(cubeShader.positionAttribute, cubeShader.normalAttribute, size);
+			surfaceCube.EnableStateTexture(cubeShader.positionAttribute, cubeShader.normalAttribute, cubeShader.texelAttribute);
+			out << std::setw(14) << MeasureRubikCube(surfaceCube, camera, cubeShader.matrixUniforms, cubeShader.materialUniforms, cubeShader.instanceUniforms);
+		}
+		else {
+			out << std::setw(14) << "-";
+		}
+
+		// Per sticker path gets too slow for larger cubes
+		if (size <= MAX_INSTANCED_CUBE_SIZE) {
+			RubikCube instancedCube(cubeShader.positionAttribute, cubeShader.normalAttribute, size,
+				cubeShader.instanceModelMatrixAttribute, cubeShader.instanceMaterialIndexAttribute);
+			auto instancedTime = MeasureRubikCube(instancedCube, camera, cubeShader.matrixUniforms, cubeShader.materialUniforms, cubeShader.instanceUniforms);
+			out << std::setw(12) << instancedTime;
+		}
+		else {
+			out << std::setw(12) << "-";
+		}
+		out << "\n";
+	}
+
+	cubeShader.shader.SetInactive();
+}
+
+void Benchmark::RubikCubeDrawCpu(std::ostream& out)
+{
+	CreateHiddenContext();
+
+	RubikCubeShader cubeShader;
+	cubeShader.shader.SetActive();
+	glUniform1i(cubeShader.instanceUniforms.stickerStateSamplerUniform, StickerSurface::STATE_TEXTURE_UNIT);
+
+	Camera camera(800.f, 600.f);
+
+	out << "Rubik's cube draw (" << CUBE_FRAMES << " frames, update + draw CPU time, ms per frame)\n";
+	out << std::setw(8) << "size" << std::setw(12) << "stickers"
+		<< std::setw(14) << "state texture" << std::setw(12) << "instanced" << "\n";
+
+	srand(CUBE_SOLVER_SEED);
+
+	for (auto size : CUBE_DRAW_SIZES) {
+		RubikCube surfaceCube(cubeShader.positionAttribute, cubeShader.normalAttribute, size);
+		surfaceCube.EnableStateTexture(cubeShader.positionAttribute, cubeShader.normalAttribute, cubeShader.texelAttribute);
+
+		RubikCube instancedCube(cubeShader.positionAttribute, cubeShader.normalAttribute, size,
+			cubeShader.instanceModelMatrixAttribute, cubeShader.instanceMaterialIndexAttribute);
+
+		out << std::setw(8) << size << std::setw(12) << 6u * size * size << std::fixed << std::setprecision(4)
+			<< std::setw(14) << MeasureRubikCubeDraw(surfaceCube, camera, cubeShader)
+			<< std::setw(12) << MeasureRubikCubeDraw(instancedCube, camera, cubeShader) << "\n";
+	}
+
+	cubeShader.shader.SetInactive();
+}
+
+void Benchmark::CubeMoves(std::ostream& out)
+{
+	out << "Cube moves (" << CUBE_MOVES << " random moves, millions of moves per second)\n";
+	out << std::setw(8) << "size" << std::setw(12) << "generic"
+		<< std::setw(14) << "dispatched" << std::setw(12) << "fixed" << std::setw(10) << "speedup" << "\n";
+
+	MeasureCubeMoves<2>(out);
+	MeasureCubeMoves<3>(out);
+	MeasureCubeMoves<4>(out);
+	MeasureCubeMoves<5>(out);
+}
+
+void Benchmark::CubeBatchMoves(std::ostream& out)
+{
+	out << "Cube batch (" << CUBE_BATCH_SIZE << " cubes, " << CUBE_BATCH_MOVES
+		<< " moves per cube, millions of cube moves per second)\n";
+	out << std::setw(8) << "size" << std::setw(12) << "states" << std::setw(12) << "same"
+		<< std::setw(12) << "different" << "\n";
+
+	for (auto size : CUBE_BATCH_SIZES) {
+		std::vector<std::vector<CubeState::Move>> rounds;
+
+		for (auto i = 0u; i < CUBE_BATCH_MOVES; i++) {
+			rounds.push_back(GetRandomMoves(size, CUBE_BATCH_SIZE));
+		}
+
+		// One state per cube, each with it's own moves
+		std::vector<CubeState> states(CUBE_BATCH_SIZE, CubeState(size));
+		auto statesTime = MeasureMilliseconds(1, [&]() {
+			for (const auto& moves : rounds) {
+				for (size_t cube = 0; cube < states.size(); cube++) {
+					states[cube].RotateLayer(moves[cube]);
+				}
+			}
+		});
+
+		CubeBatch batch(size, CUBE_BATCH_SIZE);
+		auto sameTime = MeasureMilliseconds(1, [&]() {
+			for (const auto& moves : rounds) {
+				batch.RotateLayer(moves.front());
+			}
+		});
+
+		batch.Reset();
+		auto differentTime = MeasureMilliseconds(1, [&]() {
+			for (const auto& moves : rounds) {
+				batch.RotateEachLayer(moves);
+			}
+		});
+
+		auto identical = true;
+		for (size_t cube = 0; cube < states.size(); cube++) {
+			identical = identical && batch.GetState(cube) == states[cube];
+		}
+
+		auto numMoves = static_cast<double>(CUBE_BATCH_SIZE) * CUBE_BATCH_MOVES / 1000.0;
+
+		out << std::setw(8) << size << std::fixed << std::setprecision(1)
+			<< std::setw(12) << numMoves / statesTime << std::setw(12) << numMoves / sameTime
+			<< std::setw(12) << numMoves / differentTime
+			<< (identical ? "" : "  STATE MISMATCH") << "\n";
+	}
+}
+
+void Benchmark::CubeSolverTimes(std::ostream& out)
+{
+	auto start = Clock::now();
+	CubeSolver solver;
+	std::chrono::duration<double, std::milli> loadTime = Clock::now() - start;
+
+	out << "Cube solver (" << CUBE_SOLVER_STATES << " uniformly random states)\n";
+	out << "tables " << (solver.WereTablesGenerated() ? "generated" : "mapped") << " in "
+		<< std::fixed << std::setprecision(1) << loadTime.count() << " ms\n";
+
+	// The same states on every run
+	CubeScrambler scrambler(3, CUBE_SOLVER_SEED);
+
+	std::vector<double> times;
+	std::vector<CubeState::Move> solution;
+	size_t totalMoves = 0;
+	auto failed = 0u;
+
+	for (auto i = 0u; i < CUBE_SOLVER_STATES; i++) {
+		CubeState state;
+		scrambler.Generate(state);
+
+		auto solved = false;
+		times.push_back(MeasureMilliseconds(1, [&]() { solved = solver.Solve(state, solution); }));
+
+		for (const auto& move : solution) {
+			state.RotateLayer(move);
+		}
+
+		// Scrambles with middle layers are solved relative to the centers
+		for (auto face = 0u; face < CubeState::NUM_FACES && solved; face++) {
+			for (auto x = 0u; x < 3; x++) {
+				for (auto y = 0u; y < 3; y++) {
+					auto f = static_cast<CubeState::Face>(face);
+					solved = solved && state.Get(f, x, y) == state.Get(f, 1, 1);
+				}
+			}
+		}
+
+		failed += solved ? 0 : 1;
+		totalMoves += solution.size();
+	}
+
+	std::sort(times.begin(), times.end());
+	auto average = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+
+	out << std::setw(12) << "average" << std::setw(12) << "median" << std::setw(12) << "p99"
+		<< std::setw(12) << "max" << std::setw(12) << "moves" << "\n";
+	out << std::fixed << std::setprecision(3) << std::setw(12) << average
+		<< std::setw(12) << times[times.size() / 2] << std::setw(12) << times[times.size() * 99 / 100]
+		<< std::setw(12) << times.back() << std::setprecision(1)
+		<< std::setw(12) << static_cast<double>(totalMoves) / CUBE_SOLVER_STATES
+		<< (failed == 0 ? "" : "  UNSOLVED STATES") << "\n";
+}
+
+void Benchmark::CubeSolverScaling(std::ostream& out)
+{
+	CubeSolver solver;
+	std::vector<CubeState> states;
+
+	// Same states as the sequential solver benchmark
+	CubeScrambler scrambler(3, CUBE_SOLVER_SEED);
+
+	for (auto i = 0u; i < CUBE_SOLVER_STATES; i++) {
+		CubeState state;
+		scrambler.Generate(state);
+		states.push_back(state);
+	}
+
+	std::vector<std::vector<CubeState::Move>> solutions(states.size());
+	auto sequentialTime = MeasureMilliseconds(1, [&]() {
+		for (size_t i = 0; i < states.size(); i++) {
+			solver.Solve(states[i], solutions[i]);
+		}
+	}) / states.size();
+
+	out << "Parallel cube solver (" << CUBE_SOLVER_STATES << " states, "
+		<< std::thread::hardware_concurrency() << " hardware threads, ms per solve)\n";
+	out << std::setw(8) << "threads" << std::setw(12) << "time" << std::setw(12) << "speedup" << "\n";
+	out << std::setw(8) << "-" << std::fixed << std::setprecision(3) << std::setw(12) << sequentialTime
+		<< std::setprecision(2) << std::setw(12) << 1.0 << "\n";
+
+	std::vector<unsigned int> threadCounts;
+	auto maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (auto threads = 1u; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	for (auto threads : threadCounts) {
+		TaskPool pool(threads);
+		std::vector<CubeState::Move> solution;
+		auto identical = true;
+
+		auto time = MeasureMilliseconds(1, [&]() {
+			for (size_t i = 0; i < states.size(); i++) {
+				solver.Solve(states[i], solution, pool);
+				identical = identical && solution.size() == solutions[i].size()
+					&& std::equal(solution.begin(), solution.end(), solutions[i].begin(), [](const CubeState::Move& a, const CubeState::Move& b) {
+						return a.axis == b.axis && a.layer == b.layer && a.clockwise == b.clockwise;
+					});
+			}
+		}) / states.size();
+
+		out << std::setw(8) << threads << std::fixed << std::setprecision(3) << std::setw(12) << time
+			<< std::setprecision(2) << std::setw(12) << sequentialTime / time
+			<< (identical ? "" : "  SOLUTION MISMATCH") << "\n";
+	}
+}
+
+void Benchmark::ReductionSolverSizes(std::ostream& out)
+{
+	CubeSolver cubeSolver;
+	ReductionSolver solver(cubeSolver);
+
+	out << "Reduction solver (" << REDUCTION_STATES << " uniformly random states per size)\n";
+	out << std::setw(8) << "size" << std::setw(12) << "average" << std::setw(12) << "max"
+		<< std::setw(12) << "moves" << "\n";
+
+	for (auto size = REDUCTION_MIN_SIZE; size <= REDUCTION_MAX_SIZE; size++) {
+		CubeScrambler scrambler(size, CUBE_SOLVER_SEED);
+		std::vector<double> times;
+		std::vector<CubeState::Move> solution;
+		size_t totalMoves = 0;
+		auto failed = 0u;
+
+		for (auto i = 0u; i < REDUCTION_STATES; i++) {
+			CubeState state(size);
+			scrambler.Generate(state);
+
+			times.push_back(MeasureMilliseconds(1, [&]() { solver.Solve(state, solution); }));
+			totalMoves += solution.size();
+
+			for (const auto& move : solution) {
+				state.RotateLayer(move);
+			}
+
+			for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+				auto f = static_cast<CubeState::Face>(face);
+				auto stickers = state.GetFaceStorage(f);
+
+				if (std::any_of(stickers, stickers + size * size, [&](unsigned char color) { return color != stickers[0]; })) {
+					failed++;
+					break;
+				}
+			}
+		}
+
+		out << std::setw(8) << size << std::fixed << std::setprecision(3)
+			<< std::setw(12) << std::accumulate(times.begin(), times.end(), 0.0) / times.size()
+			<< std::setw(12) << *std::max_element(times.begin(), times.end()) << std::setprecision(0)
+			<< std::setw(12) << static_cast<double>(totalMoves) / REDUCTION_STATES
+			<< (failed == 0 ? "" : "  UNSOLVED STATES") << "\n";
+	}
+}
+
+void Benchmark::PocketCubeSolverTable(std::ostream& out)
+{
+	auto tablePath = (std::filesystem::temp_directory_path() / POCKET_CUBE_TABLE_PATH).string();
+
+	out << "Pocket cube distance table (" << PocketCubeSolver::NUM_STATES << " states, "
+		<< PocketCubeSolver::GetTableSize() << " bytes, ms per build)\n";
+	out << std::setw(8) << "threads" << std::setw(12) << "build" << std::setw(12) << "speedup" << "\n";
+
+	std::vector<unsigned int> threadCounts;
+	auto maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (auto threads = 1u; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	auto sequentialTime = 0.0;
+
+	for (auto threads : threadCounts) {
+		std::error_code error;
+		std::filesystem::remove(tablePath, error);
+
+		auto time = MeasureMilliseconds(1, [&]() { PocketCubeSolver solver(tablePath, threads); });
+		sequentialTime = (threads == 1) ? time : sequentialTime;
+
+		out << std::setw(8) << threads << std::fixed << std::setprecision(3) << std::setw(12) << time
+			<< std::setprecision(2) << std::setw(12) << sequentialTime / time << "\n";
+	}
+
+	std::unique_ptr<PocketCubeSolver> solver;
+	auto mapTime = MeasureMilliseconds(1, [&]() { solver = std::make_unique<PocketCubeSolver>(tablePath); });
+
+	out << "mapped in " << std::fixed << std::setprecision(3) << mapTime << " ms"
+		<< (solver->WereTablesGenerated() ? " (TABLE NOT WRITTEN)" : "")
+		<< ", largest distance " << solver->GetMaxDistance() << " face turns\n";
+
+	CubeScrambler scrambler(2, CUBE_SOLVER_SEED);
+
+	std::vector<CubeState> states;
+	for (auto i = 0u; i < POCKET_CUBE_STATES; i++) {
+		CubeState state(2);
+		scrambler.Generate(state);
+		states.push_back(state);
+	}
+
+	std::vector<CubeState::Move> solution;
+	size_t totalTurns = 0;
+	auto solveTime = MeasureMilliseconds(1, [&]() {
+		for (const auto& state : states) {
+			solver->Solve(state, solution);
+		}
+	}) / states.size();
+
+	for (const auto& state : states) {
+		totalTurns += solver->GetDistance(state);
+	}
+
+	out << "optimal solve " << std::setprecision(4) << solveTime << " ms, average "
+		<< std::setprecision(2) << static_cast<double>(totalTurns) / states.size() << " face turns\n";
+
+	solver.reset();
+	std::error_code error;
+	std::filesystem::remove(tablePath, error);
+}
+
+void Benchmark::CubeScrambles(std::ostream& out)
+{
+	out << "Cube scrambles (" << SCRAMBLE_STATES << " states per size, thousands of states per second)\n";
+	out << std::setw(8) << "size" << std::setw(12) << "uniform" << std::setw(12) << "moves"
+		<< std::setw(12) << "speedup" << "\n";
+
+	for (auto size : SCRAMBLE_SIZES) {
+		CubeScrambler scrambler(size, CUBE_SOLVER_SEED);
+		CubeState state(size);
+
+		auto uniformTime = MeasureMilliseconds(SCRAMBLE_STATES, [&]() { scrambler.Generate(state); });
+
+		// Random moves of rand() as the scene used to do, they need many moves per layer to mix the cube
+		srand(CUBE_SOLVER_SEED);
+		auto movesTime = MeasureMilliseconds(SCRAMBLE_STATES, [&]() {
+			state.Reset(size);
+			for (auto i = 0u; i < RANDOM_MOVES_PER_LAYER * size; i++) {
+				state.RotateLayer(static_cast<CubeState::Axis>(rand() % 3), rand() % size, rand() % 2 == 0);
+			}
+		});
+
+		out << std::setw(8) << size << std::fixed << std::setprecision(1)
+			<< std::setw(12) << 1.0 / uniformTime << std::setw(12) << 1.0 / movesTime
+			<< std::setprecision(2) << std::setw(12) << movesTime / uniformTime << "\n";
+	}
+}
+
+bool Benchmark::Run(const std::string& name, std::ostream& out)
+{
+	static const std::vector<std::pair<std::string, std::function<void(std::ostream&)>>> benchmarks = {
+		{ "obj", ObjParsers },
+		{ "obj-large", LargeObjParser },
+		{ "cube", RubikCubeSizes },
+		{ "cube-draw", RubikCubeDrawCpu },
+		{ "cube-moves", CubeMoves },
+		{ "cube-batch", CubeBatchMoves },
+		{ "cube-solver", CubeSolverTimes },
+		{ "cube-solver-parallel", CubeSolverScaling },
+		{ "cube-reduction", ReductionSolverSizes },
+		{ "cube-pocket", PocketCubeSolverTable },
+		{ "cube-scramble", CubeScrambles },
+	};
+
+	auto found = false;
+
+	for (const auto& benchmark : benchmarks) {
+		if (name == "all" || name == benchmark.first) {
+			benchmark.second(out);
+			out << std::endl;
+			found = true;
+		}
+	}
+
+	return found;
+}
@@ -0,0 +1,52 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <ostream>
+
+// Offline benchmarks, run with "AnimatedScene.exe --benchmark <name>"
+// GL benchmarks create their own hidden window, the others need no OpenGL context
+namespace Benchmark {
+
+	// Compare iostream and memory mapped .obj parsers on all meshes in Data/
+	void ObjParsers(std::ostream& out);
+
+	// Compare sequential and multi-threaded parsing of a large synthetic .obj file
+	void LargeObjParser(std::ostream& out);
+
+	// Measure frame time of rotating Rubik's cubes from 3x3 up to 256x256
+	// State texture stickers against per sticker instances
+	void RubikCubeSizes(std::ostream& out);
+
+	// CPU time of updating and drawing 3x3 and 15x15 cubes while their layers rotate
+	void RubikCubeDrawCpu(std::ostream& out);
+
+	// Compare generic line cycle moves with compile time specialized move tables of 2x2 to 5x5 cubes
+	void CubeMoves(std::ostream& out);
+
+	// Throughput of many cubes moved one by one and in structure of arrays batch
+	void CubeBatchMoves(std::ostream& out);
+
+	// Time of two-phase solver on fixed set of scrambled 3x3 cubes, milliseconds per solve
+	// Solution length is the number of queued moves, half turns count twice
+	void CubeSolverTimes(std::ostream& out);
+
+	// Parallel solver on the same states with 1, 2, 4, ... up to all hardware threads
+	void CubeSolverScaling(std::ostream& out);
+
+	// Time and number of moves of reduction solver for 4x4 up to 15x15 cubes, milliseconds per solve
+	void ReductionSolverSizes(std::ostream& out);
+
+	// Build time of 2x2 distance table with 1, 2, 4, ... up to all hardware threads, it's size and mapping time
+	// Time and length of optimal solutions of random 2x2 states
+	void PocketCubeSolverTable(std::ostream& out);
+
+	// Throughput of uniformly random state generation against scrambles of 20 random moves per layer
+	void CubeScrambles(std::ostream& out);
+
+	// Run benchmark with given name ("all" runs every benchmark)
+	// Return false if there is no such benchmark
+	bool Run(const std::string& name, std::ostream& out);
+}
+
+#endif
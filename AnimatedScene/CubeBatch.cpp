@@ -0,0 +1,182 @@
+#include "CubeBatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+CubeBatch::CubeBatch(unsigned int numStickersEdge, size_t numCubes)
+	: m_numStickersEdge(numStickersEdge),
+	m_numCubes(numCubes),
+	m_numStickers(CubeState::NUM_FACES * numStickersEdge * numStickersEdge)
+{
+	if (numStickersEdge == 0 || numCubes == 0) {
+		throw std::runtime_error("Cube batch cannot be empty");
+	}
+
+	BuildMoves();
+	m_stickers.resize(m_numStickers * m_numCubes);
+	Reset();
+}
+
+void CubeBatch::BuildMoves()
+{
+	std::vector<uint32_t> table(m_numStickers);
+	size_t maxCount = 0;
+
+	// Moves are indexed as (axis * N + layer) * 2 + clockwise
+	for (auto axis = 0u; axis < 3; axis++) {
+		for (auto layer = 0u; layer < m_numStickersEdge; layer++) {
+			for (auto clockwise : { false, true }) {
+				CubeState::FillMoveTable(table, static_cast<CubeState::Axis>(axis), layer, clockwise, m_numStickersEdge);
+
+				MovePairs pairs{ m_targets.size(), 0 };
+
+				for (uint32_t i = 0; i < m_numStickers; i++) {
+					if (table[i] != i) {
+						m_targets.push_back(i);
+						m_sources.push_back(table[i]);
+						pairs.count++;
+					}
+				}
+
+				m_moves.push_back(pairs);
+				maxCount = std::max(maxCount, pairs.count);
+			}
+		}
+	}
+
+	m_buffer.resize(maxCount * m_numCubes);
+}
+
+void CubeBatch::Reset()
+{
+	for (size_t row = 0; row < m_numStickers; row++) {
+		auto color = static_cast<unsigned char>(row / (m_numStickersEdge * m_numStickersEdge));
+		std::memset(m_stickers.data() + row * m_numCubes, color, m_numCubes);
+	}
+}
+
+size_t CubeBatch::GetMoveIndex(const CubeState::Move& move) const
+{
+	if (move.layer >= m_numStickersEdge) {
+		throw std::runtime_error("Rotation layer is larger than number of stickers!");
+	}
+	return (move.axis * m_numStickersEdge + move.layer) * 2 + (move.clockwise ? 1 : 0);
+}
+
+CubeState CubeBatch::GetState(size_t cube) const
+{
+	CubeState state(m_numStickersEdge);
+
+	for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+		for (auto x = 0u; x < m_numStickersEdge; x++) {
+			for (auto y = 0u; y < m_numStickersEdge; y++) {
+				state.Set(static_cast<CubeState::Face>(face), x, y, Get(cube, static_cast<CubeState::Face>(face), x, y));
+			}
+		}
+	}
+	return state;
+}
+
+void CubeBatch::SetState(size_t cube, const CubeState& state)
+{
+	if (state.GetNumStickersPerEdge() != m_numStickersEdge) {
+		throw std::runtime_error("Cube state has different number of stickers per edge");
+	}
+
+	for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+		for (auto x = 0u; x < m_numStickersEdge; x++) {
+			for (auto y = 0u; y < m_numStickersEdge; y++) {
+				m_stickers[GetRow(static_cast<CubeState::Face>(face), x, y) * m_numCubes + cube] =
+					state.Get(static_cast<CubeState::Face>(face), x, y);
+			}
+		}
+	}
+}
+
+bool CubeBatch::IsSolved(size_t cube) const
+{
+	auto faceSize = m_numStickersEdge * m_numStickersEdge;
+
+	for (size_t row = 0; row < m_numStickers; row++) {
+		if (m_stickers[row * m_numCubes + cube] != m_stickers[(row - row % faceSize) * m_numCubes + cube]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void CubeBatch::RotateLayer(const CubeState::Move& move)
+{
+	auto& pairs = m_moves[GetMoveIndex(move)];
+	auto targets = m_targets.data() + pairs.offset;
+	auto sources = m_sources.data() + pairs.offset;
+	auto stickers = m_stickers.data();
+	auto buffer = m_buffer.data();
+
+	// Whole rows are gathered first, they overlap with targets
+	for (size_t k = 0; k < pairs.count; k++) {
+		std::memcpy(buffer + k * m_numCubes, stickers + sources[k] * m_numCubes, m_numCubes);
+	}
+	for (size_t k = 0; k < pairs.count; k++) {
+		std::memcpy(stickers + targets[k] * m_numCubes, buffer + k * m_numCubes, m_numCubes);
+	}
+}
+
+void CubeBatch::RotateLayers(const std::vector<CubeState::Move>& moves)
+{
+	for (const auto& move : moves) {
+		RotateLayer(move);
+	}
+}
+
+void CubeBatch::RotateEachLayer(const std::vector<CubeState::Move>& moves)
+{
+	if (moves.size() != m_numCubes) {
+		throw std::runtime_error("Every cube in batch needs exactly one move");
+	}
+
+	// Counting sort of cubes by their move, cubes of one move are then processed row by row
+	m_moveCubesOffsets.assign(m_moves.size() + 1, 0);
+	m_moveCubes.resize(m_numCubes);
+
+	for (const auto& move : moves) {
+		m_moveCubesOffsets[GetMoveIndex(move) + 1]++;
+	}
+	for (size_t i = 1; i < m_moveCubesOffsets.size(); i++) {
+		m_moveCubesOffsets[i] += m_moveCubesOffsets[i - 1];
+	}
+	for (size_t cube = 0; cube < m_numCubes; cube++) {
+		m_moveCubes[m_moveCubesOffsets[GetMoveIndex(moves[cube])]++] = cube;
+	}
+
+	auto stickers = m_stickers.data();
+	auto buffer = m_buffer.data();
+	size_t begin = 0;
+
+	for (size_t index = 0; index < m_moves.size(); index++) {
+		auto end = m_moveCubesOffsets[index];
+		auto cubes = m_moveCubes.data() + begin;
+		auto numCubes = end - begin;
+		auto& pairs = m_moves[index];
+		auto targets = m_targets.data() + pairs.offset;
+		auto sources = m_sources.data() + pairs.offset;
+
+		for (size_t k = 0; k < pairs.count; k++) {
+			auto source = stickers + sources[k] * m_numCubes;
+
+			for (size_t i = 0; i < numCubes; i++) {
+				buffer[k * numCubes + i] = source[cubes[i]];
+			}
+		}
+		for (size_t k = 0; k < pairs.count; k++) {
+			auto target = stickers + targets[k] * m_numCubes;
+
+			for (size_t i = 0; i < numCubes; i++) {
+				target[cubes[i]] = buffer[k * numCubes + i];
+			}
+		}
+
+		begin = end;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef CUBE_BATCH_H
+#define CUBE_BATCH_H
+
+#include "CubeState.h"
+
+#include <cstdint>
+#include <vector>
+
+// Many independent NxN cube states simulated at once, no OpenGL is needed
+// Stickers are stored as structure of arrays: row of sticker i holds it's color in every cube
+// One move then copies whole rows, the same move for all cubes runs at memory bandwidth
+// Move tables hold 36 * N^3 entries, the batch is meant for small cubes
+class CubeBatch final {
+private:
+
+	// Stickers changed by one move: row targets[k] gets previous row sources[k]
+	struct MovePairs {
+		size_t offset;
+		size_t count;
+	};
+
+	unsigned int m_numStickersEdge;
+	size_t m_numCubes;
+	size_t m_numStickers;
+
+	std::vector<MovePairs> m_moves;
+	std::vector<uint32_t> m_targets;
+	std::vector<uint32_t> m_sources;
+
+	std::vector<unsigned char> m_stickers;
+	std::vector<unsigned char> m_buffer;
+
+	// Cubes sorted by their move, used by different moves for each cube
+	std::vector<size_t> m_moveCubes;
+	std::vector<size_t> m_moveCubesOffsets;
+
+	void BuildMoves();
+
+	size_t GetMoveIndex(const CubeState::Move& move) const;
+	size_t GetRow(CubeState::Face face, unsigned int x, unsigned int y) const { return (face * m_numStickersEdge + x) * m_numStickersEdge + y; }
+
+public:
+
+	// All cubes are solved, every face has color of it's index
+	// May throw an exception if any of the sizes is zero
+	CubeBatch(unsigned int numStickersEdge, size_t numCubes);
+
+	unsigned int GetNumStickersPerEdge() const { return m_numStickersEdge; }
+	size_t GetNumCubes() const { return m_numCubes; }
+
+	// Solve all cubes
+	void Reset();
+
+	unsigned char Get(size_t cube, CubeState::Face face, unsigned int x, unsigned int y) const
+		{ return m_stickers[GetRow(face, x, y) * m_numCubes + cube]; }
+
+	// Copy of one cube, the state must have the same number of stickers per edge
+	CubeState GetState(size_t cube) const;
+	void SetState(size_t cube, const CubeState& state);
+
+	// Every face has single color
+	bool IsSolved(size_t cube) const;
+
+	// Apply the same move to all cubes
+	// May throw an exception if layer is not less than GetNumStickersPerEdge()
+	void RotateLayer(const CubeState::Move& move);
+
+	// Apply the same sequence of moves to all cubes
+	void RotateLayers(const std::vector<CubeState::Move>& moves);
+
+	// Apply moves[i] to cube i, there has to be GetNumCubes() moves
+	void RotateEachLayer(const std::vector<CubeState::Move>& moves);
+};
+
+#endif
\ No newline at end of file
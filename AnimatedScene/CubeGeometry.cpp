@@ -0,0 +1,107 @@
+#include "CubeGeometry.h"
+
+int CubeGeometry::GetCoordinate(const Vector& v, CubeState::Axis axis)
+{
+	return axis == CubeState::X_AXIS ? v.x : (axis == CubeState::Y_AXIS ? v.y : v.z);
+}
+
+void CubeGeometry::GetStickerGeometry(const Sticker& sticker, int extent, Vector& position, Vector& normal)
+{
+	auto a = 2 * static_cast<int>(sticker.x) - extent;
+	auto b = 2 * static_cast<int>(sticker.y) - extent;
+
+	switch (sticker.face) {
+	case CubeState::TOP:
+	default:
+		position = Vector{ a, extent, b };
+		normal = Vector{ 0, 1, 0 };
+		break;
+	case CubeState::BOTTOM:
+		position = Vector{ a, -extent, -b };
+		normal = Vector{ 0, -1, 0 };
+		break;
+	case CubeState::LEFT:
+		position = Vector{ -extent, a, b };
+		normal = Vector{ -1, 0, 0 };
+		break;
+	case CubeState::RIGHT:
+		position = Vector{ extent, -a, b };
+		normal = Vector{ 1, 0, 0 };
+		break;
+	case CubeState::FRONT:
+		position = Vector{ a, -b, extent };
+		normal = Vector{ 0, 0, 1 };
+		break;
+	case CubeState::BACK:
+		position = Vector{ a, b, -extent };
+		normal = Vector{ 0, 0, -1 };
+		break;
+	}
+}
+
+CubeGeometry::Sticker CubeGeometry::GetSticker(const Vector& position, const Vector& normal, int extent)
+{
+	CubeState::Face face;
+	int a;
+	int b;
+
+	if (normal.y != 0) {
+		face = normal.y > 0 ? CubeState::TOP : CubeState::BOTTOM;
+		a = position.x;
+		b = normal.y > 0 ? position.z : -position.z;
+	}
+	else if (normal.x != 0) {
+		face = normal.x > 0 ? CubeState::RIGHT : CubeState::LEFT;
+		a = normal.x > 0 ? -position.y : position.y;
+		b = position.z;
+	}
+	else {
+		face = normal.z > 0 ? CubeState::FRONT : CubeState::BACK;
+		a = position.x;
+		b = normal.z > 0 ? -position.y : position.y;
+	}
+	return Sticker{ face, static_cast<unsigned int>((a + extent) / 2), static_cast<unsigned int>((b + extent) / 2) };
+}
+
+CubeGeometry::Vector CubeGeometry::Rotate(const Vector& v, CubeState::Axis axis, int sign)
+{
+	switch (axis) {
+	case CubeState::X_AXIS:
+		return Vector{ v.x, -sign * v.z, sign * v.y };
+	case CubeState::Y_AXIS:
+		return Vector{ sign * v.z, v.y, -sign * v.x };
+	default:
+		return Vector{ -sign * v.y, sign * v.x, v.z };
+	}
+}
+
+CubeGeometry::Sticker CubeGeometry::MoveSticker(const Sticker& sticker, const CubeState::Move& move, unsigned int numStickersEdge)
+{
+	auto extent = static_cast<int>(numStickersEdge) - 1;
+	Vector position;
+	Vector normal;
+	GetStickerGeometry(sticker, extent, position, normal);
+
+	if (GetCoordinate(position, move.axis) != 2 * static_cast<int>(move.layer) - extent) {
+		return sticker;
+	}
+
+	auto sign = move.clockwise ? 1 : -1;
+	return GetSticker(Rotate(position, move.axis, sign), Rotate(normal, move.axis, sign), extent);
+}
+
+std::vector<CubeGeometry::Sticker> CubeGeometry::GetPieceStickers(const Vector& position, int extent)
+{
+	std::vector<Sticker> stickers;
+
+	for (auto axis : { CubeState::X_AXIS, CubeState::Y_AXIS, CubeState::Z_AXIS }) {
+		auto coordinate = GetCoordinate(position, axis);
+
+		if (coordinate == extent || coordinate == -extent) {
+			auto sign = coordinate > 0 ? 1 : -1;
+			Vector normal{ axis == CubeState::X_AXIS ? sign : 0, axis == CubeState::Y_AXIS ? sign : 0, axis == CubeState::Z_AXIS ? sign : 0 };
+			stickers.push_back(GetSticker(position, normal, extent));
+		}
+	}
+	return stickers;
+}
\ No newline at end of file
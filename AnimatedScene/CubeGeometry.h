@@ -0,0 +1,44 @@
+#ifndef CUBE_GEOMETRY_H
+#define CUBE_GEOMETRY_H
+
+#include "CubeState.h"
+
+#include <vector>
+
+// Stickers of NxN cube in space, same transformations of faces as RubikCube::DrawFace
+// Used to derive how layer moves carry pieces, no OpenGL is needed
+namespace CubeGeometry {
+
+	// Doubled coordinates, pieces of NxN cube are centered at -(N - 1), -(N - 3), ..., N - 1
+	struct Vector {
+		int x;
+		int y;
+		int z;
+	};
+
+	struct Sticker {
+		CubeState::Face face;
+		unsigned int x;
+		unsigned int y;
+
+		bool operator==(const Sticker& s) const { return face == s.face && x == s.x && y == s.y; }
+	};
+
+	int GetCoordinate(const Vector& v, CubeState::Axis axis);
+
+	// Position of the sticker's piece and the sticker's normal, extent is N - 1
+	void GetStickerGeometry(const Sticker& sticker, int extent, Vector& position, Vector& normal);
+
+	Sticker GetSticker(const Vector& position, const Vector& normal, int extent);
+
+	// Clockwise layer move rotates by right hand rule around it's axis, sign is -1 for counter clockwise
+	Vector Rotate(const Vector& v, CubeState::Axis axis, int sign);
+
+	// Where the move carries the sticker
+	Sticker MoveSticker(const Sticker& sticker, const CubeState::Move& move, unsigned int numStickersEdge);
+
+	// Stickers of piece at the position ordered by axes of their normals
+	std::vector<Sticker> GetPieceStickers(const Vector& position, int extent);
+}
+
+#endif
\ No newline at end of file
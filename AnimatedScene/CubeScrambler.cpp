@@ -0,0 +1,224 @@
+#include "CubeScrambler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <utility>
+
+namespace {
+	CubeGeometry::Vector GetNormal(const CubeGeometry::Sticker& sticker, int extent)
+	{
+		CubeGeometry::Vector position;
+		CubeGeometry::Vector normal;
+		CubeGeometry::GetStickerGeometry(sticker, extent, position, normal);
+		return normal;
+	}
+
+	int Determinant(const CubeGeometry::Vector& a, const CubeGeometry::Vector& b, const CubeGeometry::Vector& c)
+	{
+		return a.x * (b.y * c.z - b.z * c.y) - a.y * (b.x * c.z - b.z * c.x) + a.z * (b.x * c.y - b.y * c.x);
+	}
+}
+
+CubeScrambler::CubeScrambler(unsigned int numStickersEdge, uint64_t seed)
+	: m_numStickersEdge(numStickersEdge),
+	m_random(seed)
+{
+	std::iota(m_colors.begin(), m_colors.end(), static_cast<unsigned char>(0));
+
+	auto n = static_cast<int>(numStickersEdge);
+	auto extent = n - 1;
+
+	// Single piece of 1x1 cube has no orbit
+	if (n < 2) {
+		return;
+	}
+
+	std::vector<bool> visited(static_cast<size_t>(n) * n * n, false);
+
+	for (auto x = -extent; x <= extent; x += 2) {
+		for (auto y = -extent; y <= extent; y += 2) {
+			for (auto z = -extent; z <= extent; z += 2) {
+				auto surface = (std::abs(x) == extent || std::abs(y) == extent || std::abs(z) == extent);
+				auto index = (static_cast<size_t>(x + extent) / 2 * n + (y + extent) / 2) * n + (z + extent) / 2;
+
+				if (surface && !visited[index]) {
+					AddOrbit(CubeGeometry::Vector{ x, y, z }, visited);
+				}
+			}
+		}
+	}
+
+	for (const auto& orbit : m_orbits) {
+		m_permutations.emplace_back(orbit.slots.size());
+		m_orientations.emplace_back(orbit.slots.size(), 0u);
+	}
+}
+
+CubeScrambler::CubeScrambler(const CubeState& solvedState, uint64_t seed)
+	: CubeScrambler(solvedState.GetNumStickersPerEdge(), seed)
+{
+	// Color of the solved face is the color of any of its stickers
+	for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+		m_colors[face] = solvedState.Get(static_cast<CubeState::Face>(face), 0, 0);
+	}
+}
+
+void CubeScrambler::AddOrbit(const CubeGeometry::Vector& start, std::vector<bool>& visited)
+{
+	auto n = static_cast<int>(m_numStickersEdge);
+	auto extent = n - 1;
+	auto getIndex = [n, extent](const CubeGeometry::Vector& v) {
+		return (static_cast<size_t>(v.x + extent) / 2 * n + (v.y + extent) / 2) * n + (v.z + extent) / 2;
+	};
+
+	// Orbit of the position is it's image under all rotations of the whole cube
+	std::vector<CubeGeometry::Vector> positions(1, start);
+	visited[getIndex(start)] = true;
+
+	for (size_t i = 0; i < positions.size(); i++) {
+		for (auto axis : { CubeState::X_AXIS, CubeState::Y_AXIS, CubeState::Z_AXIS }) {
+			auto&& rotated = CubeGeometry::Rotate(positions[i], axis, 1);
+
+			if (!visited[getIndex(rotated)]) {
+				visited[getIndex(rotated)] = true;
+				positions.push_back(rotated);
+			}
+		}
+	}
+
+	auto numStickers = CubeGeometry::GetPieceStickers(start, extent).size();
+	auto numZeros = (start.x == 0 ? 1 : 0) + (start.y == 0 ? 1 : 0) + (start.z == 0 ? 1 : 0);
+	Orbit orbit;
+
+	if (numStickers == 3) {
+		orbit.type = OrbitType::CORNERS;
+	}
+	else if (numStickers == 2 && numZeros == 1) {
+		orbit.type = OrbitType::MIDDLE_EDGES;
+	}
+	else if (numStickers == 1 && numZeros == 2) {
+		orbit.type = OrbitType::FIXED;
+	}
+	else {
+		orbit.type = OrbitType::PIECES;
+	}
+
+	for (const auto& position : positions) {
+		auto&& stickers = CubeGeometry::GetPieceStickers(position, extent);
+
+		if (orbit.type == OrbitType::CORNERS) {
+			// Sticker on U or D face first, the others in the same rotational direction
+			std::rotate(stickers.begin(), stickers.begin() + 1, stickers.end());
+			if (Determinant(GetNormal(stickers[0], extent), GetNormal(stickers[1], extent), GetNormal(stickers[2], extent)) < 0) {
+				std::swap(stickers[1], stickers[2]);
+			}
+		}
+		else if (orbit.type == OrbitType::MIDDLE_EDGES) {
+			// Sticker on U or D face first, F or B face for edges between them
+			auto first = GetNormal(stickers[0], extent);
+			if (first.x != 0 || (first.z != 0 && GetNormal(stickers[1], extent).y != 0)) {
+				std::swap(stickers[0], stickers[1]);
+			}
+		}
+		else if (stickers.size() == 2) {
+			// Wing can't flip, moves keep handedness of it's stickers
+			if (Determinant(GetNormal(stickers[0], extent), GetNormal(stickers[1], extent), position) < 0) {
+				std::swap(stickers[0], stickers[1]);
+			}
+		}
+		orbit.slots.push_back(stickers);
+	}
+	m_orbits.push_back(std::move(orbit));
+}
+
+bool CubeScrambler::Shuffle(std::vector<unsigned int>& permutation)
+{
+	auto odd = false;
+	std::iota(permutation.begin(), permutation.end(), 0u);
+
+	for (auto i = static_cast<uint32_t>(permutation.size()); i > 1; i--) {
+		auto j = m_random.Below(i);
+
+		if (j != i - 1) {
+			std::swap(permutation[i - 1], permutation[j]);
+			odd = !odd;
+		}
+	}
+	return odd;
+}
+
+void CubeScrambler::Generate(CubeState& state)
+{
+	if (state.GetNumStickersPerEdge() != m_numStickersEdge) {
+		state.Reset(m_numStickersEdge);
+	}
+
+	// Single piece of 1x1 cube is never moved
+	if (m_orbits.empty()) {
+		for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+			state.Fill(static_cast<CubeState::Face>(face), m_colors[face]);
+		}
+		return;
+	}
+
+	auto cornerParity = false;
+	auto edgeParity = false;
+	std::vector<unsigned int>* edgePermutation = nullptr;
+
+	for (size_t i = 0; i < m_orbits.size(); i++) {
+		auto type = m_orbits[i].type;
+		auto& permutation = m_permutations[i];
+		auto& orientations = m_orientations[i];
+
+		if (type == OrbitType::FIXED) {
+			std::iota(permutation.begin(), permutation.end(), 0u);
+			continue;
+		}
+
+		auto parity = Shuffle(permutation);
+
+		if (type == OrbitType::PIECES) {
+			continue;
+		}
+
+		// Orientation of the last piece is given by the others
+		auto numOrientations = (type == OrbitType::CORNERS) ? 3u : 2u;
+		auto sum = 0u;
+
+		for (size_t slot = 0; slot + 1 < orientations.size(); slot++) {
+			orientations[slot] = m_random.Below(numOrientations);
+			sum += orientations[slot];
+		}
+		orientations.back() = (numOrientations - sum % numOrientations) % numOrientations;
+
+		if (type == OrbitType::CORNERS) {
+			cornerParity = parity;
+		}
+		else {
+			edgeParity = parity;
+			edgePermutation = &permutation;
+		}
+	}
+
+	// Corners and middle edges of odd cubes are swapped by the same face turns
+	if (edgePermutation && cornerParity != edgeParity) {
+		std::swap((*edgePermutation)[0], (*edgePermutation)[1]);
+	}
+
+	for (size_t i = 0; i < m_orbits.size(); i++) {
+		auto& slots = m_orbits[i].slots;
+		auto& permutation = m_permutations[i];
+		auto& orientations = m_orientations[i];
+
+		for (size_t slot = 0; slot < slots.size(); slot++) {
+			auto& stickers = slots[slot];
+			auto& piece = slots[permutation[slot]];
+
+			for (size_t k = 0; k < stickers.size(); k++) {
+				auto& home = piece[(k + orientations[slot]) % stickers.size()];
+				state.Set(stickers[k].face, stickers[k].x, stickers[k].y, m_colors[home.face]);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef CUBE_SCRAMBLER_H
+#define CUBE_SCRAMBLER_H
+
+#include "CubeGeometry.h"
+#include "CubeState.h"
+#include "RandomGenerator.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Generator of uniformly random NxN cube states reachable by layer moves
+// Pieces are permuted and oriented directly, no moves are simulated, so any cube size is mixed at once
+// Corners and middle edges follow the 3x3 rules (twist, flip and permutation parity), centers of odd cubes stay,
+// edge wings and other centers are permuted freely (parity of wings and identical centers is never constrained)
+class CubeScrambler final {
+private:
+
+	enum class OrbitType {
+		CORNERS, // 3 orientations
+		MIDDLE_EDGES, // 2 orientations
+		PIECES, // edge wings and centers, orientation is given by the slot
+		FIXED, // centers of odd cubes
+	};
+
+	// Positions of interchangeable pieces
+	// Stickers of every slot are ordered, so that moves keep the order of piece's colors
+	struct Orbit {
+		OrbitType type;
+		std::vector<std::vector<CubeGeometry::Sticker>> slots;
+	};
+
+	unsigned int m_numStickersEdge;
+	std::vector<Orbit> m_orbits;
+	std::array<unsigned char, CubeState::NUM_FACES> m_colors;
+	RandomGenerator m_random;
+
+	// Slot i of the orbit gets piece of slot permutations[orbit][i] with orientation orientations[orbit][i]
+	std::vector<std::vector<unsigned int>> m_permutations;
+	std::vector<std::vector<unsigned int>> m_orientations;
+
+	void AddOrbit(const CubeGeometry::Vector& start, std::vector<bool>& visited);
+
+	// Fisher-Yates shuffle, return parity of the permutation
+	bool Shuffle(std::vector<unsigned int>& permutation);
+
+public:
+
+	// Colors of the solved cube are face indices as in the solved CubeState
+	CubeScrambler(unsigned int numStickersEdge = 3, uint64_t seed = 0);
+
+	// Size and colors of the solved cube are taken from given solved state
+	CubeScrambler(const CubeState& solvedState, uint64_t seed = 0);
+
+	CubeScrambler(const CubeScrambler&) = delete;
+	CubeScrambler& operator=(const CubeScrambler&) = delete;
+
+	unsigned int GetNumStickersPerEdge() const { return m_numStickersEdge; }
+
+	// Same seed gives the same sequence of states
+	void Seed(uint64_t seed) { m_random.Seed(seed); }
+
+	// Overwrite the state by random one, the state is resized to the scrambler's number of stickers per edge
+	// Every piece keeps colors of the solved cube, its faces have the colors of their home faces
+	void Generate(CubeState& state);
+};
+
+#endif
\ No newline at end of file
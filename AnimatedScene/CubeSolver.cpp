@@ -0,0 +1,987 @@
+#include "CubeSolver.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+	static_assert(sizeof(CubeSolverTablesHeader) == 16, "Solver tables header must stay packed");
+
+	const auto TABLES_PATH = "Data/CubeSolver.tables";
+
+	const unsigned int NUM_FACES = 6;
+	const unsigned int NUM_CORNERS = 8;
+	const unsigned int NUM_EDGES = 12;
+
+	// Faces in move order U, R, F, D, L, B, opposite faces are 3 apart
+	// Move m turns face m / 3 (m % 3 + 1) times clockwise (CubeState's direction)
+	const CubeState::Move FACE_MOVES[NUM_FACES] = {
+		{ CubeState::Y_AXIS, 2, true },
+		{ CubeState::X_AXIS, 2, true },
+		{ CubeState::Z_AXIS, 2, true },
+		{ CubeState::Y_AXIS, 0, true },
+		{ CubeState::X_AXIS, 0, true },
+		{ CubeState::Z_AXIS, 0, true },
+	};
+
+	// U, U2, U', R2, F2, D, D2, D', L2, B2
+	const unsigned int PHASE2_MOVES[CubeSolver::NUM_PHASE2_MOVES] = { 0, 1, 2, 4, 7, 9, 10, 11, 13, 16 };
+
+	// Table offsets in the file
+	const size_t TWIST_MOVES_OFFSET = sizeof(CubeSolverTablesHeader);
+	const size_t FLIP_MOVES_OFFSET = TWIST_MOVES_OFFSET + sizeof(uint16_t) * CubeSolver::NUM_TWISTS * CubeSolver::NUM_MOVES;
+	const size_t SLICE_MOVES_OFFSET = FLIP_MOVES_OFFSET + sizeof(uint16_t) * CubeSolver::NUM_FLIPS * CubeSolver::NUM_MOVES;
+	const size_t CORNER_PERMUTATION_MOVES_OFFSET = SLICE_MOVES_OFFSET + sizeof(uint16_t) * CubeSolver::NUM_SLICES * CubeSolver::NUM_MOVES;
+	const size_t EDGE_PERMUTATION_MOVES_OFFSET = CORNER_PERMUTATION_MOVES_OFFSET
+		+ sizeof(uint16_t) * CubeSolver::NUM_CORNER_PERMUTATIONS * CubeSolver::NUM_PHASE2_MOVES;
+	const size_t SLICE_PERMUTATION_MOVES_OFFSET = EDGE_PERMUTATION_MOVES_OFFSET
+		+ sizeof(uint16_t) * CubeSolver::NUM_EDGE_PERMUTATIONS * CubeSolver::NUM_PHASE2_MOVES;
+	const size_t SLICE_TWIST_DISTANCES_OFFSET = SLICE_PERMUTATION_MOVES_OFFSET
+		+ sizeof(uint16_t) * CubeSolver::NUM_SLICE_PERMUTATIONS * CubeSolver::NUM_PHASE2_MOVES;
+	const size_t SLICE_FLIP_DISTANCES_OFFSET = SLICE_TWIST_DISTANCES_OFFSET + CubeSolver::NUM_SLICES * CubeSolver::NUM_TWISTS;
+	const size_t SLICE_CORNER_DISTANCES_OFFSET = SLICE_FLIP_DISTANCES_OFFSET + CubeSolver::NUM_SLICES * CubeSolver::NUM_FLIPS;
+	const size_t SLICE_EDGE_DISTANCES_OFFSET = SLICE_CORNER_DISTANCES_OFFSET
+		+ CubeSolver::NUM_SLICE_PERMUTATIONS * CubeSolver::NUM_CORNER_PERMUTATIONS;
+	const size_t TABLES_SIZE = SLICE_EDGE_DISTANCES_OFFSET + CubeSolver::NUM_SLICE_PERMUTATIONS * CubeSolver::NUM_EDGE_PERMUTATIONS;
+
+	// Cube on the level of pieces: piece at position i and it's orientation
+	// Edges 8 - 11 belong into the UD slice (between U and D faces)
+	struct CubieCube {
+		std::array<uint8_t, NUM_CORNERS> cp;
+		std::array<uint8_t, NUM_CORNERS> co;
+		std::array<uint8_t, NUM_EDGES> ep;
+		std::array<uint8_t, NUM_EDGES> eo;
+	};
+
+	CubieCube GetSolvedCubie()
+	{
+		CubieCube cube = {};
+
+		for (auto i = 0u; i < NUM_CORNERS; i++) {
+			cube.cp[i] = static_cast<uint8_t>(i);
+		}
+		for (auto i = 0u; i < NUM_EDGES; i++) {
+			cube.ep[i] = static_cast<uint8_t>(i);
+		}
+		return cube;
+	}
+
+	// Cube a followed by moves of cube b
+	CubieCube Multiply(const CubieCube& a, const CubieCube& b)
+	{
+		CubieCube cube;
+
+		for (auto i = 0u; i < NUM_CORNERS; i++) {
+			cube.cp[i] = a.cp[b.cp[i]];
+			cube.co[i] = (a.co[b.cp[i]] + b.co[i]) % 3;
+		}
+		for (auto i = 0u; i < NUM_EDGES; i++) {
+			cube.ep[i] = a.ep[b.ep[i]];
+			cube.eo[i] = (a.eo[b.ep[i]] + b.eo[i]) % 2;
+		}
+		return cube;
+	}
+
+	struct Facelet {
+		CubeState::Face face;
+		unsigned int x;
+		unsigned int y;
+	};
+
+	// Facelets of every corner and edge position
+	// The first facelet of a corner lies on U or D face, the others follow in the same rotational direction
+	// The first facelet of an edge lies on U or D face, or on F or B face for the UD slice edges
+	struct CubieFacelets {
+		Facelet corners[NUM_CORNERS][3];
+		Facelet edges[NUM_EDGES][2];
+	};
+
+	struct Vector {
+		int x;
+		int y;
+		int z;
+
+		bool operator==(const Vector& v) const { return x == v.x && y == v.y && z == v.z; }
+	};
+
+	int Determinant(const Vector& a, const Vector& b, const Vector& c)
+	{
+		return a.x * (b.y * c.z - b.z * c.y) - a.y * (b.x * c.z - b.z * c.x) + a.z * (b.x * c.y - b.y * c.x);
+	}
+
+	// Piece position (coordinates -1, 0, 1) and normal of the sticker, same transformations as RubikCube::DrawFace
+	void GetFaceletGeometry(const Facelet& facelet, Vector& position, Vector& normal)
+	{
+		auto a = static_cast<int>(facelet.x) - 1;
+		auto b = static_cast<int>(facelet.y) - 1;
+
+		switch (facelet.face) {
+		case CubeState::TOP:
+		default:
+			position = Vector{ a, 1, b };
+			normal = Vector{ 0, 1, 0 };
+			break;
+		case CubeState::BOTTOM:
+			position = Vector{ a, -1, -b };
+			normal = Vector{ 0, -1, 0 };
+			break;
+		case CubeState::LEFT:
+			position = Vector{ -1, a, b };
+			normal = Vector{ -1, 0, 0 };
+			break;
+		case CubeState::RIGHT:
+			position = Vector{ 1, -a, b };
+			normal = Vector{ 1, 0, 0 };
+			break;
+		case CubeState::FRONT:
+			position = Vector{ a, -b, 1 };
+			normal = Vector{ 0, 0, 1 };
+			break;
+		case CubeState::BACK:
+			position = Vector{ a, b, -1 };
+			normal = Vector{ 0, 0, -1 };
+			break;
+		}
+	}
+
+	CubieFacelets BuildCubieFacelets()
+	{
+		struct Sticker {
+			Facelet facelet;
+			Vector position;
+			Vector normal;
+		};
+
+		std::vector<Sticker> stickers;
+
+		for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+			for (auto x = 0u; x < 3; x++) {
+				for (auto y = 0u; y < 3; y++) {
+					Sticker sticker{ Facelet{ static_cast<CubeState::Face>(face), x, y }, Vector{ 0, 0, 0 }, Vector{ 0, 0, 0 } };
+					GetFaceletGeometry(sticker.facelet, sticker.position, sticker.normal);
+					stickers.push_back(sticker);
+				}
+			}
+		}
+
+		// Stickers of the position, the one facing given axis first
+		auto getStickers = [&](const Vector& position) {
+			std::vector<Sticker> found;
+
+			for (const auto& sticker : stickers) {
+				if (sticker.position == position) {
+					found.push_back(sticker);
+				}
+			}
+			std::stable_partition(found.begin(), found.end(), [](const Sticker& s) { return s.normal.y != 0; });
+			std::stable_partition(found.begin() + 1, found.end(), [](const Sticker& s) { return s.normal.z != 0; });
+			return found;
+		};
+
+		CubieFacelets facelets;
+		auto corner = 0u;
+		auto edge = 0u;
+
+		for (auto y : { 1, -1 }) {
+			for (const auto& position : { Vector{ 1, y, 1 }, Vector{ -1, y, 1 }, Vector{ -1, y, -1 }, Vector{ 1, y, -1 } }) {
+				auto&& found = getStickers(position);
+
+				if (Determinant(found[0].normal, found[1].normal, found[2].normal) < 0) {
+					std::swap(found[1], found[2]);
+				}
+				for (auto i = 0; i < 3; i++) {
+					facelets.corners[corner][i] = found[i].facelet;
+				}
+				corner++;
+			}
+		}
+
+		for (auto y : { 1, -1 }) {
+			for (const auto& position : { Vector{ 1, y, 0 }, Vector{ 0, y, 1 }, Vector{ -1, y, 0 }, Vector{ 0, y, -1 } }) {
+				auto&& found = getStickers(position);
+				facelets.edges[edge][0] = found[0].facelet;
+				facelets.edges[edge][1] = found[1].facelet;
+				edge++;
+			}
+		}
+
+		for (const auto& position : { Vector{ 1, 0, 1 }, Vector{ -1, 0, 1 }, Vector{ -1, 0, -1 }, Vector{ 1, 0, -1 } }) {
+			auto&& found = getStickers(position);
+
+			// Slice edges have no U or D sticker, F or B one goes first
+			if (found[0].normal.z == 0) {
+				std::swap(found[0], found[1]);
+			}
+			facelets.edges[edge][0] = found[0].facelet;
+			facelets.edges[edge][1] = found[1].facelet;
+			edge++;
+		}
+
+		return facelets;
+	}
+
+	const CubieFacelets& GetCubieFacelets()
+	{
+		static const CubieFacelets facelets = BuildCubieFacelets();
+		return facelets;
+	}
+
+	// Permutation parity, 0 even
+	template<size_t N>
+	unsigned int GetParity(const std::array<uint8_t, N>& permutation)
+	{
+		auto parity = 0u;
+
+		for (size_t i = 0; i < N; i++) {
+			for (auto j = i + 1; j < N; j++) {
+				parity ^= permutation[i] > permutation[j] ? 1u : 0u;
+			}
+		}
+		return parity;
+	}
+
+	// May throw an exception if the state is not a valid 3x3 cube
+	CubieCube GetCubie(const CubeState& state)
+	{
+		if (state.GetNumStickersPerEdge() != 3) {
+			throw std::runtime_error("Only 3x3 cube can be solved");
+		}
+
+		// Colors are identified by the centers
+		std::array<int, 256> colorFaces;
+		colorFaces.fill(-1);
+
+		for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+			auto& colorFace = colorFaces[state.Get(static_cast<CubeState::Face>(face), 1, 1)];
+
+			if (colorFace >= 0) {
+				throw std::runtime_error("Invalid cube state: centers share a color");
+			}
+			colorFace = face;
+		}
+
+		auto getFace = [&](const Facelet& facelet) {
+			auto face = colorFaces[state.Get(facelet.face, facelet.x, facelet.y)];
+
+			if (face < 0) {
+				throw std::runtime_error("Invalid cube state: unknown sticker color");
+			}
+			return face;
+		};
+
+		auto& facelets = GetCubieFacelets();
+		CubieCube cube = {};
+		std::array<bool, NUM_CORNERS> usedCorners = {};
+		std::array<bool, NUM_EDGES> usedEdges = {};
+		auto twist = 0u;
+		auto flip = 0u;
+
+		for (auto position = 0u; position < NUM_CORNERS; position++) {
+			int faces[3] = { getFace(facelets.corners[position][0]), getFace(facelets.corners[position][1]), getFace(facelets.corners[position][2]) };
+			auto found = false;
+
+			for (auto corner = 0u; corner < NUM_CORNERS && !found; corner++) {
+				auto& home = facelets.corners[corner];
+
+				// Same stickers in the same rotational order
+				for (auto orientation = 0u; orientation < 3 && !found; orientation++) {
+					if (faces[orientation] == home[0].face && faces[(orientation + 1) % 3] == home[1].face
+						&& faces[(orientation + 2) % 3] == home[2].face) {
+						cube.cp[position] = static_cast<uint8_t>(corner);
+						cube.co[position] = static_cast<uint8_t>(orientation);
+						found = !usedCorners[corner];
+						usedCorners[corner] = true;
+					}
+				}
+			}
+
+			if (!found) {
+				throw std::runtime_error("Invalid cube state: corner does not exist or repeats");
+			}
+			twist += cube.co[position];
+		}
+
+		for (auto position = 0u; position < NUM_EDGES; position++) {
+			int faces[2] = { getFace(facelets.edges[position][0]), getFace(facelets.edges[position][1]) };
+			auto found = false;
+
+			for (auto edge = 0u; edge < NUM_EDGES && !found; edge++) {
+				auto& home = facelets.edges[edge];
+
+				for (auto orientation = 0u; orientation < 2 && !found; orientation++) {
+					if (faces[orientation] == home[0].face && faces[1 - orientation] == home[1].face) {
+						cube.ep[position] = static_cast<uint8_t>(edge);
+						cube.eo[position] = static_cast<uint8_t>(orientation);
+						found = !usedEdges[edge];
+						usedEdges[edge] = true;
+					}
+				}
+			}
+
+			if (!found) {
+				throw std::runtime_error("Invalid cube state: edge does not exist or repeats");
+			}
+			flip += cube.eo[position];
+		}
+
+		if (twist % 3 != 0 || flip % 2 != 0 || GetParity(cube.cp) != GetParity(cube.ep)) {
+			throw std::runtime_error("Invalid cube state: twisted corner, flipped edge or swapped pieces");
+		}
+		return cube;
+	}
+
+	std::array<CubieCube, CubeSolver::NUM_MOVES> BuildMoveCubies()
+	{
+		std::array<CubieCube, CubeSolver::NUM_MOVES> moves;
+
+		for (auto face = 0u; face < NUM_FACES; face++) {
+			CubeState state;
+			state.RotateLayer(FACE_MOVES[face]);
+
+			auto&& quarter = GetCubie(state);
+			moves[face * 3] = quarter;
+			moves[face * 3 + 1] = Multiply(quarter, quarter);
+			moves[face * 3 + 2] = Multiply(moves[face * 3 + 1], quarter);
+		}
+		return moves;
+	}
+
+	const std::array<CubieCube, CubeSolver::NUM_MOVES>& GetMoveCubies()
+	{
+		static const auto moves = BuildMoveCubies();
+		return moves;
+	}
+
+	unsigned int GetBinomial(unsigned int n, unsigned int k)
+	{
+		if (k > n) {
+			return 0;
+		}
+
+		auto result = 1u;
+		for (auto i = 1u; i <= k; i++) {
+			result = result * (n - k + i) / i;
+		}
+		return result;
+	}
+
+	// Lehmer code of the permutation, values are compared only among themselves
+	template<size_t N>
+	unsigned int RankPermutation(const uint8_t* permutation)
+	{
+		auto rank = 0u;
+
+		for (size_t i = 0; i < N; i++) {
+			auto smaller = 0u;
+
+			for (auto j = i + 1; j < N; j++) {
+				smaller += permutation[j] < permutation[i] ? 1u : 0u;
+			}
+			rank = rank * static_cast<unsigned int>(N - i) + smaller;
+		}
+		return rank;
+	}
+
+	template<size_t N>
+	void UnrankPermutation(unsigned int rank, uint8_t* permutation, uint8_t base = 0)
+	{
+		unsigned int digits[N];
+
+		for (auto i = N; i-- > 0;) {
+			digits[i] = rank % static_cast<unsigned int>(N - i);
+			rank /= static_cast<unsigned int>(N - i);
+		}
+
+		std::vector<uint8_t> available(N);
+		for (size_t i = 0; i < N; i++) {
+			available[i] = static_cast<uint8_t>(base + i);
+		}
+		for (size_t i = 0; i < N; i++) {
+			permutation[i] = available[digits[i]];
+			available.erase(available.begin() + digits[i]);
+		}
+	}
+
+	unsigned int GetTwist(const CubieCube& cube)
+	{
+		auto twist = 0u;
+
+		for (auto i = 0u; i < NUM_CORNERS - 1; i++) {
+			twist = twist * 3 + cube.co[i];
+		}
+		return twist;
+	}
+
+	void SetTwist(CubieCube& cube, unsigned int twist)
+	{
+		auto sum = 0u;
+
+		for (auto i = NUM_CORNERS - 1; i-- > 0;) {
+			cube.co[i] = static_cast<uint8_t>(twist % 3);
+			sum += cube.co[i];
+			twist /= 3;
+		}
+		cube.co[NUM_CORNERS - 1] = static_cast<uint8_t>((3 - sum % 3) % 3);
+	}
+
+	unsigned int GetFlip(const CubieCube& cube)
+	{
+		auto flip = 0u;
+
+		for (auto i = 0u; i < NUM_EDGES - 1; i++) {
+			flip = flip * 2 + cube.eo[i];
+		}
+		return flip;
+	}
+
+	void SetFlip(CubieCube& cube, unsigned int flip)
+	{
+		auto sum = 0u;
+
+		for (auto i = NUM_EDGES - 1; i-- > 0;) {
+			cube.eo[i] = static_cast<uint8_t>(flip % 2);
+			sum += cube.eo[i];
+			flip /= 2;
+		}
+		cube.eo[NUM_EDGES - 1] = static_cast<uint8_t>(sum % 2);
+	}
+
+	// Positions of the UD slice edges regardless of their order, zero if they are in the slice
+	unsigned int GetSlice(const CubieCube& cube)
+	{
+		auto slice = 0u;
+		auto found = 0u;
+
+		for (auto j = NUM_EDGES; j-- > 0;) {
+			if (cube.ep[j] >= 8) {
+				slice += GetBinomial(NUM_EDGES - 1 - j, found + 1);
+				found++;
+			}
+		}
+		return slice;
+	}
+
+	void SetSlice(CubieCube& cube, unsigned int slice)
+	{
+		uint8_t sliceEdge = 8;
+		uint8_t otherEdge = 0;
+		auto remaining = 4u;
+
+		for (auto j = 0u; j < NUM_EDGES; j++) {
+			auto binomial = GetBinomial(NUM_EDGES - 1 - j, remaining);
+
+			if (remaining > 0 && slice >= binomial) {
+				cube.ep[j] = sliceEdge++;
+				slice -= binomial;
+				remaining--;
+			}
+			else {
+				cube.ep[j] = otherEdge++;
+			}
+		}
+	}
+
+	// Phase 2 coordinates, U and D edges stay in positions 0 - 7 and slice edges in 8 - 11
+	unsigned int GetCornerPermutation(const CubieCube& cube) { return RankPermutation<NUM_CORNERS>(cube.cp.data()); }
+	unsigned int GetEdgePermutation(const CubieCube& cube) { return RankPermutation<8>(cube.ep.data()); }
+	unsigned int GetSlicePermutation(const CubieCube& cube) { return RankPermutation<4>(cube.ep.data() + 8); }
+
+	// Breadth first search of distances from the solved state over pairs of coordinates
+	void FillDistances(uint8_t* distances,
+		unsigned int size1, const uint16_t* moves1,
+		unsigned int size2, const uint16_t* moves2,
+		unsigned int numMoves)
+	{
+		std::fill_n(distances, static_cast<size_t>(size1) * size2, uint8_t(0xFF));
+		distances[0] = 0;
+
+		std::vector<uint32_t> frontier(1, 0u);
+		std::vector<uint32_t> next;
+
+		for (uint8_t depth = 1; !frontier.empty(); depth++) {
+			next.clear();
+
+			for (auto index : frontier) {
+				auto coordinate1 = index / size2;
+				auto coordinate2 = index % size2;
+
+				for (auto move = 0u; move < numMoves; move++) {
+					auto neighbour = moves1[coordinate1 * numMoves + move] * size2 + moves2[coordinate2 * numMoves + move];
+
+					if (distances[neighbour] == 0xFF) {
+						distances[neighbour] = depth;
+						next.push_back(neighbour);
+					}
+				}
+			}
+			frontier.swap(next);
+		}
+	}
+
+	bool IsPhase2Move(unsigned int move)
+	{
+		auto face = move / 3;
+		return face == 0 || face == 3 || move % 3 == 1;
+	}
+
+	// Same face twice in a row, or opposite faces in both orders, are redundant
+	bool IsRedundant(unsigned int face, int lastFace)
+	{
+		return lastFace >= 0 && (static_cast<int>(face) == lastFace || static_cast<int>(face) + 3 == lastFace);
+	}
+
+	// Half turns are two quarter turns, counter-clockwise ones are single moves
+	void GetSolution(const std::vector<unsigned int>& faceTurns, std::vector<CubeState::Move>& solution)
+	{
+		solution.clear();
+
+		for (auto move : faceTurns) {
+			auto faceMove = FACE_MOVES[move / 3];
+			auto power = move % 3 + 1;
+
+			if (power == 3) {
+				faceMove.clockwise = false;
+				power = 1;
+			}
+			solution.insert(solution.end(), power, faceMove);
+		}
+	}
+}
+
+class CubeSolver::Search final {
+private:
+
+	const Tables& m_tables;
+	CubieCube m_cube;
+	unsigned int m_maxLength;
+	std::vector<unsigned int> m_moves;
+
+	// Order of this search among tasks of parallel search
+	const std::atomic<unsigned int>* m_bestKey;
+	unsigned int m_key;
+
+	// Another task found a solution in an earlier subtree
+	bool IsAborted() const { return m_bestKey != nullptr && m_bestKey->load(std::memory_order_relaxed) < m_key; }
+
+	bool Phase1(unsigned int twist, unsigned int flip, unsigned int slice, unsigned int togo, int lastFace)
+	{
+		if (togo == 0) {
+			// Phase 1 solutions ending by phase 2 move are found by the shorter ones
+			if (twist != 0 || flip != 0 || slice != 0 || (!m_moves.empty() && IsPhase2Move(m_moves.back()))) {
+				return false;
+			}
+			return StartPhase2();
+		}
+
+		for (auto move = 0u; move < NUM_MOVES && !IsAborted(); move++) {
+			if (IsRedundant(move / 3, lastFace)) {
+				continue;
+			}
+
+			auto newTwist = m_tables.twistMoves[twist * NUM_MOVES + move];
+			auto newFlip = m_tables.flipMoves[flip * NUM_MOVES + move];
+			auto newSlice = m_tables.sliceMoves[slice * NUM_MOVES + move];
+			auto distance = std::max(m_tables.sliceTwistDistances[newSlice * NUM_TWISTS + newTwist],
+				m_tables.sliceFlipDistances[newSlice * NUM_FLIPS + newFlip]);
+
+			if (distance >= togo) {
+				continue;
+			}
+
+			m_moves.push_back(move);
+			if (Phase1(newTwist, newFlip, newSlice, togo - 1, move / 3)) {
+				return true;
+			}
+			m_moves.pop_back();
+		}
+		return false;
+	}
+
+	bool StartPhase2()
+	{
+		auto cube = m_cube;
+		for (auto move : m_moves) {
+			cube = Multiply(cube, GetMoveCubies()[move]);
+		}
+
+		auto corner = GetCornerPermutation(cube);
+		auto edge = GetEdgePermutation(cube);
+		auto slice = GetSlicePermutation(cube);
+		auto phase1Length = static_cast<unsigned int>(m_moves.size());
+		auto lastFace = m_moves.empty() ? -1 : static_cast<int>(m_moves.back() / 3);
+		auto distance = std::max(m_tables.sliceCornerDistances[slice * NUM_CORNER_PERMUTATIONS + corner],
+			m_tables.sliceEdgeDistances[slice * NUM_EDGE_PERMUTATIONS + edge]);
+
+		for (unsigned int togo = distance; phase1Length + togo <= m_maxLength; togo++) {
+			if (Phase2(corner, edge, slice, togo, lastFace)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool Phase2(unsigned int corner, unsigned int edge, unsigned int slice, unsigned int togo, int lastFace)
+	{
+		if (togo == 0) {
+			return corner == 0 && edge == 0 && slice == 0;
+		}
+
+		for (auto index = 0u; index < NUM_PHASE2_MOVES && !IsAborted(); index++) {
+			auto move = PHASE2_MOVES[index];
+
+			if (IsRedundant(move / 3, lastFace)) {
+				continue;
+			}
+
+			auto newCorner = m_tables.cornerPermutationMoves[corner * NUM_PHASE2_MOVES + index];
+			auto newEdge = m_tables.edgePermutationMoves[edge * NUM_PHASE2_MOVES + index];
+			auto newSlice = m_tables.slicePermutationMoves[slice * NUM_PHASE2_MOVES + index];
+			auto distance = std::max(m_tables.sliceCornerDistances[newSlice * NUM_CORNER_PERMUTATIONS + newCorner],
+				m_tables.sliceEdgeDistances[newSlice * NUM_EDGE_PERMUTATIONS + newEdge]);
+
+			if (distance >= togo) {
+				continue;
+			}
+
+			m_moves.push_back(move);
+			if (Phase2(newCorner, newEdge, newSlice, togo - 1, move / 3)) {
+				return true;
+			}
+			m_moves.pop_back();
+		}
+		return false;
+	}
+
+public:
+
+	Search(const Tables& tables, const CubieCube& cube, unsigned int maxLength,
+		const std::atomic<unsigned int>* bestKey = nullptr, unsigned int key = 0)
+		: m_tables(tables),
+		m_cube(cube),
+		m_maxLength(maxLength),
+		m_bestKey(bestKey),
+		m_key(key)
+	{
+	}
+
+	// Iterative deepening of phase 1
+	bool Run()
+	{
+		for (auto togo = 0u; togo <= m_maxLength; togo++) {
+			if (Run({}, togo)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Phase 1 solutions of exactly prefix + togo face turns starting by given face turns
+	bool Run(const std::vector<unsigned int>& prefix, unsigned int togo)
+	{
+		auto twist = GetTwist(m_cube);
+		auto flip = GetFlip(m_cube);
+		auto slice = GetSlice(m_cube);
+
+		for (auto move : prefix) {
+			twist = m_tables.twistMoves[twist * NUM_MOVES + move];
+			flip = m_tables.flipMoves[flip * NUM_MOVES + move];
+			slice = m_tables.sliceMoves[slice * NUM_MOVES + move];
+		}
+
+		m_moves = prefix;
+		return Phase1(twist, flip, slice, togo, prefix.empty() ? -1 : static_cast<int>(prefix.back() / 3));
+	}
+
+	// Indices of face turns, valid after successful Run()
+	const std::vector<unsigned int>& GetMoves() const { return m_moves; }
+};
+
+std::string CubeSolver::GetDefaultTablesPath()
+{
+	return TABLES_PATH;
+}
+
+size_t CubeSolver::GetTablesSize()
+{
+	return TABLES_SIZE;
+}
+
+std::vector<char> CubeSolver::GenerateTables()
+{
+	std::vector<char> tables(TABLES_SIZE);
+	auto data = tables.data();
+
+	auto header = reinterpret_cast<CubeSolverTablesHeader*>(data);
+	header->magic = MAGIC;
+	header->version = VERSION;
+	header->size = TABLES_SIZE;
+
+	auto twistMoves = reinterpret_cast<uint16_t*>(data + TWIST_MOVES_OFFSET);
+	auto flipMoves = reinterpret_cast<uint16_t*>(data + FLIP_MOVES_OFFSET);
+	auto sliceMoves = reinterpret_cast<uint16_t*>(data + SLICE_MOVES_OFFSET);
+	auto cornerPermutationMoves = reinterpret_cast<uint16_t*>(data + CORNER_PERMUTATION_MOVES_OFFSET);
+	auto edgePermutationMoves = reinterpret_cast<uint16_t*>(data + EDGE_PERMUTATION_MOVES_OFFSET);
+	auto slicePermutationMoves = reinterpret_cast<uint16_t*>(data + SLICE_PERMUTATION_MOVES_OFFSET);
+
+	auto& moveCubies = GetMoveCubies();
+	auto cube = GetSolvedCubie();
+
+	// Phase 1 coordinates move by all face turns
+	for (auto twist = 0u; twist < NUM_TWISTS; twist++) {
+		SetTwist(cube, twist);
+		for (auto move = 0u; move < NUM_MOVES; move++) {
+			twistMoves[twist * NUM_MOVES + move] = static_cast<uint16_t>(GetTwist(Multiply(cube, moveCubies[move])));
+		}
+	}
+	for (auto flip = 0u; flip < NUM_FLIPS; flip++) {
+		SetFlip(cube, flip);
+		for (auto move = 0u; move < NUM_MOVES; move++) {
+			flipMoves[flip * NUM_MOVES + move] = static_cast<uint16_t>(GetFlip(Multiply(cube, moveCubies[move])));
+		}
+	}
+	for (auto slice = 0u; slice < NUM_SLICES; slice++) {
+		SetSlice(cube, slice);
+		for (auto move = 0u; move < NUM_MOVES; move++) {
+			sliceMoves[slice * NUM_MOVES + move] = static_cast<uint16_t>(GetSlice(Multiply(cube, moveCubies[move])));
+		}
+	}
+
+	// Phase 2 coordinates move only by phase 2 moves
+	cube = GetSolvedCubie();
+
+	for (auto corner = 0u; corner < NUM_CORNER_PERMUTATIONS; corner++) {
+		UnrankPermutation<NUM_CORNERS>(corner, cube.cp.data());
+		for (auto index = 0u; index < NUM_PHASE2_MOVES; index++) {
+			auto&& moved = Multiply(cube, moveCubies[PHASE2_MOVES[index]]);
+			cornerPermutationMoves[corner * NUM_PHASE2_MOVES + index] = static_cast<uint16_t>(GetCornerPermutation(moved));
+		}
+	}
+	for (auto edge = 0u; edge < NUM_EDGE_PERMUTATIONS; edge++) {
+		UnrankPermutation<8>(edge, cube.ep.data());
+		for (auto index = 0u; index < NUM_PHASE2_MOVES; index++) {
+			auto&& moved = Multiply(cube, moveCubies[PHASE2_MOVES[index]]);
+			edgePermutationMoves[edge * NUM_PHASE2_MOVES + index] = static_cast<uint16_t>(GetEdgePermutation(moved));
+		}
+	}
+
+	cube = GetSolvedCubie();
+
+	for (auto slice = 0u; slice < NUM_SLICE_PERMUTATIONS; slice++) {
+		UnrankPermutation<4>(slice, cube.ep.data() + 8, 8);
+		for (auto index = 0u; index < NUM_PHASE2_MOVES; index++) {
+			auto&& moved = Multiply(cube, moveCubies[PHASE2_MOVES[index]]);
+			slicePermutationMoves[slice * NUM_PHASE2_MOVES + index] = static_cast<uint16_t>(GetSlicePermutation(moved));
+		}
+	}
+
+	// Phase 2 moves are the first ones in the order of phase 2 move tables
+	std::vector<uint16_t> slicePhase2Moves(NUM_SLICES * NUM_PHASE2_MOVES);
+	for (auto slice = 0u; slice < NUM_SLICES; slice++) {
+		for (auto index = 0u; index < NUM_PHASE2_MOVES; index++) {
+			slicePhase2Moves[slice * NUM_PHASE2_MOVES + index] = sliceMoves[slice * NUM_MOVES + PHASE2_MOVES[index]];
+		}
+	}
+
+	FillDistances(reinterpret_cast<uint8_t*>(data + SLICE_TWIST_DISTANCES_OFFSET),
+		NUM_SLICES, sliceMoves, NUM_TWISTS, twistMoves, NUM_MOVES);
+	FillDistances(reinterpret_cast<uint8_t*>(data + SLICE_FLIP_DISTANCES_OFFSET),
+		NUM_SLICES, sliceMoves, NUM_FLIPS, flipMoves, NUM_MOVES);
+	FillDistances(reinterpret_cast<uint8_t*>(data + SLICE_CORNER_DISTANCES_OFFSET),
+		NUM_SLICE_PERMUTATIONS, slicePermutationMoves, NUM_CORNER_PERMUTATIONS, cornerPermutationMoves, NUM_PHASE2_MOVES);
+	FillDistances(reinterpret_cast<uint8_t*>(data + SLICE_EDGE_DISTANCES_OFFSET),
+		NUM_SLICE_PERMUTATIONS, slicePermutationMoves, NUM_EDGE_PERMUTATIONS, edgePermutationMoves, NUM_PHASE2_MOVES);
+
+	return tables;
+}
+
+bool CubeSolver::WriteTables(const std::string& tablesPath, const std::vector<char>& tables)
+{
+	auto temporaryPath = Utils::GetTemporaryPath(tablesPath);
+
+	try {
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			file.write(tables.data(), tables.size());
+
+			if (!file.good()) {
+				throw std::runtime_error("Unable to write solver tables: " + temporaryPath);
+			}
+		}
+
+		// Never leave half-written tables behind
+		std::filesystem::rename(temporaryPath, tablesPath);
+		return true;
+	}
+	catch (const std::exception&) {
+		std::error_code error;
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+}
+
+std::unique_ptr<MappedFile> CubeSolver::OpenTables(const std::string& tablesPath)
+{
+	std::error_code error;
+
+	if (!std::filesystem::exists(tablesPath, error)) {
+		return nullptr;
+	}
+
+	try {
+		auto file = std::make_unique<MappedFile>(tablesPath);
+
+		if (file->GetSize() != TABLES_SIZE) {
+			return nullptr;
+		}
+
+		auto header = reinterpret_cast<const CubeSolverTablesHeader*>(file->GetData());
+
+		if (header->magic != MAGIC || header->version != VERSION || header->size != TABLES_SIZE) {
+			return nullptr;
+		}
+		return file;
+	}
+	catch (const std::exception&) {
+		// Unreadable tables are as good as no tables
+		return nullptr;
+	}
+}
+
+void CubeSolver::SetTables(const char* data)
+{
+	m_tables.twistMoves = reinterpret_cast<const uint16_t*>(data + TWIST_MOVES_OFFSET);
+	m_tables.flipMoves = reinterpret_cast<const uint16_t*>(data + FLIP_MOVES_OFFSET);
+	m_tables.sliceMoves = reinterpret_cast<const uint16_t*>(data + SLICE_MOVES_OFFSET);
+	m_tables.cornerPermutationMoves = reinterpret_cast<const uint16_t*>(data + CORNER_PERMUTATION_MOVES_OFFSET);
+	m_tables.edgePermutationMoves = reinterpret_cast<const uint16_t*>(data + EDGE_PERMUTATION_MOVES_OFFSET);
+	m_tables.slicePermutationMoves = reinterpret_cast<const uint16_t*>(data + SLICE_PERMUTATION_MOVES_OFFSET);
+	m_tables.sliceTwistDistances = reinterpret_cast<const uint8_t*>(data + SLICE_TWIST_DISTANCES_OFFSET);
+	m_tables.sliceFlipDistances = reinterpret_cast<const uint8_t*>(data + SLICE_FLIP_DISTANCES_OFFSET);
+	m_tables.sliceCornerDistances = reinterpret_cast<const uint8_t*>(data + SLICE_CORNER_DISTANCES_OFFSET);
+	m_tables.sliceEdgeDistances = reinterpret_cast<const uint8_t*>(data + SLICE_EDGE_DISTANCES_OFFSET);
+}
+
+CubeSolver::CubeSolver(const std::string& tablesPath)
+	: m_generated(false)
+{
+	m_file = OpenTables(tablesPath);
+
+	if (!m_file) {
+		m_buffer = GenerateTables();
+		m_generated = true;
+
+		// Generated tables stay in memory if they cannot be written, the next run generates them again
+		if (WriteTables(tablesPath, m_buffer)) {
+			m_file = OpenTables(tablesPath);
+		}
+	}
+
+	if (m_file) {
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+		SetTables(m_file->GetData());
+	}
+	else {
+		SetTables(m_buffer.data());
+	}
+}
+
+bool CubeSolver::Solve(const CubeState& state, std::vector<CubeState::Move>& solution, unsigned int maxLength) const
+{
+	Search search(m_tables, GetCubie(state), maxLength);
+	solution.clear();
+
+	if (!search.Run()) {
+		return false;
+	}
+	GetSolution(search.GetMoves(), solution);
+	return true;
+}
+
+bool CubeSolver::Solve(const CubeState& state, std::vector<CubeState::Move>& solution, TaskPool& pool, unsigned int maxLength) const
+{
+	static const unsigned int NO_KEY = ~0u;
+
+	auto&& cube = GetCubie(state);
+	auto twist = GetTwist(cube);
+	auto flip = GetFlip(cube);
+	auto slice = GetSlice(cube);
+	solution.clear();
+
+	auto getDistance = [this](unsigned int twist, unsigned int flip, unsigned int slice) {
+		return std::max(m_tables.sliceTwistDistances[slice * NUM_TWISTS + twist], m_tables.sliceFlipDistances[slice * NUM_FLIPS + flip]);
+	};
+
+	for (auto togo = 0u; togo <= maxLength; togo++) {
+		// Shallow iterations are not worth splitting
+		if (togo < PARALLEL_SPLIT_DEPTH) {
+			Search search(m_tables, cube, maxLength);
+
+			if (search.Run({}, togo)) {
+				GetSolution(search.GetMoves(), solution);
+				return true;
+			}
+			continue;
+		}
+
+		// Subtree key is given by it's first two face turns, sequential search visits smaller keys first
+		// Smallest key with a solution is the bound, subtrees with larger keys stop searching
+		std::atomic<unsigned int> bestKey(NO_KEY);
+		std::vector<std::vector<unsigned int>> solutions(NUM_MOVES * NUM_MOVES);
+
+		auto searchSubtree = [&, togo](unsigned int first, unsigned int second) {
+			auto key = first * NUM_MOVES + second;
+			Search search(m_tables, cube, maxLength, &bestKey, key);
+
+			if (!search.Run({ first, second }, togo - PARALLEL_SPLIT_DEPTH)) {
+				return;
+			}
+
+			solutions[key] = search.GetMoves();
+
+			auto best = bestKey.load();
+			while (key < best && !bestKey.compare_exchange_weak(best, key)) {
+			}
+		};
+
+		// Tasks of the first face turns submit subtasks of the second ones, idle workers steal them
+		// Worker takes it's newest task, submitting in reverse keeps the sequential order
+		for (auto first = NUM_MOVES; first-- > 0;) {
+			auto firstTwist = m_tables.twistMoves[twist * NUM_MOVES + first];
+			auto firstFlip = m_tables.flipMoves[flip * NUM_MOVES + first];
+			auto firstSlice = m_tables.sliceMoves[slice * NUM_MOVES + first];
+
+			if (getDistance(firstTwist, firstFlip, firstSlice) >= togo) {
+				continue;
+			}
+
+			pool.Submit([&, togo, first, firstTwist, firstFlip, firstSlice]() {
+				for (auto second = NUM_MOVES; second-- > 0;) {
+					if (IsRedundant(second / 3, first / 3) || bestKey.load(std::memory_order_relaxed) < first * NUM_MOVES + second) {
+						continue;
+					}
+
+					auto secondTwist = m_tables.twistMoves[firstTwist * NUM_MOVES + second];
+					auto secondFlip = m_tables.flipMoves[firstFlip * NUM_MOVES + second];
+					auto secondSlice = m_tables.sliceMoves[firstSlice * NUM_MOVES + second];
+
+					if (getDistance(secondTwist, secondFlip, secondSlice) < togo - 1) {
+						pool.Submit([&searchSubtree, first, second]() { searchSubtree(first, second); });
+					}
+				}
+			});
+		}
+
+		pool.Wait();
+
+		if (bestKey != NO_KEY) {
+			GetSolution(solutions[bestKey], solution);
+			return true;
+		}
+	}
+	return false;
+}
\ No newline at end of file
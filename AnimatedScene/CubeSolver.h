@@ -0,0 +1,107 @@
+#ifndef CUBE_SOLVER_H
+#define CUBE_SOLVER_H
+
+#include "CubeState.h"
+#include "MappedFile.h"
+#include "TaskPool.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Header of binary solver tables file, move tables (uint16_t) and then pruning tables (uint8_t) follow
+struct CubeSolverTablesHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;
+};
+
+// Kociemba's two-phase solver of 3x3 cube
+// Phase 1 brings the cube into <U, D, R2, L2, F2, B2> subgroup, phase 2 solves it within the subgroup
+// Move and pruning tables are generated once, written to disk and memory mapped on later runs
+class CubeSolver final {
+public:
+
+	static constexpr uint32_t MAGIC = 0x53435341u; // "ASCS"
+	static constexpr uint32_t VERSION = 1u;
+
+	static constexpr unsigned int NUM_MOVES = 18; // 6 faces x 3 powers
+	static constexpr unsigned int NUM_PHASE2_MOVES = 10;
+
+	static constexpr unsigned int NUM_TWISTS = 2187; // 3^7 corner orientations
+	static constexpr unsigned int NUM_FLIPS = 2048; // 2^11 edge orientations
+	static constexpr unsigned int NUM_SLICES = 495; // 12 choose 4 positions of UD slice edges
+	static constexpr unsigned int NUM_CORNER_PERMUTATIONS = 40320; // 8!
+	static constexpr unsigned int NUM_EDGE_PERMUTATIONS = 40320; // 8! of U and D edges
+	static constexpr unsigned int NUM_SLICE_PERMUTATIONS = 24; // 4!
+
+	static constexpr unsigned int DEFAULT_MAX_LENGTH = 22;
+
+	// Parallel search splits phase 1 by the first two face turns
+	static constexpr unsigned int PARALLEL_SPLIT_DEPTH = 2;
+
+private:
+
+	// Table pointers into the mapped file (or the generated buffer)
+	struct Tables {
+		const uint16_t* twistMoves;
+		const uint16_t* flipMoves;
+		const uint16_t* sliceMoves;
+		const uint16_t* cornerPermutationMoves;
+		const uint16_t* edgePermutationMoves;
+		const uint16_t* slicePermutationMoves;
+		const uint8_t* sliceTwistDistances;
+		const uint8_t* sliceFlipDistances;
+		const uint8_t* sliceCornerDistances;
+		const uint8_t* sliceEdgeDistances;
+	};
+
+	// IDA* search of one solve call
+	class Search;
+
+	std::unique_ptr<MappedFile> m_file;
+	std::vector<char> m_buffer;
+	Tables m_tables;
+	bool m_generated;
+
+	static size_t GetTablesSize();
+
+	// Generate all tables into the buffer (header included)
+	static std::vector<char> GenerateTables();
+
+	// Return false if the tables cannot be written, it's not fatal
+	static bool WriteTables(const std::string& tablesPath, const std::vector<char>& tables);
+
+	// Return nullptr if there are no tables or if they are stale
+	static std::unique_ptr<MappedFile> OpenTables(const std::string& tablesPath);
+
+	void SetTables(const char* data);
+
+public:
+
+	// Tables file next to the mesh caches
+	static std::string GetDefaultTablesPath();
+
+	// Map tables from given file, generate (and write) them if the file is missing or stale
+	CubeSolver(const std::string& tablesPath = GetDefaultTablesPath());
+
+	CubeSolver(const CubeSolver&) = delete;
+	CubeSolver& operator=(const CubeSolver&) = delete;
+
+	// True if the tables were generated by this instance, not mapped from disk
+	bool WereTablesGenerated() const { return m_generated; }
+
+	// Solve 3x3 state by turns of the outer layers, half turns are two moves of the solution
+	// Centers may be anywhere (middle layer moves), the cube is solved relative to them
+	// Return false if there is no solution of at most maxLength face turns
+	// May throw an exception if the state is not a valid 3x3 cube
+	bool Solve(const CubeState& state, std::vector<CubeState::Move>& solution, unsigned int maxLength = DEFAULT_MAX_LENGTH) const;
+
+	// Same as above with the search tree split into tasks of the pool, the solution is the same
+	// Task of the earliest subtree with a solution wins, later subtrees stop searching
+	bool Solve(const CubeState& state, std::vector<CubeState::Move>& solution, TaskPool& pool,
+		unsigned int maxLength = DEFAULT_MAX_LENGTH) const;
+};
+
+#endif
\ No newline at end of file
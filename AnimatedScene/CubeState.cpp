@@ -0,0 +1,130 @@
+#include "CubeState.h"
+#include "FixedCubeState.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+CubeState::CubeState(unsigned int numStickersEdge, bool specialized)
+	: m_specialized(specialized)
+{
+	Reset(numStickersEdge);
+}
+
+void CubeState::Reset(unsigned int numStickersEdge)
+{
+	if (numStickersEdge == 0) {
+		throw std::runtime_error("Number of stickers per edge cannot be zero");
+	}
+
+	m_numStickersEdge = numStickersEdge;
+	m_stickers.assign(NUM_FACES * numStickersEdge * numStickersEdge, 0);
+	m_stickers.shrink_to_fit();
+
+	for (auto face = 0u; face < NUM_FACES; face++) {
+		Fill(static_cast<Face>(face), static_cast<unsigned char>(face));
+	}
+}
+
+void CubeState::Fill(Face face, unsigned char color)
+{
+	auto faceSize = m_numStickersEdge * m_numStickersEdge;
+	std::fill_n(m_stickers.begin() + face * faceSize, faceSize, color);
+	m_orientations[face] = 0;
+}
+
+size_t CubeState::GetStorageIndex(Face face, unsigned int x, unsigned int y) const
+{
+	MapToStorage(m_orientations[face], m_numStickersEdge - 1, x, y);
+	return (static_cast<size_t>(face) * m_numStickersEdge + x) * m_numStickersEdge + y;
+}
+
+CubeState::Line CubeState::GetLine(const FaceLine& line) const
+{
+	auto start = GetStorageIndex(line.face, line.x, line.y);
+
+	if (m_numStickersEdge == 1) {
+		return Line{ start, 0 };
+	}
+
+	// Orientation keeps lines straight, second sticker gives the step
+	auto next = GetStorageIndex(line.face, line.x + line.dx, line.y + line.dy);
+	return Line{ start, static_cast<ptrdiff_t>(next) - static_cast<ptrdiff_t>(start) };
+}
+
+void CubeState::CycleLines(const Line& a, const Line& b, const Line& c, const Line& d)
+{
+	auto stickers = m_stickers.data();
+
+	for (ptrdiff_t k = 0; k < static_cast<ptrdiff_t>(m_numStickersEdge); k++) {
+		auto& ca = stickers[a.start + k * a.step];
+		auto& cb = stickers[b.start + k * b.step];
+		auto& cc = stickers[c.start + k * c.step];
+		auto& cd = stickers[d.start + k * d.step];
+
+		auto tmp = ca;
+		ca = cb;
+		cb = cc;
+		cc = cd;
+		cd = tmp;
+	}
+}
+
+void CubeState::TurnFace(Face face, bool clockwise)
+{
+	m_orientations[face] = (m_orientations[face] + (clockwise ? 1 : 3)) & 3;
+}
+
+void CubeState::RotateLayer(Axis axis, unsigned int layer, bool clockwise)
+{
+	if (layer >= m_numStickersEdge) {
+		throw std::runtime_error("Rotation layer is larger than number of stickers!");
+	}
+
+	if (HasMoveTables()) {
+		auto stickers = m_stickers.data();
+
+		switch (m_numStickersEdge) {
+		case 1:
+			FixedCubeState<1>::RotateStickers(stickers, axis, layer, clockwise);
+			return;
+		case 2:
+			FixedCubeState<2>::RotateStickers(stickers, axis, layer, clockwise);
+			return;
+		case 3:
+			FixedCubeState<3>::RotateStickers(stickers, axis, layer, clockwise);
+			return;
+		case 4:
+			FixedCubeState<4>::RotateStickers(stickers, axis, layer, clockwise);
+			return;
+		case 5:
+			FixedCubeState<5>::RotateStickers(stickers, axis, layer, clockwise);
+			return;
+		}
+	}
+
+	auto&& move = GetLayerMove(axis, layer, clockwise, m_numStickersEdge);
+
+	if (move.turnsFace) {
+		TurnFace(move.turnedFace, move.turnedClockwise);
+	}
+
+	CycleLines(GetLine(move.lines[0]), GetLine(move.lines[1]), GetLine(move.lines[2]), GetLine(move.lines[3]));
+}
+
+bool CubeState::operator==(const CubeState& state) const
+{
+	if (m_numStickersEdge != state.m_numStickersEdge) {
+		return false;
+	}
+
+	for (auto face = 0u; face < NUM_FACES; face++) {
+		for (auto x = 0u; x < m_numStickersEdge; x++) {
+			for (auto y = 0u; y < m_numStickersEdge; y++) {
+				if (Get(static_cast<Face>(face), x, y) != state.Get(static_cast<Face>(face), x, y)) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#ifndef CUBE_STATE_H
+#define CUBE_STATE_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Colors of all Rubik's cube stickers in one contiguous array, one byte per sticker
+// Face f occupies bytes [f * N * N, (f + 1) * N * N), sticker [x][y] of the face is at x * N + y
+// Small cubes move by compile time gather tables, faces always keep orientation 0 then
+// Larger cubes store faces unrotated, face turn only changes face's orientation, so every move is O(N)
+// No OpenGL is needed, the state can be simulated headless
+class CubeState final {
+public:
+
+	enum Face {
+		TOP = 0,
+		BOTTOM,
+		LEFT,
+		RIGHT,
+		FRONT,
+		BACK,
+		NUM_FACES
+	};
+
+	enum Axis {
+		X_AXIS = 0,
+		Y_AXIS,
+		Z_AXIS
+	};
+
+	// Map face's coordinates into it's storage for face turned orientation times clockwise
+	// Size is N - 1 for sticker indices or N for continuous coordinates (sticker corners)
+	template<typename T>
+	static constexpr void MapToStorage(unsigned int orientation, T size, T& x, T& y)
+	{
+		auto tmp = x;
+
+		switch (orientation & 3u) {
+		case 1:
+			x = size - y;
+			y = tmp;
+			break;
+		case 2:
+			x = size - x;
+			y = size - y;
+			break;
+		case 3:
+			x = y;
+			y = size - tmp;
+			break;
+		}
+	}
+
+	// Line of stickers starting at face's [x][y] going in (dx, dy) direction
+	struct FaceLine {
+		Face face;
+		unsigned int x;
+		unsigned int y;
+		int dx;
+		int dy;
+	};
+
+	// Rotation of one layer, same directions as RubikCube::Rotate
+	struct Move {
+		Axis axis;
+		unsigned int layer;
+		bool clockwise;
+	};
+
+	// Layer rotation: stickers shift lines[0] <- lines[1] <- lines[2] <- lines[3] <- lines[0]
+	// Outer layers also turn their face
+	struct LayerMove {
+		FaceLine lines[4];
+		bool turnsFace;
+		Face turnedFace;
+		bool turnedClockwise;
+	};
+
+	// Describe layer rotation of a cube with given number of stickers per edge
+	static constexpr LayerMove GetLayerMove(Axis axis, unsigned int layer, bool clockwise, unsigned int numStickersEdge)
+	{
+		auto last = numStickersEdge - 1;
+		auto i = layer;
+		LayerMove move{};
+
+		if (axis == X_AXIS) {
+			FaceLine back{ BACK, i, 0, 0, 1 };
+			FaceLine front{ FRONT, i, 0, 0, 1 };
+			move.lines[0] = FaceLine{ TOP, i, 0, 0, 1 };
+			move.lines[1] = clockwise ? back : front;
+			move.lines[2] = FaceLine{ BOTTOM, i, 0, 0, 1 };
+			move.lines[3] = clockwise ? front : back;
+			move.turnedFace = (i == 0) ? LEFT : RIGHT;
+		}
+		else if (axis == Y_AXIS) {
+			FaceLine left{ LEFT, i, 0, 0, 1 };
+			FaceLine right{ RIGHT, last - i, last, 0, -1 };
+			move.lines[0] = FaceLine{ FRONT, 0, last - i, 1, 0 };
+			move.lines[1] = clockwise ? left : right;
+			move.lines[2] = FaceLine{ BACK, last, i, -1, 0 };
+			move.lines[3] = clockwise ? right : left;
+			move.turnedFace = (i == 0) ? BOTTOM : TOP;
+		}
+		else {
+			FaceLine right{ RIGHT, 0, i, 1, 0 };
+			FaceLine left{ LEFT, 0, i, 1, 0 };
+			move.lines[0] = FaceLine{ TOP, 0, i, 1, 0 };
+			move.lines[1] = clockwise ? right : left;
+			move.lines[2] = FaceLine{ BOTTOM, last, last - i, -1, 0 };
+			move.lines[3] = clockwise ? left : right;
+			move.turnedFace = (i == 0) ? BACK : FRONT;
+		}
+
+		// First layer's face is seen from the other side
+		move.turnsFace = (i == 0 || i == last);
+		move.turnedClockwise = (i == 0) ? !clockwise : clockwise;
+		return move;
+	}
+
+	// Gather table of layer rotation of cube stored in canonical layout (orientation 0 of every face)
+	// Sticker i after the move is sticker table[i] before it, table has 6 * N * N entries
+	template<typename Table>
+	static constexpr void FillMoveTable(Table& table, Axis axis, unsigned int layer, bool clockwise, unsigned int numStickersEdge)
+	{
+		auto n = numStickersEdge;
+		auto getIndex = [n](Face face, unsigned int x, unsigned int y) { return (face * n + x) * n + y; };
+		auto move = GetLayerMove(axis, layer, clockwise, n);
+
+		for (auto i = 0u; i < NUM_FACES * n * n; i++) {
+			table[i] = i;
+		}
+
+		if (move.turnsFace) {
+			for (auto x = 0u; x < n; x++) {
+				for (auto y = 0u; y < n; y++) {
+					auto sourceX = x;
+					auto sourceY = y;
+					MapToStorage(move.turnedClockwise ? 1u : 3u, n - 1, sourceX, sourceY);
+					table[getIndex(move.turnedFace, x, y)] = getIndex(move.turnedFace, sourceX, sourceY);
+				}
+			}
+		}
+
+		for (auto k = 0; k < static_cast<int>(n); k++) {
+			unsigned int indices[4] = {};
+
+			for (auto j = 0; j < 4; j++) {
+				auto& line = move.lines[j];
+				indices[j] = getIndex(line.face, line.x + k * line.dx, line.y + k * line.dy);
+			}
+			for (auto j = 0; j < 4; j++) {
+				table[indices[j]] = indices[(j + 1) % 4];
+			}
+		}
+	}
+
+	// Cubes up to this size move by compile time gather tables, see FixedCubeState
+	static constexpr unsigned int MAX_TABLE_STICKERS_PER_LINE = 5;
+
+private:
+
+	// Stickers of one line in storage: start + k * step, k < N
+	struct Line {
+		size_t start;
+		ptrdiff_t step;
+	};
+
+	unsigned int m_numStickersEdge;
+	bool m_specialized;
+	std::vector<unsigned char> m_stickers;
+	std::array<unsigned char, NUM_FACES> m_orientations;
+
+	size_t GetStorageIndex(Face face, unsigned int x, unsigned int y) const;
+
+	Line GetLine(const FaceLine& line) const;
+
+	// Shift colors a <- b <- c <- d <- a
+	void CycleLines(const Line& a, const Line& b, const Line& c, const Line& d);
+
+	void TurnFace(Face face, bool clockwise);
+
+public:
+
+	// Specialized states of small cubes move by tables, generic ones always by line cycles
+	CubeState(unsigned int numStickersEdge = 3, bool specialized = true);
+
+	// Solved cube with given number of stickers per edge
+	// Every face has color of it's index
+	void Reset(unsigned int numStickersEdge);
+
+	unsigned int GetNumStickersPerEdge() const { return m_numStickersEdge; }
+
+	// Faces of table moved cubes never change their orientation, whole stickers are permuted instead
+	bool HasMoveTables() const { return m_specialized && m_numStickersEdge <= MAX_TABLE_STICKERS_PER_LINE; }
+
+	// Fill whole face with single color
+	void Fill(Face face, unsigned char color);
+
+	unsigned char Get(Face face, unsigned int x, unsigned int y) const { return m_stickers[GetStorageIndex(face, x, y)]; }
+	void Set(Face face, unsigned int x, unsigned int y, unsigned char color) { m_stickers[GetStorageIndex(face, x, y)] = color; }
+
+	// How many times is the face turned clockwise relative to it's storage (0 - 3)
+	unsigned int GetOrientation(Face face) const { return m_orientations[face]; }
+
+	// All stickers in storage order, 6 * N * N bytes
+	// The layout is canonical (every state has one) only if HasMoveTables()
+	const std::vector<unsigned char>& GetStickers() const { return m_stickers; }
+
+	// Unrotated stickers of the face, N * N bytes
+	const unsigned char* GetFaceStorage(Face face) const { return m_stickers.data() + face * m_numStickersEdge * m_numStickersEdge; }
+
+	// Rotate layer of the cube (same directions as RubikCube::Rotate)
+	// May throw an exception if layer is not less than GetNumStickersPerEdge()
+	void RotateLayer(Axis axis, unsigned int layer, bool clockwise);
+	void RotateLayer(const Move& move) { RotateLayer(move.axis, move.layer, move.clockwise); }
+
+	bool operator==(const CubeState& state) const;
+	bool operator!=(const CubeState& state) const { return !(*this == state); }
+};
+
+#endif
\ No newline at end of file
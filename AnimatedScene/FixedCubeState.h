@@ -0,0 +1,117 @@
+#ifndef FIXED_CUBE_STATE_H
+#define FIXED_CUBE_STATE_H
+
+#include "CubeState.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+// Gather tables of all layer rotations of NxN cube, generated at compile time
+// Sticker i after the move is sticker sources[move][i] before it
+template<unsigned int N>
+struct FixedCubeMoveTables {
+	static constexpr unsigned int NUM_STICKERS = CubeState::NUM_FACES * N * N;
+	static constexpr unsigned int NUM_MOVES = 3 * N * 2;
+
+	static_assert(N > 0 && NUM_STICKERS <= 256, "Sticker indices must fit into bytes");
+
+	std::array<std::array<unsigned char, NUM_STICKERS>, NUM_MOVES> sources;
+
+	static constexpr unsigned int GetIndex(CubeState::Face face, unsigned int x, unsigned int y) { return (face * N + x) * N + y; }
+
+	constexpr FixedCubeMoveTables()
+		: sources()
+	{
+		for (auto axis = 0u; axis < 3; axis++) {
+			for (auto layer = 0u; layer < N; layer++) {
+				for (auto direction = 0u; direction < 2; direction++) {
+					CubeState::FillMoveTable(sources[(axis * N + layer) * 2 + direction], static_cast<CubeState::Axis>(axis), layer, direction != 0, N);
+				}
+			}
+		}
+	}
+};
+
+// Rubik's cube state with number of stickers per edge known at compile time
+// Same canonical layout as CubeState of small cubes, every move is one fixed size gather
+// Lives on stack, meant for headless simulation and solving
+template<unsigned int N>
+class FixedCubeState final {
+public:
+
+	static constexpr unsigned int NUM_STICKERS = FixedCubeMoveTables<N>::NUM_STICKERS;
+
+	typedef std::array<unsigned char, NUM_STICKERS> Stickers;
+
+private:
+
+	static constexpr FixedCubeMoveTables<N> MOVE_TABLES{};
+
+	Stickers m_stickers;
+
+public:
+
+	// Rotate layer of cube stored in canonical layout
+	static void RotateStickers(unsigned char* stickers, CubeState::Axis axis, unsigned int layer, bool clockwise)
+	{
+		auto& sources = MOVE_TABLES.sources[(axis * N + layer) * 2 + (clockwise ? 1 : 0)];
+		Stickers moved;
+
+		for (auto i = 0u; i < NUM_STICKERS; i++) {
+			moved[i] = stickers[sources[i]];
+		}
+		std::copy(moved.begin(), moved.end(), stickers);
+	}
+
+	// Solved cube, every face has color of it's index
+	FixedCubeState() { Reset(); }
+
+	// May throw an exception if the state has different number of stickers per edge
+	explicit FixedCubeState(const CubeState& state)
+	{
+		if (state.GetNumStickersPerEdge() != N) {
+			throw std::runtime_error("Cube state has different number of stickers per edge");
+		}
+
+		for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+			for (auto x = 0u; x < N; x++) {
+				for (auto y = 0u; y < N; y++) {
+					Set(static_cast<CubeState::Face>(face), x, y, state.Get(static_cast<CubeState::Face>(face), x, y));
+				}
+			}
+		}
+	}
+
+	void Reset()
+	{
+		for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+			Fill(static_cast<CubeState::Face>(face), static_cast<unsigned char>(face));
+		}
+	}
+
+	static constexpr unsigned int GetNumStickersPerEdge() { return N; }
+
+	void Fill(CubeState::Face face, unsigned char color) { std::fill_n(m_stickers.begin() + face * N * N, N * N, color); }
+
+	unsigned char Get(CubeState::Face face, unsigned int x, unsigned int y) const { return m_stickers[FixedCubeMoveTables<N>::GetIndex(face, x, y)]; }
+	void Set(CubeState::Face face, unsigned int x, unsigned int y, unsigned char color) { m_stickers[FixedCubeMoveTables<N>::GetIndex(face, x, y)] = color; }
+
+	const Stickers& GetStickers() const { return m_stickers; }
+
+	// Rotate layer of the cube (same directions as RubikCube::Rotate)
+	// May throw an exception if layer is not less than N
+	void RotateLayer(CubeState::Axis axis, unsigned int layer, bool clockwise)
+	{
+		if (layer >= N) {
+			throw std::runtime_error("Rotation layer is larger than number of stickers!");
+		}
+		RotateStickers(m_stickers.data(), axis, layer, clockwise);
+	}
+	void RotateLayer(const CubeState::Move& move) { RotateLayer(move.axis, move.layer, move.clockwise); }
+
+	bool operator==(const FixedCubeState& state) const { return m_stickers == state.m_stickers; }
+	bool operator!=(const FixedCubeState& state) const { return m_stickers != state.m_stickers; }
+};
+
+#endif
\ No newline at end of file
@@ -5,6 +5,7 @@ out vec4 final_color;
 in vec3 vertex_position;
 in vec3 vertex_normal_vec;
 in vec2 vertex_texel;
+flat in int vertex_material_index;
 
 uniform vec3 eye_position;
 uniform sampler2D texture_sampler;
@@ -15,6 +16,27 @@ uniform vec3 material_diffuse_color;
 uniform vec3 material_specular_color;
 uniform float material_shininess;
 
+// material palette of instanced drawing
+#define MAX_PALETTE_MATERIALS 6
+
+uniform vec3 palette_ambient_colors[MAX_PALETTE_MATERIALS];
+uniform vec3 palette_diffuse_colors[MAX_PALETTE_MATERIALS];
+uniform vec3 palette_specular_colors[MAX_PALETTE_MATERIALS];
+uniform float palette_shininess[MAX_PALETTE_MATERIALS];
+
+// Rubik's cube stickers colored from state texture (palette indices)
+// Texel coordinates are in stickers, gaps between stickers use material uniforms
+#define STICKER_GAP 0.05
+
+uniform bool sticker_state;
+uniform usampler2D sticker_state_sampler;
+
+// material of this fragment, see select_material()
+vec3 fragment_ambient_color;
+vec3 fragment_diffuse_color;
+vec3 fragment_specular_color;
+float fragment_shininess;
+
 uniform int texture_type;
 
 // lights
@@ -68,11 +90,11 @@ void compute_normal_light(out vec3 light_color,
 
 	// blinn-phong model
 	float cosine_angle = max(dot(mid_eye_light_vec, vertex_normal_vec), 0.0);
-	float specular_intensity = pow(cosine_angle, material_shininess) * diffuse_intensity;
+	float specular_intensity = pow(cosine_angle, fragment_shininess) * diffuse_intensity;
 
-	vec3 ambient_color = light_ambient_color * material_ambient_color;
-	vec3 diffuse_color =  light_diffuse_color * material_diffuse_color * diffuse_intensity;
-	vec3 specular_color = light_specular_color * material_specular_color * specular_intensity;
+	vec3 ambient_color = light_ambient_color * fragment_ambient_color;
+	vec3 diffuse_color =  light_diffuse_color * fragment_diffuse_color * diffuse_intensity;
+	vec3 specular_color = light_specular_color * fragment_specular_color * specular_intensity;
 
 	// return
 	light_color = ambient_color + diffuse_color + specular_color;
@@ -98,6 +120,33 @@ void compute_spot_light(out vec3 light_color,
 	}
 }
 
+int sticker_state_material_index()
+{
+	vec2 coord = fract(vertex_texel);
+
+	if (any(lessThan(coord, vec2(STICKER_GAP))) || any(greaterThan(coord, vec2(1.0 - STICKER_GAP)))) {
+		return -1;
+	}
+	return int(texelFetch(sticker_state_sampler, ivec2(floor(vertex_texel)), 0).r);
+}
+
+void select_material()
+{
+	int material_index = sticker_state ? sticker_state_material_index() : vertex_material_index;
+
+	if (material_index >= 0) {
+		fragment_ambient_color = palette_ambient_colors[material_index];
+		fragment_diffuse_color = palette_diffuse_colors[material_index];
+		fragment_specular_color = palette_specular_colors[material_index];
+		fragment_shininess = palette_shininess[material_index];
+	} else {
+		fragment_ambient_color = material_ambient_color;
+		fragment_diffuse_color = material_diffuse_color;
+		fragment_specular_color = material_specular_color;
+		fragment_shininess = material_shininess;
+	}
+}
+
 void compute_texel(out vec3 color)
 {
 	color = texture(texture_sampler, vertex_texel).rgb;
@@ -159,6 +208,8 @@ void compute_carpet(out vec3 color)
 
 void main()
 {
+	select_material();
+
 	vec3 total_light = vec3(0.0, 0.0, 0.0);
 	
 	for (int i = 0; i < num_point_lights; i++) {
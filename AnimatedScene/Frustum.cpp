@@ -0,0 +1,83 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum(const glm::mat4& projectionViewMatrix)
+{
+	// Gribb & Hartmann, the planes are combinations of the matrix rows
+	const auto& m = projectionViewMatrix;
+
+	for (auto i = 0; i < 3; i++) {
+		for (auto k = 0; k < 4; k++) {
+			m_planes[i * 2][k] = m[k][3] + m[k][i];
+			m_planes[i * 2 + 1][k] = m[k][3] - m[k][i];
+		}
+	}
+
+	for (auto& plane : m_planes) {
+		auto length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+		for (auto& value : plane) {
+			value /= length;
+		}
+	}
+}
+
+bool Frustum::IsSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (const auto& plane : m_planes) {
+		if (plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3] < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Frustum::CullSpheres(const BoundingSphereArray& spheres, unsigned char* visible) const
+{
+	auto count = spheres.Size();
+	size_t i = 0;
+
+#ifdef FRUSTUM_SSE
+	__m128 planes[NUM_PLANES][4];
+
+	for (auto p = 0; p < NUM_PLANES; p++) {
+		for (auto k = 0; k < 4; k++) {
+			planes[p][k] = _mm_set1_ps(m_planes[p][k]);
+		}
+	}
+
+	for (; i + 4 <= count; i += 4) {
+		auto x = _mm_loadu_ps(&spheres.x[i]);
+		auto y = _mm_loadu_ps(&spheres.y[i]);
+		auto z = _mm_loadu_ps(&spheres.z[i]);
+		auto negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+		// Lane is outside if it's behind any plane by more than it's radius
+		auto outside = _mm_setzero_ps();
+
+		for (auto p = 0; p < NUM_PLANES; p++) {
+			auto distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)),
+				_mm_add_ps(_mm_mul_ps(planes[p][2], z), planes[p][3]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+		}
+
+		auto mask = _mm_movemask_ps(outside);
+
+		for (auto k = 0; k < 4; k++) {
+			visible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		visible[i] = IsSphereVisible(glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i]) ? 1 : 0;
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// Bounding spheres stored as structure of arrays, ready for Frustum::CullSpheres
+struct BoundingSphereArray {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> radius;
+
+	size_t Size() const { return x.size(); }
+
+	void Clear()
+	{
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	void Add(const glm::vec3& center, float r)
+	{
+		x.push_back(center.x);
+		y.push_back(center.y);
+		z.push_back(center.z);
+		radius.push_back(r);
+	}
+};
+
+// View frustum planes extracted from projection-view matrix
+class Frustum final {
+private:
+
+	static constexpr int NUM_PLANES = 6;
+
+	// Normalized plane equations (a, b, c, d), normals point inside
+	float m_planes[NUM_PLANES][4];
+
+public:
+
+	Frustum(const glm::mat4& projectionViewMatrix);
+
+	// Conservative test, sphere intersecting the frustum is visible
+	bool IsSphereVisible(const glm::vec3& center, float radius) const;
+
+	// Test all spheres, SSE is used 4 spheres at a time
+	// visible[i] is set to 1 if i-th sphere is visible, 0 otherwise
+	void CullSpheres(const BoundingSphereArray& spheres, unsigned char* visible) const;
+};
+
+#endif
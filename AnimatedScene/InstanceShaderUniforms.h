@@ -0,0 +1,32 @@
+#ifndef INSTANCE_SHADER_UNIFORMS_H
+#define INSTANCE_SHADER_UNIFORMS_H
+
+#include <GL/freeglut.h>
+
+// Uniform locations used by instanced drawing
+// Instances pick their material from the palette by index
+// Sticker state texture selects the palette material per fragment instead
+struct InstanceShaderUniforms {
+	GLint instancedUniform;
+	GLint paletteAmbientColorsUniform;
+	GLint paletteDiffuseColorsUniform;
+	GLint paletteSpecularColorsUniform;
+	GLint paletteShininessUniform;
+	GLint stickerStateUniform;
+	GLint stickerStateSamplerUniform;
+
+	InstanceShaderUniforms(GLint instanced, GLint ambientColors, GLint diffuseColors, GLint specularColors, GLint shininess,
+		GLint stickerState, GLint stickerStateSampler)
+		: instancedUniform(instanced),
+		paletteAmbientColorsUniform(ambientColors),
+		paletteDiffuseColorsUniform(diffuseColors),
+		paletteSpecularColorsUniform(specularColors),
+		paletteShininessUniform(shininess),
+		stickerStateUniform(stickerState),
+		stickerStateSamplerUniform(stickerStateSampler)
+	{}
+
+	InstanceShaderUniforms() : InstanceShaderUniforms(-1, -1, -1, -1, -1, -1, -1) {}
+};
+
+#endif
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "Camera.h"
 #include "Utils.h"
 #include "Scene.h"
+#include "Benchmark.h"
 
 namespace {
 	const int WINDOW_WIDTH = 800;
@@ -25,6 +26,14 @@ namespace {
 
 	std::unique_ptr<Scene> scene;
 
+	void ExitWithException(const std::exception& ex)
+	{
+		std::cout << "Exception catch: " << ex.what() << std::endl;
+		std::cout << "Press enter to exit\n";
+		std::cin.get();
+		exit(EXIT_FAILURE);
+	}
+
 	void Initialize()
 	{
 		srand(static_cast<unsigned int>(time(nullptr)));
@@ -38,10 +47,7 @@ namespace {
 			scene = std::make_unique<Scene>();
 		}
 		catch (const std::exception& ex) {
-			std::cout << "Exception catch: " << ex.what() << std::endl;
-			std::cout << "Press enter to exit\n";
-			std::cin.get();
-			exit(EXIT_FAILURE);
+			ExitWithException(ex);
 		}
 	}
 
@@ -54,7 +60,13 @@ namespace {
 
 	void Update()
 	{
-		scene->Update(1.f / DELTA_TIME);
+		try {
+			// Assets are uploaded during update, loading errors show up here
+			scene->Update(1.f / DELTA_TIME);
+		}
+		catch (const std::exception& ex) {
+			ExitWithException(ex);
+		}
 	}
 
 	void Display()
@@ -106,6 +118,20 @@ namespace {
 
 	void KeyboardDown(unsigned char key, int mx, int my)
 	{
+		if (key == 'm') {
+			auto&& stats = scene->GetAssetMemoryStats();
+			std::cout << "Assets: " << stats.numMeshes << " meshes, " << stats.numTextures << " textures, "
+				<< stats.cpuBytes / 1024 << " KB CPU, " << stats.gpuBytes / 1024 << " KB GPU" << std::endl;
+		}
+		else if (key == 'c') {
+			std::cout << "Rubik's cube: " << scene->GetNumSavedCubeMoves() << " moves saved by canonicalization" << std::endl;
+		}
+		else if (key == 'r') {
+			const auto& stats = scene->GetRenderStats();
+			std::cout << "Render queue: " << stats.drawCalls << " draw calls, " << stats.GetStateChanges() << " state changes ("
+				<< stats.shaderVariantChanges << " shader variants, " << stats.textureBinds << " textures, "
+				<< stats.materialChanges << " materials, " << stats.meshBinds << " meshes)" << std::endl;
+		}
 	}
 
 	void KeyboardUp(unsigned char key, int mx, int my)
@@ -148,6 +174,11 @@ namespace {
 
 int main(int argc, char** argv)
 {
+	// Offline benchmarks do not need any window
+	if (argc > 2 && std::string(argv[1]) == "--benchmark") {
+		return Benchmark::Run(argv[2], std::cout) ? 0 : -1;
+	}
+
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGBA);
 	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
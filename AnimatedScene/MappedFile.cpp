@@ -0,0 +1,137 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filepath)
+{
+	ResetAll();
+
+#ifdef _WIN32
+	m_fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (m_fileHandle == INVALID_HANDLE_VALUE) {
+		ResetAll();
+		throw std::runtime_error("Unable to open file: " + filepath);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_fileHandle, &fileSize)) {
+		DestroyAll();
+		throw std::runtime_error("Unable to get file size: " + filepath);
+	}
+
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+
+	if (m_size == 0) {
+		return; // nothing to map
+	}
+
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (m_mappingHandle == nullptr) {
+		DestroyAll();
+		throw std::runtime_error("Unable to create file mapping: " + filepath);
+	}
+
+	m_data = static_cast<const char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+	m_fileDescriptor = open(filepath.c_str(), O_RDONLY);
+
+	if (m_fileDescriptor < 0) {
+		ResetAll();
+		throw std::runtime_error("Unable to open file: " + filepath);
+	}
+
+	struct stat fileStat;
+	if (fstat(m_fileDescriptor, &fileStat) != 0) {
+		DestroyAll();
+		throw std::runtime_error("Unable to get file size: " + filepath);
+	}
+
+	m_size = static_cast<size_t>(fileStat.st_size);
+
+	if (m_size == 0) {
+		return; // nothing to map
+	}
+
+	auto data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+	m_data = (data == MAP_FAILED) ? nullptr : static_cast<const char*>(data);
+#endif
+
+	if (m_data == nullptr) {
+		DestroyAll();
+		throw std::runtime_error("Unable to map file into memory: " + filepath);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	DestroyAll();
+}
+
+MappedFile::MappedFile(MappedFile&& m)
+{
+	ResetAll();
+	*this = std::move(m);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& m)
+{
+	DestroyAll();
+	m_data = m.m_data;
+	m_size = m.m_size;
+#ifdef _WIN32
+	m_fileHandle = m.m_fileHandle;
+	m_mappingHandle = m.m_mappingHandle;
+#else
+	m_fileDescriptor = m.m_fileDescriptor;
+#endif
+	m.ResetAll();
+	return *this;
+}
+
+void MappedFile::ResetAll()
+{
+	m_data = nullptr;
+	m_size = 0;
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = nullptr;
+#else
+	m_fileDescriptor = -1;
+#endif
+}
+
+void MappedFile::DestroyAll()
+{
+#ifdef _WIN32
+	if (m_data != nullptr) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mappingHandle != nullptr) {
+		CloseHandle(m_mappingHandle);
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_fileHandle);
+	}
+#else
+	if (m_data != nullptr) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+	if (m_fileDescriptor >= 0) {
+		close(m_fileDescriptor);
+	}
+#endif
+	ResetAll();
+}
@@ -0,0 +1,44 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only view of the whole file mapped into memory
+class MappedFile final {
+private:
+
+	const char* m_data;
+	size_t m_size;
+
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#else
+	int m_fileDescriptor;
+#endif
+
+	// Reset all members to initial values, do not destroy anything
+	void ResetAll();
+
+	// Unmap the view and close all handles
+	void DestroyAll();
+
+public:
+
+	// May throw an exception if the file cannot be opened or mapped
+	MappedFile(const std::string& filepath);
+	~MappedFile();
+
+	MappedFile(MappedFile&& m);
+	MappedFile& operator=(MappedFile&& m);
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Empty files have no data (nullptr)
+	const char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+};
+
+#endif
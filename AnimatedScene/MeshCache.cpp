@@ -0,0 +1,171 @@
+#include "MeshCache.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+	static_assert(sizeof(MeshCacheHeader) == 128, "Mesh cache header must stay packed");
+	static_assert(sizeof(PackedVertex) == 16, "Packed vertex must stay packed");
+
+	const auto CACHE_EXTENSION = ".mesh";
+
+	// FNV-1a, good enough to detect changed source content
+	uint64_t HashContent(const char* data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+
+		for (size_t i = 0; i < size; i++) {
+			hash ^= static_cast<unsigned char>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t HashFile(const std::string& filepath)
+	{
+		MappedFile file(filepath);
+		return HashContent(file.GetData(), file.GetSize());
+	}
+
+	int64_t GetModificationTime(const std::string& filepath)
+	{
+		return static_cast<int64_t>(std::filesystem::last_write_time(filepath).time_since_epoch().count());
+	}
+
+	size_t GetExpectedFileSize(const MeshCacheHeader& header)
+	{
+		return sizeof(MeshCacheHeader) + sizeof(PackedVertex) * header.numVertices
+			+ static_cast<size_t>(header.indexSize) * header.numIndices;
+	}
+}
+
+MeshCache::MeshCache(MappedFile&& file)
+	: m_file(std::move(file)),
+	m_header(reinterpret_cast<const MeshCacheHeader*>(m_file.GetData()))
+{
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath)
+{
+	return std::filesystem::path(sourcePath).replace_extension(CACHE_EXTENSION).string();
+}
+
+std::unique_ptr<MeshCache> MeshCache::Open(const std::string& sourcePath)
+{
+	auto cachePath = GetCachePath(sourcePath);
+	std::error_code error;
+
+	if (!std::filesystem::exists(cachePath, error)) {
+		return nullptr;
+	}
+
+	try {
+		MappedFile file(cachePath);
+
+		if (file.GetSize() < sizeof(MeshCacheHeader)) {
+			return nullptr;
+		}
+
+		auto header = reinterpret_cast<const MeshCacheHeader*>(file.GetData());
+
+		if (header->magic != MAGIC || header->version != VERSION) {
+			return nullptr;
+		}
+		if (header->indexSize != sizeof(GLushort) && header->indexSize != sizeof(GLuint)) {
+			return nullptr;
+		}
+		if (file.GetSize() != GetExpectedFileSize(*header)) {
+			return nullptr;
+		}
+		if (header->numLods == 0 || header->numLods > MeshData::MAX_LODS) {
+			return nullptr;
+		}
+		for (uint32_t i = 0; i < header->numLods; i++) {
+			if (static_cast<uint64_t>(header->lods[i].firstIndex) + header->lods[i].numIndices > header->numIndices) {
+				return nullptr;
+			}
+		}
+
+		// Cheap check first, the content hash is computed only if the source was touched
+		auto sourceSize = std::filesystem::file_size(sourcePath);
+
+		if (header->sourceSize != sourceSize) {
+			return nullptr;
+		}
+		if (header->sourceModificationTime != GetModificationTime(sourcePath) && header->sourceHash != HashFile(sourcePath)) {
+			return nullptr;
+		}
+
+		return std::unique_ptr<MeshCache>(new MeshCache(std::move(file)));
+	}
+	catch (const std::exception&) {
+		// Unreadable cache is as good as no cache
+		return nullptr;
+	}
+}
+
+bool MeshCache::Write(const std::string& sourcePath, const MeshData& mesh)
+{
+	MeshCacheHeader header = {};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.numVertices = mesh.GetNumVertices();
+	header.numIndices = mesh.GetNumIndices();
+	header.indexSize = mesh.GetIndexSize();
+	header.acmrBefore = mesh.acmrBefore;
+	header.acmrAfter = mesh.acmrAfter;
+
+	// Mesh without LODs is the LOD 0 itself
+	header.numLods = static_cast<uint32_t>(std::max<size_t>(mesh.lods.size(), 1));
+
+	if (header.numLods > MeshData::MAX_LODS) {
+		return false;
+	}
+	if (mesh.lods.empty()) {
+		header.lods[0] = MeshLod{ 0, header.numIndices, 0.f };
+	}
+	else {
+		std::copy(mesh.lods.begin(), mesh.lods.end(), header.lods);
+	}
+
+	if (mesh.normals.size() != mesh.vertices.size() || mesh.texels.size() != header.numVertices * 2u) {
+		return false;
+	}
+
+	mesh.GetBounds(header.boundsMin, header.boundsMax);
+
+	auto cachePath = GetCachePath(sourcePath);
+	auto temporaryPath = Utils::GetTemporaryPath(cachePath);
+
+	try {
+		header.sourceSize = std::filesystem::file_size(sourcePath);
+		header.sourceModificationTime = GetModificationTime(sourcePath);
+		header.sourceHash = HashFile(sourcePath);
+
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			auto&& vertices = mesh.GetPackedVertices();
+			file.write(reinterpret_cast<const char*>(vertices.data()), sizeof(PackedVertex) * vertices.size());
+
+			auto&& indices = mesh.GetPackedIndices();
+			file.write(reinterpret_cast<const char*>(indices.data()), indices.size());
+
+			if (!file.good()) {
+				throw std::runtime_error("Unable to write mesh cache: " + temporaryPath);
+			}
+		}
+
+		// Never leave half-written cache behind
+		std::filesystem::rename(temporaryPath, cachePath);
+		return true;
+	}
+	catch (const std::exception&) {
+		std::error_code error;
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+}
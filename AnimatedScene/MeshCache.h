@@ -0,0 +1,79 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "MappedFile.h"
+#include "MeshData.h"
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Header of binary mesh cache file (*.mesh) written next to the source .obj file
+// Interleaved PackedVertex stream follows the header (positions quantized against the bounds),
+// then triangle indices of all LODs, each indexSize bytes long
+struct MeshCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceSize;
+	int64_t sourceModificationTime;
+	uint64_t sourceHash;
+	uint32_t numVertices;
+	uint32_t numIndices;
+	uint32_t indexSize;
+	uint32_t numLods;
+	float boundsMin[3];
+	float boundsMax[3];
+	float acmrBefore;
+	float acmrAfter;
+	MeshLod lods[MeshData::MAX_LODS]; // index ranges, numLods are valid
+};
+
+// Memory mapped binary mesh cache, streams can be handed straight to glBufferData
+class MeshCache final {
+private:
+
+	MappedFile m_file;
+	const MeshCacheHeader* m_header;
+
+	MeshCache(MappedFile&& file);
+
+public:
+
+	static constexpr uint32_t MAGIC = 0x434D5341u; // "ASMC"
+	static constexpr uint32_t VERSION = 6u;
+
+	// Cache file path for given source .obj file
+	static std::string GetCachePath(const std::string& sourcePath);
+
+	// Open cache of given source .obj file
+	// Return nullptr if there is no cache or if it's stale (source size, mtime and hash are checked)
+	static std::unique_ptr<MeshCache> Open(const std::string& sourcePath);
+
+	// Write cache for given source .obj file
+	// Return false if the cache cannot be written, it's not fatal
+	static bool Write(const std::string& sourcePath, const MeshData& mesh);
+
+	MeshCache(MeshCache&&) = default;
+	MeshCache& operator=(MeshCache&&) = default;
+
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+
+	const MeshCacheHeader& GetHeader() const { return *m_header; }
+	GLuint GetNumVertices() const { return m_header->numVertices; }
+	GLuint GetNumIndices() const { return m_header->numIndices; }
+	GLenum GetIndexType() const { return m_header->indexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+	GLuint GetIndexSize() const { return m_header->indexSize; }
+	GLuint GetNumLods() const { return m_header->numLods; }
+	const MeshLod* GetLods() const { return m_header->lods; }
+
+	const PackedVertex* GetVertices() const { return reinterpret_cast<const PackedVertex*>(m_header + 1); }
+	const void* GetIndices() const { return GetVertices() + GetNumVertices(); }
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "MeshData.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Utils.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+	const GLuint EMPTY_SLOT = 0xFFFFFFFFu;
+
+	// Smaller meshes are not simplified at all
+	const size_t MIN_LOD_TRIANGLES = 64;
+
+	// Allowed simplification error of LOD 1 relative to the mesh size, doubled for every next LOD
+	const float LOD_RELATIVE_ERROR = 0.01f;
+
+	// Stop generating LODs once the simplification does not remove at least this part of triangles
+	const float LOD_MIN_REDUCTION = 0.2f;
+
+	// Whole vertex compared bitwise, 8 floats
+	struct VertexKey {
+		GLfloat values[8];
+
+		bool operator==(const VertexKey& key) const { return std::memcmp(values, key.values, sizeof(values)) == 0; }
+	};
+
+	VertexKey MakeKey(const GLfloat* vertex, const GLfloat* normal, const GLfloat* texel)
+	{
+		return VertexKey{ { vertex[0], vertex[1], vertex[2], normal[0], normal[1], normal[2], texel[0], texel[1] } };
+	}
+
+	// FNV-1a over the words of the key
+	uint32_t HashKey(const VertexKey& key)
+	{
+		uint32_t hash = 2166136261u;
+		uint32_t word;
+
+		for (auto value : key.values) {
+			std::memcpy(&word, &value, sizeof(word));
+			hash = (hash ^ word) * 16777619u;
+		}
+		return hash ^ (hash >> 15);
+	}
+}
+
+void MeshData::GetBounds(GLfloat boundsMin[3], GLfloat boundsMax[3]) const
+{
+	// Every axis starts from the first vertex's own coordinate
+	for (auto axis = 0; axis < 3; axis++) {
+		boundsMin[axis] = vertices.size() < 3 ? 0.f : vertices[axis];
+		boundsMax[axis] = boundsMin[axis];
+	}
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		boundsMin[i % 3] = std::min(boundsMin[i % 3], vertices[i]);
+		boundsMax[i % 3] = std::max(boundsMax[i % 3], vertices[i]);
+	}
+}
+
+std::vector<PackedVertex> MeshData::GetPackedVertices() const
+{
+	GLfloat boundsMin[3];
+	GLfloat boundsMax[3];
+	GetBounds(boundsMin, boundsMax);
+
+	GLfloat scale[3];
+	for (auto axis = 0; axis < 3; axis++) {
+		auto extent = boundsMax[axis] - boundsMin[axis];
+		scale[axis] = extent > 0.f ? 65535.f / extent : 0.f; // flat meshes have zero extent
+	}
+
+	std::vector<PackedVertex> packed(GetNumVertices());
+
+	for (size_t i = 0; i < packed.size(); i++) {
+		auto& vertex = packed[i];
+
+		for (auto axis = 0; axis < 3; axis++) {
+			auto value = (vertices[i * 3 + axis] - boundsMin[axis]) * scale[axis];
+			vertex.position[axis] = static_cast<GLushort>(std::min(std::lround(value), 65535l));
+		}
+		vertex.position[3] = 0;
+
+		vertex.normal = glm::packSnorm3x10_1x2(glm::vec4(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2], 0.f));
+		vertex.texel[0] = glm::packHalf1x16(texels[i * 2]);
+		vertex.texel[1] = glm::packHalf1x16(texels[i * 2 + 1]);
+	}
+	return packed;
+}
+
+std::vector<unsigned char> MeshData::GetPackedIndices() const
+{
+	std::vector<unsigned char> packed(indices.size() * GetIndexSize());
+
+	if (GetIndexType() == GL_UNSIGNED_SHORT) {
+		auto out = reinterpret_cast<GLushort*>(packed.data());
+
+		for (auto index : indices) {
+			*out++ = static_cast<GLushort>(index);
+		}
+	}
+	else if (!indices.empty()) {
+		std::memcpy(packed.data(), indices.data(), packed.size());
+	}
+	return packed;
+}
+
+MeshData MeshData::CreateIndexed(const std::vector<GLfloat>& vertices,
+	const std::vector<GLfloat>& normals,
+	const std::vector<GLfloat>& texels)
+{
+	auto numCorners = vertices.size() / 3;
+
+	MeshData mesh;
+	mesh.indices.reserve(numCorners);
+	mesh.vertices.reserve(vertices.size());
+	mesh.normals.reserve(normals.size());
+	mesh.texels.reserve(texels.size());
+
+	// Open addressing table of unique vertex indices, load factor <= 0.5
+	size_t tableSize = 1;
+	while (tableSize < numCorners * 2) {
+		tableSize <<= 1;
+	}
+
+	std::vector<GLuint> table(tableSize, EMPTY_SLOT);
+	std::vector<VertexKey> uniqueKeys;
+	uniqueKeys.reserve(numCorners);
+
+	for (size_t i = 0; i < numCorners; i++) {
+		auto key = MakeKey(&vertices[i * 3], &normals[i * 3], &texels[i * 2]);
+		auto slot = HashKey(key) & (tableSize - 1);
+
+		while (table[slot] != EMPTY_SLOT && !(uniqueKeys[table[slot]] == key)) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		if (table[slot] == EMPTY_SLOT) {
+			table[slot] = static_cast<GLuint>(uniqueKeys.size());
+			uniqueKeys.push_back(key);
+
+			mesh.vertices.insert(mesh.vertices.end(), key.values, key.values + 3);
+			mesh.normals.insert(mesh.normals.end(), key.values + 3, key.values + 6);
+			mesh.texels.insert(mesh.texels.end(), key.values + 6, key.values + 8);
+		}
+
+		mesh.indices.push_back(table[slot]);
+	}
+
+	mesh.vertices.shrink_to_fit();
+	mesh.normals.shrink_to_fit();
+	mesh.texels.shrink_to_fit();
+	return mesh;
+}
+
+MeshData MeshData::ImportObjFile(const std::string& filepath)
+{
+	std::vector<GLfloat> vertices;
+	std::vector<GLfloat> normals;
+	std::vector<GLfloat> texels;
+
+	Utils::LoadObjFile(filepath, vertices, normals, texels);
+	auto mesh = CreateIndexed(vertices, normals, texels);
+	auto numVertices = mesh.GetNumVertices();
+
+	mesh.acmrBefore = MeshOptimizer::ComputeAcmr(mesh.indices.data(), mesh.indices.size(), numVertices);
+	MeshOptimizer::OptimizeVertexCache(mesh.indices, numVertices);
+	mesh.acmrAfter = MeshOptimizer::ComputeAcmr(mesh.indices.data(), mesh.indices.size(), numVertices);
+	mesh.lods.push_back(MeshLod{ 0, mesh.GetNumIndices(), 0.f });
+
+	GLfloat boundsMin[3];
+	GLfloat boundsMax[3];
+	mesh.GetBounds(boundsMin, boundsMax);
+	auto size = glm::length(glm::vec3(boundsMax[0], boundsMax[1], boundsMax[2]) - glm::vec3(boundsMin[0], boundsMin[1], boundsMin[2]));
+	auto maxError = LOD_RELATIVE_ERROR * size;
+
+	// Every LOD is simplified from the previous one
+	std::vector<GLuint> lodIndices(mesh.indices);
+
+	while (mesh.lods.size() < MAX_LODS && lodIndices.size() / 3 >= MIN_LOD_TRIANGLES) {
+		float error;
+		auto&& simplified = MeshSimplifier::Simplify(mesh, lodIndices, lodIndices.size() / 2, maxError, error);
+
+		if (simplified.size() > lodIndices.size() * (1.f - LOD_MIN_REDUCTION)) {
+			break;
+		}
+
+		MeshOptimizer::OptimizeVertexCache(simplified, numVertices);
+		mesh.lods.push_back(MeshLod{ mesh.GetNumIndices(), static_cast<GLuint>(simplified.size()), error });
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+
+		lodIndices = std::move(simplified);
+		maxError *= 2.f;
+	}
+
+	MeshOptimizer::OptimizeVertexFetch(mesh);
+	return mesh;
+}
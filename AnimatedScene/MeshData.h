@@ -0,0 +1,67 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include <string>
+#include <vector>
+
+// Interleaved quantized vertex as stored in the VBO, 16 bytes instead of 32
+struct PackedVertex {
+	GLushort position[4]; // normalized to mesh bounds, w is unused
+	GLuint normal; // GL_INT_2_10_10_10_REV
+	GLhalf texel[2]; // GL_HALF_FLOAT
+};
+
+// Level of detail, range of MeshData::indices
+struct MeshLod {
+	GLuint firstIndex;
+	GLuint numIndices;
+	float error; // simplification error in model space units
+};
+
+// CPU side indexed triangle mesh, vertex streams hold unique vertices only
+struct MeshData {
+	std::vector<GLfloat> vertices; // xyz
+	std::vector<GLfloat> normals; // xyz
+	std::vector<GLfloat> texels; // st
+	std::vector<GLuint> indices; // 3 per triangle, all LODs one after another
+
+	// LOD 0 is the full mesh, every next one has roughly half of triangles
+	// All LODs share the same vertices
+	static constexpr unsigned int MAX_LODS = 4;
+	std::vector<MeshLod> lods;
+
+	// Average cache miss ratio of the index order before and after MeshOptimizer
+	float acmrBefore = 0.f;
+	float acmrAfter = 0.f;
+
+	GLuint GetNumVertices() const { return static_cast<GLuint>(vertices.size() / 3); }
+	GLuint GetNumIndices() const { return static_cast<GLuint>(indices.size()); }
+
+	// 16-bit indices are used whenever all vertices can be addressed with them
+	GLenum GetIndexType() const { return GetNumVertices() <= 0x10000u ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+	GLuint GetIndexSize() const { return GetIndexType() == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+
+	// Axis aligned bounding box of all vertices
+	void GetBounds(GLfloat boundsMin[3], GLfloat boundsMax[3]) const;
+
+	// Vertices quantized against GetBounds(), see MeshObject for the matching attribute formats
+	std::vector<PackedVertex> GetPackedVertices() const;
+
+	// Indices in GetIndexType() format, ready for GL_ELEMENT_ARRAY_BUFFER
+	std::vector<unsigned char> GetPackedIndices() const;
+
+	// Create indexed mesh from flat triangle streams (as returned by Utils::LoadObjFile)
+	// Equal (position, normal, texel) triples are merged using hash table
+	static MeshData CreateIndexed(const std::vector<GLfloat>& vertices,
+		const std::vector<GLfloat>& normals,
+		const std::vector<GLfloat>& texels);
+
+	// Load, index, simplify (LODs) and optimize .obj file for rendering
+	static MeshData ImportObjFile(const std::string& filepath);
+};
+
+#endif
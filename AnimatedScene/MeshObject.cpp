@@ -2,11 +2,27 @@
 #include "Utils.h"
 
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace {
+	// LOD i is used when the projected size drops under LOD_SCREEN_SIZES[i] (the first one is unused)
+	const float LOD_SCREEN_SIZES[MeshData::MAX_LODS] = { 1.f, 0.4f, 0.2f, 0.1f };
+
+	// Relative distance from the threshold needed to switch LOD, avoids popping back and forth
+	const float LOD_HYSTERESIS = 0.15f;
+}
+
+MeshObject::MeshObject()
+{
+	ResetAll();
+}
 
 MeshObject::MeshObject(const std::string& filepath, GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute)
 {
 	ResetAll();
-	CreateMeshFromObjFile(filepath, positionShaderAttribute, normalShaderAttribute, texelShaderAttribute);
+	Create(MeshSource(filepath), positionShaderAttribute, normalShaderAttribute, texelShaderAttribute);
 }
 
 MeshObject::~MeshObject()
@@ -16,6 +32,7 @@ MeshObject::~MeshObject()
 
 MeshObject::MeshObject(MeshObject&& uc)
 {
+	ResetAll();
 	*this = std::move(uc);
 }
 
@@ -24,57 +41,106 @@ MeshObject& MeshObject::operator=(MeshObject&& uc)
 	DestroyAll();
 	m_modelMatrix = uc.m_modelMatrix; // ModelObject::operator=
 	m_meshVAO = uc.m_meshVAO;
-	m_verticesVBO = uc.m_verticesVBO;
-	m_normalsVBO = uc.m_normalsVBO;
-	m_texelsVBO = uc.m_texelsVBO;
-	m_arraySize = uc.m_arraySize;
+	m_vertexVBO = uc.m_vertexVBO;
+	m_indicesVBO = uc.m_indicesVBO;
+	m_numVertices = uc.m_numVertices;
+	m_numIndices = uc.m_numIndices;
+	m_indexType = uc.m_indexType;
+	m_dequantizationMatrix = uc.m_dequantizationMatrix;
+	m_boundsMin = uc.m_boundsMin;
+	m_boundsMax = uc.m_boundsMax;
+	m_boundingSphereCenter = uc.m_boundingSphereCenter;
+	m_boundingSphereRadius = uc.m_boundingSphereRadius;
+	m_lods = std::move(uc.m_lods);
 	uc.ResetAll();
 	return *this;
 }
 
-void MeshObject::CreateVerticesVBO(const std::vector<GLfloat>& vertices)
+void MeshObject::SetBounds(const GLfloat boundsMin[3], const GLfloat boundsMax[3])
 {
-	glGenBuffers(1, &m_verticesVBO);
-	if (m_verticesVBO == 0) {
-		DestroyAll();
-		throw std::runtime_error("Unable to create vertices VBO");
+	auto&& offset = glm::vec3(boundsMin[0], boundsMin[1], boundsMin[2]);
+	auto&& extent = glm::vec3(boundsMax[0], boundsMax[1], boundsMax[2]) - offset;
+
+	m_dequantizationMatrix = glm::scale(glm::translate(glm::mat4(1.f), offset), extent);
+	m_boundsMin = offset;
+	m_boundsMax = offset + extent;
+	m_boundingSphereCenter = offset + extent * 0.5f;
+	m_boundingSphereRadius = glm::length(extent) * 0.5f;
+}
+
+void MeshObject::GetBoundingSphere(const glm::mat4& modelMatrix, glm::vec3& center, float& radius) const
+{
+	center = glm::vec3(modelMatrix * glm::vec4(m_boundingSphereCenter, 1.f));
+
+	// Non-uniform scale stretches the sphere by the largest axis scale
+	auto scale = std::max({
+		glm::length(glm::vec3(modelMatrix[0])),
+		glm::length(glm::vec3(modelMatrix[1])),
+		glm::length(glm::vec3(modelMatrix[2])) });
+	radius = m_boundingSphereRadius * scale;
+}
+
+float MeshObject::GetProjectedSize(const Camera& camera, const glm::mat4& modelMatrix) const
+{
+	glm::vec3 center;
+	float radius;
+	GetBoundingSphere(modelMatrix, center, radius);
+
+	auto distance = glm::length(center - camera.GetEyePosition());
+
+	if (distance <= radius) {
+		return std::numeric_limits<float>::max(); // camera inside
 	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_verticesVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), 
-		reinterpret_cast<const void*>(vertices.data()), GL_STATIC_DRAW);
+	// Projection matrix [1][1] is cot(fovy / 2)
+	return radius * camera.GetProjectionMatrix()[1][1] / distance;
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+unsigned int MeshObject::SelectLod(const Camera& camera, const glm::mat4& modelMatrix, unsigned int previousLod) const
+{
+	if (GetNumLods() <= 1) {
+		return 0;
+	}
+
+	auto projectedSize = GetProjectedSize(camera, modelMatrix);
+	auto lod = std::min(previousLod, GetNumLods() - 1);
+
+	while (lod + 1 < GetNumLods() && projectedSize < LOD_SCREEN_SIZES[lod + 1] * (1.f - LOD_HYSTERESIS)) {
+		lod++;
+	}
+	while (lod > 0 && projectedSize > LOD_SCREEN_SIZES[lod] * (1.f + LOD_HYSTERESIS)) {
+		lod--;
+	}
+	return lod;
 }
 
-void MeshObject::CreateNormalsVBO(const std::vector<GLfloat>& normals)
+void MeshObject::CreateVertexVBO(const PackedVertex* vertices, size_t numVertices)
 {
-	glGenBuffers(1, &m_normalsVBO);
-	if (m_normalsVBO == 0) {
+	glGenBuffers(1, &m_vertexVBO);
+	if (m_vertexVBO == 0) {
 		DestroyAll();
-		throw std::runtime_error("Unable to create normals VBO");
+		throw std::runtime_error("Unable to create vertex VBO");
 	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_normalsVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * normals.size(),
-		reinterpret_cast<const void*>(normals.data()), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex) * numVertices,
+		reinterpret_cast<const void*>(vertices), GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void MeshObject::CreateTexelsVBO(const std::vector<GLfloat>& texels)
+void MeshObject::CreateIndicesVBO(const void* indices, size_t size)
 {
-	glGenBuffers(1, &m_texelsVBO);
-	if (m_texelsVBO == 0) {
+	glGenBuffers(1, &m_indicesVBO);
+	if (m_indicesVBO == 0) {
 		DestroyAll();
-		throw std::runtime_error("Unable to create texels VBO");
+		throw std::runtime_error("Unable to create indices VBO");
 	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_texelsVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * texels.size(),
-		reinterpret_cast<const void*>(texels.data()), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indicesVBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void MeshObject::CreateMeshVAO(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute)
@@ -87,64 +153,88 @@ void MeshObject::CreateMeshVAO(GLint positionShaderAttribute, GLint normalShader
 	}
 
 	glBindVertexArray(m_meshVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
+
+	const auto stride = static_cast<GLsizei>(sizeof(PackedVertex));
 
 	if (positionShaderAttribute >= 0) { // valid
-		glBindBuffer(GL_ARRAY_BUFFER, m_verticesVBO);
 		glEnableVertexAttribArray(positionShaderAttribute);
-		glVertexAttribPointer(positionShaderAttribute, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+		glVertexAttribPointer(positionShaderAttribute, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+			reinterpret_cast<const void*>(offsetof(PackedVertex, position)));
 	}
 	if (normalShaderAttribute >= 0) {
-		glBindBuffer(GL_ARRAY_BUFFER, m_normalsVBO);
 		glEnableVertexAttribArray(normalShaderAttribute);
-		glVertexAttribPointer(normalShaderAttribute, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+		glVertexAttribPointer(normalShaderAttribute, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+			reinterpret_cast<const void*>(offsetof(PackedVertex, normal)));
 	}
 	if (texelShaderAttribute >= 0) {
-		glBindBuffer(GL_ARRAY_BUFFER, m_texelsVBO);
 		glEnableVertexAttribArray(texelShaderAttribute);
-		glVertexAttribPointer(texelShaderAttribute, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+		glVertexAttribPointer(texelShaderAttribute, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<const void*>(offsetof(PackedVertex, texel)));
 	}
 
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indicesVBO);
+
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void MeshObject::CreateMeshFromObjFile(const std::string& filepath,
+void MeshObject::Create(const MeshSource& source,
 	GLint positionShaderAttribute,
 	GLint normalShaderAttribute,
 	GLint texelShaderAttribute)
 {
-	std::vector<GLfloat> vertices;
-	std::vector<GLfloat> normals;
-	std::vector<GLfloat> texels;
+	// Keep the transformations, only the geometry is replaced
+	auto modelMatrix = m_modelMatrix;
+	DestroyAll();
+	m_modelMatrix = modelMatrix;
+
+	m_numVertices = source.GetNumVertices();
+	m_numIndices = source.GetNumIndices();
+	m_indexType = source.GetIndexType();
+	SetBounds(source.GetBoundsMin(), source.GetBoundsMax());
+	CreateVertexVBO(source.GetVertices(), m_numVertices);
+	CreateIndicesVBO(source.GetIndices(), m_numIndices * source.GetIndexSize());
+
+	m_lods = source.GetLods();
+	if (m_lods.empty()) {
+		m_lods.push_back(MeshLod{ 0, m_numIndices, 0.f });
+	}
 
-	Utils::LoadObjFile(filepath, vertices, normals, texels);
-	CreateVerticesVBO(vertices);
-	CreateNormalsVBO(normals);
-	CreateTexelsVBO(texels);
 	CreateMeshVAO(positionShaderAttribute, normalShaderAttribute, texelShaderAttribute);
-	m_arraySize = vertices.size() / 3;
+}
+
+size_t MeshObject::GetGpuSize() const
+{
+	auto indexSize = (m_indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	return m_numVertices * sizeof(PackedVertex) + m_numIndices * indexSize;
 }
 
 void MeshObject::ResetAll()
 {
 	ResetTransformations();
 	m_meshVAO = 0;
-	m_verticesVBO = 0;
-	m_normalsVBO = 0;
-	m_texelsVBO = 0;
-	m_arraySize = 0;
+	m_vertexVBO = 0;
+	m_indicesVBO = 0;
+	m_numVertices = 0;
+	m_numIndices = 0;
+	m_indexType = GL_UNSIGNED_INT;
+	m_dequantizationMatrix = glm::mat4(1.f);
+	m_boundsMin = glm::vec3(0.f);
+	m_boundsMax = glm::vec3(0.f);
+	m_boundingSphereCenter = glm::vec3(0.f);
+	m_boundingSphereRadius = 0.f;
+	m_lods.clear();
 }
 
 void MeshObject::DestroyAll()
 {
-	if (m_verticesVBO != 0) {
-		glDeleteBuffers(1, &m_verticesVBO);
-	}
-	if (m_normalsVBO != 0) {
-		glDeleteBuffers(1, &m_normalsVBO);
+	if (m_vertexVBO != 0) {
+		glDeleteBuffers(1, &m_vertexVBO);
 	}
-	if (m_texelsVBO != 0) {
-		glDeleteBuffers(1, &m_texelsVBO);
+	if (m_indicesVBO != 0) {
+		glDeleteBuffers(1, &m_indicesVBO);
 	}
 	if (m_meshVAO != 0) {
 		glDeleteVertexArrays(1, &m_meshVAO);
@@ -157,18 +247,50 @@ void MeshObject::Draw(const Camera& camera,
 	const MatrixShaderUniforms& matrixUniforms,
 	const MaterialShaderUniforms& materialUniforms) const
 {
-	auto&& pvmMatrix = camera.GetMatrix() * m_modelMatrix;
+	Draw(camera, m_modelMatrix, SelectLod(camera, m_modelMatrix), surfaceMaterial, matrixUniforms, materialUniforms);
+}
 
-	glUniformMatrix4fv(matrixUniforms.pvmMatrixUniform, 1, GL_FALSE, glm::value_ptr(pvmMatrix));
-	glUniformMatrix3fv(matrixUniforms.normalMatrixUniform, 1, GL_FALSE, glm::value_ptr(glm::mat3(GetNormalMatrix())));
-	glUniformMatrix4fv(matrixUniforms.modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(m_modelMatrix));
+void MeshObject::Draw(const Camera& camera,
+	const glm::mat4& modelMatrix,
+	unsigned int lod,
+	const SurfaceMaterial& surfaceMaterial,
+	const MatrixShaderUniforms& matrixUniforms,
+	const MaterialShaderUniforms& materialUniforms) const
+{
+	if (!IsLoaded()) {
+		return; // still loading
+	}
 
+	SendMaterial(surfaceMaterial, materialUniforms);
+	Bind();
+	DrawBound(camera, modelMatrix, lod, matrixUniforms);
+	Unbind();
+}
+
+void MeshObject::SendMaterial(const SurfaceMaterial& surfaceMaterial, const MaterialShaderUniforms& materialUniforms)
+{
 	glUniform3fv(materialUniforms.ambientColorUniform, 1, glm::value_ptr(surfaceMaterial.ambientColor));
 	glUniform3fv(materialUniforms.diffuseColorUniform, 1, glm::value_ptr(surfaceMaterial.diffuseColor));
 	glUniform3fv(materialUniforms.specularColorUniform, 1, glm::value_ptr(surfaceMaterial.specularColor));
 	glUniform1f(materialUniforms.shininessUniform, surfaceMaterial.shininess);
+}
 
-	glBindVertexArray(m_meshVAO);
-	glDrawArrays(GL_TRIANGLES, 0, m_arraySize);
-	glBindVertexArray(0);
+void MeshObject::DrawBound(const Camera& camera,
+	const glm::mat4& modelMatrix,
+	unsigned int lod,
+	const MatrixShaderUniforms& matrixUniforms) const
+{
+	// Normals are not affected by the dequantization
+	auto&& normalMatrix = glm::inverse(glm::transpose(modelMatrix));
+	auto&& dequantizedModelMatrix = modelMatrix * m_dequantizationMatrix;
+	auto&& pvmMatrix = camera.GetMatrix() * dequantizedModelMatrix;
+
+	glUniformMatrix4fv(matrixUniforms.pvmMatrixUniform, 1, GL_FALSE, glm::value_ptr(pvmMatrix));
+	glUniformMatrix3fv(matrixUniforms.normalMatrixUniform, 1, GL_FALSE, glm::value_ptr(glm::mat3(normalMatrix)));
+	glUniformMatrix4fv(matrixUniforms.modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(dequantizedModelMatrix));
+
+	const auto& meshLod = m_lods[std::min<size_t>(lod, m_lods.size() - 1)];
+	auto indexSize = (m_indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+
+	glDrawElements(GL_TRIANGLES, meshLod.numIndices, m_indexType, reinterpret_cast<const void*>(meshLod.firstIndex * indexSize));
 }
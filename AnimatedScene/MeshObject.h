@@ -10,28 +10,39 @@
 #include "MaterialShaderUniforms.h"
 #include "MatrixShaderUniforms.h"
 #include "SurfaceMaterial.h"
+#include "MeshSource.h"
 #include <string>
 #include <vector>
 
 // OpenGL Mesh object loaded from .obj (obj wavefront) file
+// Vertices are deduplicated, quantized into single interleaved VBO and drawn indexed
+// LOD is selected by the projected size of the mesh bounds
 class MeshObject : public ModelObject {
 private:
 
-	GLuint m_verticesVBO;
-	GLuint m_normalsVBO;
-	GLuint m_texelsVBO;
-	GLuint m_arraySize;
+	GLuint m_vertexVBO;
+	GLuint m_indicesVBO;
+	GLuint m_numVertices;
+	GLuint m_numIndices;
+	GLenum m_indexType;
 	GLuint m_meshVAO;
 
-	void CreateVerticesVBO(const std::vector<GLfloat>& vertices);
-	void CreateNormalsVBO(const std::vector<GLfloat>& normals);
-	void CreateTexelsVBO(const std::vector<GLfloat>& texels);
-	void CreateMeshVAO(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute);
+	// Maps quantized positions back to the mesh bounds, applied before the model matrix
+	glm::mat4 m_dequantizationMatrix;
 
-	void CreateMeshFromObjFile(const std::string& filepath,
-		GLint positionShaderAttribute,
-		GLint normalShaderAttribute,
-		GLint texelShaderAttribute);
+	// Model space bounding volumes
+	glm::vec3 m_boundsMin;
+	glm::vec3 m_boundsMax;
+	glm::vec3 m_boundingSphereCenter;
+	float m_boundingSphereRadius;
+
+	std::vector<MeshLod> m_lods;
+
+	void SetBounds(const GLfloat boundsMin[3], const GLfloat boundsMax[3]);
+
+	void CreateVertexVBO(const PackedVertex* vertices, size_t numVertices);
+	void CreateIndicesVBO(const void* indices, size_t size);
+	void CreateMeshVAO(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute);
 
 	// Reset all members to initial values, do not destroy anything
 	void ResetAll();
@@ -40,7 +51,11 @@ private:
 	void DestroyAll();
 
 public:
-	
+
+	// Empty mesh, nothing is drawn until Create is called
+	MeshObject();
+
+	// Load mesh synchronously (see MeshSource)
 	MeshObject(const std::string& filepath,
 		GLint positionShaderAttribute,
 		GLint normalShaderAttribute,
@@ -55,10 +70,57 @@ public:
 	MeshObject(const MeshObject& c) = delete;
 	MeshObject& operator=(const MeshObject&) = delete;
 
+	// Upload mesh buffers into VBOs and create VAO, previous content is destroyed
+	void Create(const MeshSource& source,
+		GLint positionShaderAttribute,
+		GLint normalShaderAttribute,
+		GLint texelShaderAttribute);
+
+	bool IsLoaded() const { return m_meshVAO != 0; }
+
+	// Size of vertex and index buffers in bytes
+	size_t GetGpuSize() const;
+
+	GLuint GetNumLods() const { return static_cast<GLuint>(m_lods.size()); }
+
+	// Model space axis aligned bounding box
+	const glm::vec3& GetBoundsMin() const { return m_boundsMin; }
+	const glm::vec3& GetBoundsMax() const { return m_boundsMax; }
+
+	// World space bounding sphere of the mesh transformed by given model matrix
+	void GetBoundingSphere(const glm::mat4& modelMatrix, glm::vec3& center, float& radius) const;
+
+	// Diameter of the bounding sphere projected by the camera, relative to the screen height
+	float GetProjectedSize(const Camera& camera, const glm::mat4& modelMatrix) const;
+
+	// LOD for the projected size of the mesh
+	// The previous LOD is kept unless the size is clearly past the threshold (hysteresis)
+	unsigned int SelectLod(const Camera& camera, const glm::mat4& modelMatrix, unsigned int previousLod = 0) const;
+
+	// Draw with own model matrix, LOD is selected without hysteresis
+	void Draw(const Camera& camera,
+		const SurfaceMaterial& surfaceMaterial,
+		const MatrixShaderUniforms& matrixUniforms,
+		const MaterialShaderUniforms& materialUniforms) const;
+
 	void Draw(const Camera& camera,
+		const glm::mat4& modelMatrix,
+		unsigned int lod,
 		const SurfaceMaterial& surfaceMaterial,
 		const MatrixShaderUniforms& matrixUniforms,
 		const MaterialShaderUniforms& materialUniforms) const;
+
+	// Parts of Draw for callers sharing material and VAO between draws (see RenderQueue)
+	static void SendMaterial(const SurfaceMaterial& surfaceMaterial, const MaterialShaderUniforms& materialUniforms);
+
+	void Bind() const { glBindVertexArray(m_meshVAO); }
+	static void Unbind() { glBindVertexArray(0); }
+
+	// Send matrices and draw, the mesh must be loaded and bound
+	void DrawBound(const Camera& camera,
+		const glm::mat4& modelMatrix,
+		unsigned int lod,
+		const MatrixShaderUniforms& matrixUniforms) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Forsyth's tuned scoring constants
+	const int VERTEX_CACHE_SIZE = 32;
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	float ComputeVertexScore(int cachePosition, unsigned int numActiveTriangles)
+	{
+		if (numActiveTriangles == 0) {
+			return -1.f; // no triangle needs this vertex anymore
+		}
+
+		auto score = 0.f;
+
+		if (cachePosition < 0) {
+			// not in cache
+		}
+		else if (cachePosition < 3) {
+			// used by the last triangle, fixed score to discourage immediate reuse (strips)
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else {
+			auto scaler = 1.f / (VERTEX_CACHE_SIZE - 3);
+			score = std::pow(1.f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+		}
+
+		// Vertices with only few triangles left are preferred, they would be lonely otherwise
+		return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(numActiveTriangles), -VALENCE_BOOST_POWER);
+	}
+}
+
+float MeshOptimizer::ComputeAcmr(const GLuint* indices, size_t numIndices, GLuint numVertices, unsigned int cacheSize)
+{
+	if (numIndices < 3) {
+		return 0.f;
+	}
+
+	// FIFO cache, timestamp of the moment the vertex entered it
+	std::vector<size_t> cacheTimestamps(numVertices, 0);
+	size_t timestamp = cacheSize + 1;
+	size_t misses = 0;
+
+	for (size_t i = 0; i < numIndices; i++) {
+		auto index = indices[i];
+
+		if (timestamp - cacheTimestamps[index] > cacheSize) {
+			cacheTimestamps[index] = timestamp++;
+			misses++;
+		}
+	}
+
+	return static_cast<float>(misses) / (numIndices / 3);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, GLuint numVertices)
+{
+	auto numTriangles = indices.size() / 3;
+
+	if (numTriangles == 0) {
+		return;
+	}
+
+	// Vertex -> adjacent triangles (compressed rows), only the first numActive of each row are alive
+	std::vector<unsigned int> numActive(numVertices, 0);
+	std::vector<unsigned int> adjacencyOffsets(numVertices + 1, 0);
+
+	for (auto index : indices) {
+		numActive[index]++;
+	}
+	for (GLuint v = 0; v < numVertices; v++) {
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + numActive[v];
+	}
+
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+		for (size_t i = 0; i < indices.size(); i++) {
+			adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+	}
+
+	std::vector<int> cachePositions(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	std::vector<float> triangleScores(numTriangles, 0.f);
+	std::vector<bool> emitted(numTriangles, false);
+
+	for (GLuint v = 0; v < numVertices; v++) {
+		vertexScores[v] = ComputeVertexScore(-1, numActive[v]);
+	}
+	for (size_t i = 0; i < indices.size(); i++) {
+		triangleScores[i / 3] += vertexScores[indices[i]];
+	}
+
+	// Cache holds a few more entries during update, they are dropped afterwards
+	std::vector<GLuint> cache;
+	std::vector<GLuint> newCache;
+	cache.reserve(VERTEX_CACHE_SIZE + 3);
+	newCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+	std::vector<GLuint> result;
+	result.reserve(indices.size());
+
+	size_t bestTriangle = 0;
+	size_t deadEndCursor = 0;
+
+	for (size_t emittedCount = 0; emittedCount < numTriangles; emittedCount++) {
+		emitted[bestTriangle] = true;
+
+		const auto triangle = &indices[bestTriangle * 3];
+		result.insert(result.end(), triangle, triangle + 3);
+
+		// Remove the triangle from adjacency of it's vertices
+		for (auto k = 0; k < 3; k++) {
+			auto v = triangle[k];
+			auto row = &adjacency[adjacencyOffsets[v]];
+			auto position = std::find(row, row + numActive[v], static_cast<unsigned int>(bestTriangle));
+
+			std::swap(*position, row[numActive[v] - 1]);
+			numActive[v]--;
+		}
+
+		// Move triangle's vertices to the front of LRU cache
+		newCache.assign(triangle, triangle + 3);
+
+		for (auto v : cache) {
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+				newCache.push_back(v);
+			}
+		}
+
+		for (size_t i = 0; i < newCache.size(); i++) {
+			cachePositions[newCache[i]] = (i < VERTEX_CACHE_SIZE) ? static_cast<int>(i) : -1;
+		}
+
+		// Update scores of all touched vertices and their triangles, pick the best one on the way
+		auto bestScore = -1.f;
+
+		for (auto v : newCache) {
+			auto newScore = ComputeVertexScore(cachePositions[v], numActive[v]);
+			auto delta = newScore - vertexScores[v];
+			vertexScores[v] = newScore;
+
+			auto row = &adjacency[adjacencyOffsets[v]];
+
+			for (unsigned int i = 0; i < numActive[v]; i++) {
+				auto t = row[i];
+				triangleScores[t] += delta;
+
+				if (triangleScores[t] > bestScore) {
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		newCache.resize(std::min<size_t>(newCache.size(), VERTEX_CACHE_SIZE));
+		cache.swap(newCache);
+
+		// Dead end, no triangle shares a cached vertex, continue with the next one in original order
+		if (bestScore < 0.f) {
+			while (deadEndCursor < numTriangles && emitted[deadEndCursor]) {
+				deadEndCursor++;
+			}
+			bestTriangle = deadEndCursor;
+		}
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData& mesh)
+{
+	const GLuint UNUSED = 0xFFFFFFFFu;
+
+	auto numVertices = mesh.GetNumVertices();
+	std::vector<GLuint> remap(numVertices, UNUSED);
+	GLuint nextVertex = 0;
+
+	for (auto& index : mesh.indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = nextVertex++;
+		}
+		index = remap[index];
+	}
+
+	// Vertices which are not referenced at all are dropped
+	std::vector<GLfloat> vertices(nextVertex * 3);
+	std::vector<GLfloat> normals(nextVertex * 3);
+	std::vector<GLfloat> texels(nextVertex * 2);
+
+	for (GLuint v = 0; v < numVertices; v++) {
+		auto target = remap[v];
+
+		if (target == UNUSED) {
+			continue;
+		}
+
+		std::copy_n(&mesh.vertices[v * 3], 3, &vertices[target * 3]);
+		std::copy_n(&mesh.normals[v * 3], 3, &normals[target * 3]);
+		std::copy_n(&mesh.texels[v * 2], 2, &texels[target * 2]);
+	}
+
+	mesh.vertices.swap(vertices);
+	mesh.normals.swap(normals);
+	mesh.texels.swap(texels);
+}
@@ -0,0 +1,24 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "MeshData.h"
+
+// Index and vertex order optimizations run during mesh import
+namespace MeshOptimizer {
+
+	// Size of simulated FIFO post-transform cache used for statistics
+	constexpr unsigned int STATISTICS_CACHE_SIZE = 16u;
+
+	// Average cache miss ratio = transformed vertices per triangle (0.5 is ideal, 3 is the worst)
+	float ComputeAcmr(const GLuint* indices, size_t numIndices, GLuint numVertices,
+		unsigned int cacheSize = STATISTICS_CACHE_SIZE);
+
+	// Reorder triangles for post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+	void OptimizeVertexCache(std::vector<GLuint>& indices, GLuint numVertices);
+
+	// Reorder vertices in the order they are first referenced by the indices (all LODs)
+	// Should be run after OptimizeVertexCache, improves pre-transform (memory) locality
+	void OptimizeVertexFetch(MeshData& mesh);
+}
+
+#endif
@@ -0,0 +1,407 @@
+#include "MeshSimplifier.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+	// Collapse must not turn any vertex normal more than this (cosine)
+	const float NORMAL_CREASE_THRESHOLD = 0.9f;
+
+	// Borders are kept in place by planes perpendicular to the border triangles
+	const double BORDER_WEIGHT = 10.0;
+
+	// Give up when a pass collapses less than this part of triangles, every pass is O(n log n)
+	const size_t MIN_PASS_COLLAPSES_RATIO = 256;
+
+	const GLuint INVALID_POSITION = 0xFFFFFFFFu;
+
+	// Symmetric 4x4 matrix of plane equations, area weighted
+	struct Quadric {
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+		double weight;
+
+		void AddPlane(const glm::dvec3& normal, double d, double planeWeight)
+		{
+			a2 += planeWeight * normal.x * normal.x;
+			ab += planeWeight * normal.x * normal.y;
+			ac += planeWeight * normal.x * normal.z;
+			ad += planeWeight * normal.x * d;
+			b2 += planeWeight * normal.y * normal.y;
+			bc += planeWeight * normal.y * normal.z;
+			bd += planeWeight * normal.y * d;
+			c2 += planeWeight * normal.z * normal.z;
+			cd += planeWeight * normal.z * d;
+			d2 += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			weight += q.weight;
+		}
+
+		// Sum of weighted squared distances to all planes
+		double Evaluate(const glm::dvec3& p) const
+		{
+			auto result = a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x
+				+ b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y
+				+ c2 * p.z * p.z + 2.0 * cd * p.z
+				+ d2;
+			return std::max(result, 0.0);
+		}
+	};
+
+	struct Collapse {
+		GLuint from;
+		GLuint to;
+		double error; // mean squared distance
+	};
+
+	uint64_t MakeEdgeKey(GLuint a, GLuint b)
+	{
+		return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+	}
+
+	// Vertices with bitwise equal positions share one position (and quadric)
+	GLuint WeldPositions(const MeshData& mesh, std::vector<GLuint>& positionOf, std::vector<glm::dvec3>& positions)
+	{
+		struct PositionHash {
+			size_t operator()(const glm::vec3& p) const
+			{
+				uint32_t words[3];
+				std::memcpy(words, &p, sizeof(words));
+				return (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+			}
+		};
+
+		std::unordered_map<glm::vec3, GLuint, PositionHash> welded;
+		auto numVertices = mesh.GetNumVertices();
+		positionOf.resize(numVertices);
+
+		for (GLuint v = 0; v < numVertices; v++) {
+			glm::vec3 p(mesh.vertices[v * 3], mesh.vertices[v * 3 + 1], mesh.vertices[v * 3 + 2]);
+			auto result = welded.emplace(p, static_cast<GLuint>(positions.size()));
+
+			if (result.second) {
+				positions.push_back(glm::dvec3(p));
+			}
+			positionOf[v] = result.first->second;
+		}
+		return static_cast<GLuint>(positions.size());
+	}
+
+	void ComputeQuadrics(const std::vector<GLuint>& triangles,
+		const std::vector<GLuint>& positionOf,
+		const std::vector<glm::dvec3>& positions,
+		std::vector<Quadric>& quadrics)
+	{
+		quadrics.assign(positions.size(), Quadric{});
+		std::unordered_map<uint64_t, int> edgeUsage;
+
+		for (size_t i = 0; i < triangles.size(); i += 3) {
+			GLuint p[3] = { positionOf[triangles[i]], positionOf[triangles[i + 1]], positionOf[triangles[i + 2]] };
+			auto&& normal = glm::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+			auto area = glm::length(normal);
+
+			if (area == 0.0) {
+				continue;
+			}
+
+			normal /= area;
+			auto d = -glm::dot(normal, positions[p[0]]);
+
+			for (auto k = 0; k < 3; k++) {
+				quadrics[p[k]].AddPlane(normal, d, area);
+				edgeUsage[MakeEdgeKey(p[k], p[(k + 1) % 3])]++;
+			}
+		}
+
+		// Open border edges (used by one triangle only)
+		for (size_t i = 0; i < triangles.size(); i += 3) {
+			GLuint p[3] = { positionOf[triangles[i]], positionOf[triangles[i + 1]], positionOf[triangles[i + 2]] };
+			auto&& normal = glm::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+
+			if (glm::length(normal) == 0.0) {
+				continue;
+			}
+
+			for (auto k = 0; k < 3; k++) {
+				auto a = p[k];
+				auto b = p[(k + 1) % 3];
+
+				if (edgeUsage[MakeEdgeKey(a, b)] != 1) {
+					continue;
+				}
+
+				auto&& edge = positions[b] - positions[a];
+				auto&& borderNormal = glm::cross(edge, normal);
+				auto length = glm::length(borderNormal);
+
+				if (length == 0.0) {
+					continue;
+				}
+
+				borderNormal /= length;
+				auto d = -glm::dot(borderNormal, positions[a]);
+				auto weight = BORDER_WEIGHT * glm::dot(edge, edge);
+
+				quadrics[a].AddPlane(borderNormal, d, weight);
+				quadrics[b].AddPlane(borderNormal, d, weight);
+			}
+		}
+	}
+
+	double GetCollapseError(const std::vector<Quadric>& quadrics, const std::vector<glm::dvec3>& positions, GLuint from, GLuint to)
+	{
+		auto q = quadrics[from];
+		q.Add(quadrics[to]);
+		return q.weight > 0.0 ? q.Evaluate(positions[to]) / q.weight : 0.0;
+	}
+}
+
+std::vector<GLuint> MeshSimplifier::Simplify(const MeshData& mesh,
+	const std::vector<GLuint>& indices,
+	size_t targetNumIndices,
+	float maxError,
+	float& resultError)
+{
+	resultError = 0.f;
+
+	std::vector<GLuint> positionOf;
+	std::vector<glm::dvec3> positions;
+	auto numPositions = WeldPositions(mesh, positionOf, positions);
+
+	std::vector<Quadric> quadrics;
+	ComputeQuadrics(indices, positionOf, positions, quadrics);
+
+	auto&& normalOf = [&mesh](GLuint v) { return glm::vec3(mesh.normals[v * 3], mesh.normals[v * 3 + 1], mesh.normals[v * 3 + 2]); };
+	auto&& texelOf = [&mesh](GLuint v) { return glm::vec2(mesh.texels[v * 2], mesh.texels[v * 2 + 1]); };
+
+	// Vertices (wedges) sharing the position
+	std::vector<GLuint> wedgeOffsets(numPositions + 1, 0);
+	std::vector<GLuint> wedges(positionOf.size());
+	{
+		for (auto position : positionOf) {
+			wedgeOffsets[position + 1]++;
+		}
+		for (GLuint p = 0; p < numPositions; p++) {
+			wedgeOffsets[p + 1] += wedgeOffsets[p];
+		}
+
+		std::vector<GLuint> fill(wedgeOffsets.begin(), wedgeOffsets.end() - 1);
+		for (GLuint v = 0; v < positionOf.size(); v++) {
+			wedges[fill[positionOf[v]]++] = v;
+		}
+	}
+
+	auto triangles = indices;
+	auto maxSquaredError = static_cast<double>(maxError) * maxError;
+	auto reachedError = 0.0;
+
+	std::vector<GLuint> adjacencyOffsets;
+	std::vector<GLuint> adjacency;
+	std::vector<uint64_t> edges;
+	std::vector<Collapse> collapses;
+	std::vector<bool> locked;
+	std::vector<std::pair<GLuint, GLuint>> wedgeMapping;
+
+	// Each pass collapses a set of independent edges, cheapest first
+	while (triangles.size() > targetNumIndices) {
+		auto numTriangles = triangles.size() / 3;
+
+		// Position -> triangles
+		adjacencyOffsets.assign(numPositions + 1, 0);
+		for (auto v : triangles) {
+			adjacencyOffsets[positionOf[v] + 1]++;
+		}
+		for (GLuint p = 0; p < numPositions; p++) {
+			adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+		}
+
+		adjacency.resize(triangles.size());
+		{
+			std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < triangles.size(); i++) {
+				adjacency[fill[positionOf[triangles[i]]]++] = static_cast<GLuint>(i / 3);
+			}
+		}
+
+		edges.clear();
+		for (size_t i = 0; i < triangles.size(); i += 3) {
+			for (auto k = 0; k < 3; k++) {
+				edges.push_back(MakeEdgeKey(positionOf[triangles[i + k]], positionOf[triangles[i + (k + 1) % 3]]));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		collapses.clear();
+		for (auto edge : edges) {
+			auto a = static_cast<GLuint>(edge >> 32);
+			auto b = static_cast<GLuint>(edge & 0xFFFFFFFFu);
+			auto errorAB = GetCollapseError(quadrics, positions, a, b);
+			auto errorBA = GetCollapseError(quadrics, positions, b, a);
+
+			if (errorAB <= errorBA) {
+				collapses.push_back(Collapse{ a, b, errorAB });
+			}
+			else {
+				collapses.push_back(Collapse{ b, a, errorBA });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& c1, const Collapse& c2) { return c1.error < c2.error; });
+
+		locked.assign(numPositions, false);
+		size_t numCollapsed = 0;
+
+		for (const auto& collapse : collapses) {
+			if (collapse.error > maxSquaredError || numTriangles * 3 <= targetNumIndices) {
+				break;
+			}
+			if (locked[collapse.from] || locked[collapse.to]) {
+				continue;
+			}
+
+			auto from = collapse.from;
+			auto to = collapse.to;
+			auto valid = true;
+			wedgeMapping.clear();
+
+			for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1] && valid; i++) {
+				auto triangle = &triangles[adjacency[i] * 3];
+				GLuint p[3] = { positionOf[triangle[0]], positionOf[triangle[1]], positionOf[triangle[2]] };
+
+				if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2]) {
+					continue; // already collapsed
+				}
+				if (p[0] == to || p[1] == to || p[2] == to) {
+					continue; // will be collapsed
+				}
+
+				// Triangle must not flip
+				auto k = (p[0] == from) ? 0 : (p[1] == from) ? 1 : 2;
+				auto&& x = positions[p[(k + 1) % 3]];
+				auto&& y = positions[p[(k + 2) % 3]];
+				auto&& oldNormal = glm::cross(x - positions[from], y - positions[from]);
+				auto&& newNormal = glm::cross(x - positions[to], y - positions[to]);
+
+				if (glm::dot(oldNormal, newNormal) <= 0.0) {
+					valid = false;
+					break;
+				}
+
+				// Find matching vertex at the target position for each used vertex
+				auto wedge = triangle[k];
+				auto mapped = std::find_if(wedgeMapping.begin(), wedgeMapping.end(),
+					[wedge](const std::pair<GLuint, GLuint>& m) { return m.first == wedge; });
+
+				if (mapped != wedgeMapping.end()) {
+					continue;
+				}
+
+				auto&& normal = normalOf(wedge);
+				auto&& texel = texelOf(wedge);
+				auto bestWedge = INVALID_POSITION;
+				auto bestScore = -1e30f;
+
+				for (auto w = wedgeOffsets[to]; w < wedgeOffsets[to + 1]; w++) {
+					auto candidate = wedges[w];
+					auto&& texelDelta = texelOf(candidate) - texel;
+					auto score = glm::dot(normalOf(candidate), normal) - glm::dot(texelDelta, texelDelta);
+
+					if (score > bestScore) {
+						bestScore = score;
+						bestWedge = candidate;
+					}
+				}
+
+				if (bestWedge == INVALID_POSITION || glm::dot(normalOf(bestWedge), normal) < NORMAL_CREASE_THRESHOLD) {
+					valid = false; // normal crease
+					break;
+				}
+
+				// Distinct vertices (texture seam) must stay distinct
+				for (const auto& m : wedgeMapping) {
+					if (m.second == bestWedge) {
+						valid = false;
+						break;
+					}
+				}
+
+				wedgeMapping.emplace_back(wedge, bestWedge);
+			}
+
+			if (!valid) {
+				continue;
+			}
+
+			// Apply collapse
+			for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+				auto triangle = &triangles[adjacency[i] * 3];
+				GLuint p[3] = { positionOf[triangle[0]], positionOf[triangle[1]], positionOf[triangle[2]] };
+
+				if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2]) {
+					continue;
+				}
+
+				for (auto k = 0; k < 3; k++) {
+					locked[p[k]] = true;
+				}
+
+				if (p[0] == to || p[1] == to || p[2] == to) {
+					// Degenerate, removed during compaction
+					auto k = (p[0] == from) ? 0 : (p[1] == from) ? 1 : 2;
+					triangle[k] = triangle[(k + 1) % 3];
+					numTriangles--;
+					continue;
+				}
+
+				for (auto k = 0; k < 3; k++) {
+					if (p[k] == from) {
+						auto mapped = std::find_if(wedgeMapping.begin(), wedgeMapping.end(),
+							[&](const std::pair<GLuint, GLuint>& m) { return m.first == triangle[k]; });
+						triangle[k] = mapped->second;
+					}
+				}
+			}
+
+			quadrics[to].Add(quadrics[from]);
+			reachedError = std::max(reachedError, collapse.error);
+			numCollapsed++;
+		}
+
+		// Remove degenerate triangles
+		size_t write = 0;
+		for (size_t i = 0; i < triangles.size(); i += 3) {
+			auto p0 = positionOf[triangles[i]];
+			auto p1 = positionOf[triangles[i + 1]];
+			auto p2 = positionOf[triangles[i + 2]];
+
+			if (p0 != p1 && p1 != p2 && p0 != p2) {
+				std::copy_n(&triangles[i], 3, &triangles[write]);
+				write += 3;
+			}
+		}
+		triangles.resize(write);
+
+		// Nothing (or almost nothing, e.g. along a crease) can be collapsed within the error limit
+		if (numCollapsed == 0 || numCollapsed < triangles.size() / 3 / MIN_PASS_COLLAPSES_RATIO) {
+			break;
+		}
+	}
+
+	resultError = static_cast<float>(std::sqrt(reachedError));
+	return triangles;
+}
@@ -0,0 +1,20 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include "MeshData.h"
+
+// Quadric error metric mesh simplification (Garland & Heckbert) used for LOD generation
+namespace MeshSimplifier {
+
+	// Collapse edges of given triangles until targetNumIndices is reached or the error would exceed maxError
+	// Vertices are collapsed into existing ones, so the result indexes the same mesh vertices
+	// Normal creases, texture seams and borders are preserved
+	// Return simplified indices, reached error (model space distance) is stored into resultError
+	std::vector<GLuint> Simplify(const MeshData& mesh,
+		const std::vector<GLuint>& indices,
+		size_t targetNumIndices,
+		float maxError,
+		float& resultError);
+}
+
+#endif
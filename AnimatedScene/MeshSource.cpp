@@ -0,0 +1,43 @@
+#include "MeshSource.h"
+
+#include <algorithm>
+
+MeshSource::MeshSource(const std::string& filepath)
+	: m_cache(MeshCache::Open(filepath))
+{
+	if (m_cache) {
+		// Mapped cache is handed to glBufferData directly, no copies
+		const auto& header = m_cache->GetHeader();
+		m_numIndices = m_cache->GetNumIndices();
+		m_indexType = m_cache->GetIndexType();
+		m_lods.assign(m_cache->GetLods(), m_cache->GetLods() + m_cache->GetNumLods());
+		std::copy_n(header.boundsMin, 3, m_boundsMin);
+		std::copy_n(header.boundsMax, 3, m_boundsMax);
+		return;
+	}
+
+	auto&& mesh = MeshData::ImportObjFile(filepath);
+	MeshCache::Write(filepath, mesh);
+
+	m_vertices = mesh.GetPackedVertices();
+	m_indices = mesh.GetPackedIndices();
+	m_numIndices = mesh.GetNumIndices();
+	m_indexType = mesh.GetIndexType();
+	m_lods = mesh.lods;
+	mesh.GetBounds(m_boundsMin, m_boundsMax);
+}
+
+const PackedVertex* MeshSource::GetVertices() const
+{
+	return m_cache ? m_cache->GetVertices() : m_vertices.data();
+}
+
+GLuint MeshSource::GetNumVertices() const
+{
+	return m_cache ? m_cache->GetNumVertices() : static_cast<GLuint>(m_vertices.size());
+}
+
+const void* MeshSource::GetIndices() const
+{
+	return m_cache ? m_cache->GetIndices() : m_indices.data();
+}
@@ -0,0 +1,51 @@
+#ifndef MESH_SOURCE_H
+#define MESH_SOURCE_H
+
+#include "MeshCache.h"
+#include "MeshData.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Mesh buffers in CPU memory ready for upload into VBOs
+// Does not touch OpenGL, so it can be loaded on any thread
+class MeshSource final {
+private:
+
+	// Either the mapped cache or freshly imported and packed mesh is used
+	std::unique_ptr<MeshCache> m_cache;
+	std::vector<PackedVertex> m_vertices;
+	std::vector<unsigned char> m_indices;
+	GLuint m_numIndices;
+	std::vector<MeshLod> m_lods;
+	GLenum m_indexType;
+	GLfloat m_boundsMin[3];
+	GLfloat m_boundsMax[3];
+
+public:
+
+	// Use binary mesh cache if it's up to date, otherwise import .obj file and write the cache
+	MeshSource(const std::string& filepath);
+
+	MeshSource(MeshSource&&) = default;
+	MeshSource& operator=(MeshSource&&) = default;
+
+	MeshSource(const MeshSource&) = delete;
+	MeshSource& operator=(const MeshSource&) = delete;
+
+	const PackedVertex* GetVertices() const;
+	GLuint GetNumVertices() const;
+	const void* GetIndices() const;
+	GLuint GetNumIndices() const { return m_numIndices; }
+	const std::vector<MeshLod>& GetLods() const { return m_lods; }
+	GLenum GetIndexType() const { return m_indexType; }
+	GLuint GetIndexSize() const { return m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+	// Size of vertex and index data in bytes (mapped or allocated)
+	size_t GetSize() const { return GetNumVertices() * sizeof(PackedVertex) + GetNumIndices() * GetIndexSize(); }
+
+	const GLfloat* GetBoundsMin() const { return m_boundsMin; }
+	const GLfloat* GetBoundsMax() const { return m_boundsMax; }
+};
+
+#endif
@@ -40,6 +40,8 @@ public:
 	void BindMirrorAsTexture() const { m_colorTexture.Bind(); }
 	void UnbindMirrorAsTexture() const { m_colorTexture.Unbind(); }
 
+	const Texture& GetTexture() const { return m_colorTexture; }
+
 	Camera GetReflectedCamera(const Camera& camera, const glm::vec3& reflection) const;
 };
 
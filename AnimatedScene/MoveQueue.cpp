@@ -0,0 +1,86 @@
+#include "MoveQueue.h"
+
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+
+MoveQueue::MoveQueue(float rotationTime)
+	: m_rotationTime(rotationTime),
+	m_speed(1.f),
+	m_lookahead(std::numeric_limits<size_t>::max())
+{
+}
+
+void MoveQueue::Clear()
+{
+	m_pending.clear();
+	m_active.clear();
+}
+
+bool MoveQueue::CanStartPending() const
+{
+	if (m_pending.empty()) {
+		return false;
+	}
+
+	auto& move = m_pending.front();
+
+	for (const auto& active : m_active) {
+		if (active.move.axis != move.axis || active.move.layer == move.layer) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void MoveQueue::FinishActive(const ApplyFunction& apply)
+{
+	for (const auto& active : m_active) {
+		apply(active.move);
+	}
+	m_active.clear();
+}
+
+float MoveQueue::GetAngle(const ActiveMove& active) const
+{
+	auto progress = std::min(active.time / m_rotationTime, 1.f);
+	return progress * glm::half_pi<float>() * (active.move.clockwise ? 1.f : -1.f);
+}
+
+void MoveQueue::Update(float deltaTime, const ApplyFunction& apply)
+{
+	// Moves must change the cube in order, the skipped ones come after the active ones
+	if (m_pending.size() > m_lookahead) {
+		FinishActive(apply);
+
+		while (m_pending.size() > m_lookahead) {
+			apply(m_pending.front());
+			m_pending.pop_front();
+		}
+	}
+
+	// Active moves commute, finish order does not matter
+	auto finished = std::stable_partition(m_active.begin(), m_active.end(), [&](ActiveMove& active) {
+		active.time += deltaTime * m_speed;
+		return active.time < m_rotationTime;
+	});
+
+	for (auto it = finished; it != m_active.end(); it++) {
+		apply(it->move);
+	}
+	m_active.erase(finished, m_active.end());
+
+	while (CanStartPending()) {
+		m_active.push_back(ActiveMove{ m_pending.front(), 0.f });
+		m_pending.pop_front();
+	}
+}
+
+void MoveQueue::Finish(const ApplyFunction& apply)
+{
+	FinishActive(apply);
+
+	for (const auto& move : m_pending) {
+		apply(move);
+	}
+	m_pending.clear();
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef MOVE_QUEUE_H
+#define MOVE_QUEUE_H
+
+#include "CubeState.h"
+
+#include <deque>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// Schedules animated cube moves, no OpenGL is needed
+// Moves on the same axis, but different layers, are animated at the same time
+// Moves beyond the lookahead window are applied at once without any animation
+class MoveQueue final {
+public:
+
+	// Move being animated, time runs from zero to rotation time
+	struct ActiveMove {
+		CubeState::Move move;
+		float time;
+	};
+
+	// Called with every finished (or skipped) move in the order they change the cube
+	using ApplyFunction = std::function<void(const CubeState::Move&)>;
+
+private:
+
+	std::deque<CubeState::Move> m_pending;
+	std::vector<ActiveMove> m_active;
+
+	float m_rotationTime;
+	float m_speed;
+	size_t m_lookahead;
+
+	// Front pending move commutes with all active ones
+	bool CanStartPending() const;
+
+	void FinishActive(const ApplyFunction& apply);
+
+public:
+
+	MoveQueue(float rotationTime = 1.f);
+
+	void Push(const CubeState::Move& move) { m_pending.push_back(move); }
+	void Push(const std::vector<CubeState::Move>& moves) { m_pending.insert(m_pending.end(), moves.begin(), moves.end()); }
+
+	// Drop all moves, none of them is applied
+	void Clear();
+
+	bool IsIdle() const { return m_pending.empty() && m_active.empty(); }
+	size_t GetNumPending() const { return m_pending.size(); }
+
+	// Time compression, 2 plays moves twice as fast
+	void SetSpeed(float speed) { m_speed = speed; }
+	float GetSpeed() const { return m_speed; }
+
+	// Only this many pending moves are animated, the older ones are applied at once
+	void SetLookahead(size_t numMoves = std::numeric_limits<size_t>::max()) { m_lookahead = numMoves; }
+	size_t GetLookahead() const { return m_lookahead; }
+
+	// All active moves share the same axis
+	const std::vector<ActiveMove>& GetActiveMoves() const { return m_active; }
+
+	// Rotation angle of the active move's layer in radians
+	float GetAngle(const ActiveMove& active) const;
+
+	void Update(float deltaTime, const ApplyFunction& apply);
+
+	// Apply all moves at once
+	void Finish(const ApplyFunction& apply);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "MoveSequence.h"
+
+#include <map>
+
+namespace {
+	// Moves of one axis, clockwise quarter turns of every layer modulo 4 (only non-zero ones are kept)
+	struct AxisRun {
+		CubeState::Axis axis;
+		std::map<unsigned int, unsigned int> turns;
+	};
+}
+
+size_t MoveSequence::Canonicalize(std::vector<CubeState::Move>& moves)
+{
+	std::vector<AxisRun> runs;
+
+	for (const auto& move : moves) {
+		if (runs.empty() || runs.back().axis != move.axis) {
+			runs.push_back(AxisRun{ move.axis, {} });
+		}
+
+		auto& turns = runs.back().turns;
+		auto count = (turns[move.layer] + (move.clockwise ? 1u : 3u)) % 4;
+
+		if (count != 0) {
+			turns[move.layer] = count;
+			continue;
+		}
+
+		turns.erase(move.layer);
+		if (turns.empty()) {
+			runs.pop_back();
+		}
+	}
+
+	auto numMoves = moves.size();
+	moves.clear();
+
+	for (const auto& run : runs) {
+		for (const auto& turn : run.turns) {
+			CubeState::Move move{ run.axis, turn.first, turn.second != 3 };
+			moves.insert(moves.end(), (turn.second == 2) ? 2 : 1, move);
+		}
+	}
+	return numMoves - moves.size();
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef MOVE_SEQUENCE_H
+#define MOVE_SEQUENCE_H
+
+#include "CubeState.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace MoveSequence {
+
+	// Rewrite moves into minimal equivalent sequence, return number of removed moves
+	// Consecutive moves on the same axis commute, so they are merged into one quarter turn per layer
+	// (half turn is two clockwise moves) in the order of layers, layers with whole turns are dropped
+	// Runs left empty let their neighbours on the same axis merge too, e.g. X Y Y' X' cancels completely
+	size_t Canonicalize(std::vector<CubeState::Move>& moves);
+}
+
+#endif
\ No newline at end of file
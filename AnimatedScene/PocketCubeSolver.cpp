@@ -0,0 +1,515 @@
+#include "PocketCubeSolver.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+	static_assert(sizeof(PocketCubeTableHeader) == 16, "Pocket cube table header must stay packed");
+
+	const auto TABLE_PATH = "Data/PocketCubeSolver.tables";
+
+	const unsigned int NUM_CORNERS = 8;
+	const unsigned int NUM_FACES = 3;
+	const unsigned int UNKNOWN_DISTANCE = 3;
+
+	const size_t DISTANCES_OFFSET = sizeof(PocketCubeTableHeader);
+	const size_t TABLE_SIZE = DISTANCES_OFFSET + (PocketCubeSolver::NUM_STATES + 3) / 4;
+
+	// BFS level is split into this many tasks per worker, frontier is not spread evenly over the states
+	const unsigned int TASKS_PER_WORKER = 8;
+
+	// Faces in move order U, R, F
+	// Move m turns face m / 3 (m % 3 + 1) times clockwise, none of them moves the DBL corner
+	const CubeState::Move FACE_MOVES[NUM_FACES] = {
+		{ CubeState::Y_AXIS, 1, true },
+		{ CubeState::X_AXIS, 1, true },
+		{ CubeState::Z_AXIS, 1, true },
+	};
+
+	struct Facelet {
+		CubeState::Face face;
+		unsigned int x;
+		unsigned int y;
+	};
+
+	// Stickers of every corner position, the first lies on U or D face, the others follow in the same rotational direction
+	// Position 0 is the fixed DBL corner
+	const Facelet CORNER_FACELETS[NUM_CORNERS][3] = {
+		{ { CubeState::BOTTOM, 0, 1 }, { CubeState::LEFT, 0, 0 }, { CubeState::BACK, 0, 0 } }, // DBL
+		{ { CubeState::BOTTOM, 0, 0 }, { CubeState::FRONT, 0, 1 }, { CubeState::LEFT, 0, 1 } }, // DFL
+		{ { CubeState::TOP, 0, 0 }, { CubeState::BACK, 0, 1 }, { CubeState::LEFT, 1, 0 } }, // UBL
+		{ { CubeState::TOP, 0, 1 }, { CubeState::LEFT, 1, 1 }, { CubeState::FRONT, 0, 0 } }, // UFL
+		{ { CubeState::BOTTOM, 1, 1 }, { CubeState::BACK, 1, 0 }, { CubeState::RIGHT, 1, 0 } }, // DBR
+		{ { CubeState::BOTTOM, 1, 0 }, { CubeState::RIGHT, 1, 1 }, { CubeState::FRONT, 1, 1 } }, // DFR
+		{ { CubeState::TOP, 1, 0 }, { CubeState::RIGHT, 0, 0 }, { CubeState::BACK, 1, 1 } }, // UBR
+		{ { CubeState::TOP, 1, 1 }, { CubeState::FRONT, 1, 0 }, { CubeState::RIGHT, 0, 1 } }, // UFR
+	};
+
+	// Corner at position i and it's orientation
+	struct CornerCube {
+		std::array<uint8_t, NUM_CORNERS> cp;
+		std::array<uint8_t, NUM_CORNERS> co;
+	};
+
+	CornerCube GetSolvedCorners()
+	{
+		CornerCube cube = {};
+
+		for (auto i = 0u; i < NUM_CORNERS; i++) {
+			cube.cp[i] = static_cast<uint8_t>(i);
+		}
+		return cube;
+	}
+
+	// Cube a followed by moves of cube b
+	CornerCube Multiply(const CornerCube& a, const CornerCube& b)
+	{
+		CornerCube cube;
+
+		for (auto i = 0u; i < NUM_CORNERS; i++) {
+			cube.cp[i] = a.cp[b.cp[i]];
+			cube.co[i] = (a.co[b.cp[i]] + b.co[i]) % 3;
+		}
+		return cube;
+	}
+
+	CornerCube GetCorners(const CubeState& state)
+	{
+		if (state.GetNumStickersPerEdge() != 2) {
+			throw std::runtime_error("Only 2x2 cube can be solved by pocket cube solver");
+		}
+
+		auto getColor = [&](const Facelet& facelet) { return state.Get(facelet.face, facelet.x, facelet.y); };
+		auto hasColor = [&](unsigned int position, unsigned char color) {
+			auto& facelets = CORNER_FACELETS[position];
+			return getColor(facelets[0]) == color || getColor(facelets[1]) == color || getColor(facelets[2]) == color;
+		};
+
+		// Colors of D, L and B faces are given by the fixed corner, each opposite color is the third one
+		// of the corner sharing the other two of them
+		std::array<int, 256> colorFaces;
+		colorFaces.fill(-1);
+
+		unsigned char fixed[3] = { getColor(CORNER_FACELETS[0][0]), getColor(CORNER_FACELETS[0][1]), getColor(CORNER_FACELETS[0][2]) };
+		unsigned char colors[CubeState::NUM_FACES] = {};
+		bool found[CubeState::NUM_FACES] = {};
+
+		for (auto i = 0u; i < 3; i++) {
+			colors[CORNER_FACELETS[0][i].face] = fixed[i];
+			found[CORNER_FACELETS[0][i].face] = true;
+
+			auto first = fixed[(i + 1) % 3];
+			auto second = fixed[(i + 2) % 3];
+
+			for (auto position = 1u; position < NUM_CORNERS; position++) {
+				if (hasColor(position, fixed[i]) || !hasColor(position, first) || !hasColor(position, second)) {
+					continue;
+				}
+				for (auto& facelet : CORNER_FACELETS[position]) {
+					auto color = getColor(facelet);
+
+					if (color != first && color != second) {
+						auto opposite = (CORNER_FACELETS[0][i].face == CubeState::BOTTOM) ? CubeState::TOP
+							: (CORNER_FACELETS[0][i].face == CubeState::LEFT) ? CubeState::RIGHT : CubeState::FRONT;
+						colors[opposite] = color;
+						found[opposite] = true;
+					}
+				}
+			}
+		}
+
+		for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+			if (!found[face] || colorFaces[colors[face]] >= 0) {
+				throw std::runtime_error("Invalid cube state: faces do not have distinct colors");
+			}
+			colorFaces[colors[face]] = face;
+		}
+
+		CornerCube cube = {};
+		std::array<bool, NUM_CORNERS> usedCorners = {};
+		auto twist = 0u;
+
+		for (auto position = 0u; position < NUM_CORNERS; position++) {
+			auto& facelets = CORNER_FACELETS[position];
+			int faces[3] = { colorFaces[getColor(facelets[0])], colorFaces[getColor(facelets[1])], colorFaces[getColor(facelets[2])] };
+			auto matched = false;
+
+			for (auto corner = 0u; corner < NUM_CORNERS && !matched; corner++) {
+				auto& home = CORNER_FACELETS[corner];
+
+				// Same stickers in the same rotational order
+				for (auto orientation = 0u; orientation < 3 && !matched; orientation++) {
+					if (faces[orientation] == home[0].face && faces[(orientation + 1) % 3] == home[1].face
+						&& faces[(orientation + 2) % 3] == home[2].face) {
+						cube.cp[position] = static_cast<uint8_t>(corner);
+						cube.co[position] = static_cast<uint8_t>(orientation);
+						matched = !usedCorners[corner];
+						usedCorners[corner] = true;
+					}
+				}
+			}
+
+			if (!matched) {
+				throw std::runtime_error("Invalid cube state: corner does not exist or repeats");
+			}
+			twist += cube.co[position];
+		}
+
+		if (twist % 3 != 0) {
+			throw std::runtime_error("Invalid cube state: twisted corner");
+		}
+		return cube;
+	}
+
+	std::array<CornerCube, PocketCubeSolver::NUM_MOVES> GetMoveCorners()
+	{
+		std::array<CornerCube, PocketCubeSolver::NUM_MOVES> moves;
+
+		for (auto face = 0u; face < NUM_FACES; face++) {
+			CubeState state(2);
+			state.RotateLayer(FACE_MOVES[face]);
+
+			auto&& quarter = GetCorners(state);
+			moves[face * 3] = quarter;
+			moves[face * 3 + 1] = Multiply(quarter, quarter);
+			moves[face * 3 + 2] = Multiply(moves[face * 3 + 1], quarter);
+		}
+		return moves;
+	}
+
+	// Lehmer code of corners 1 - 7 (the fixed corner 0 is left out)
+	unsigned int GetPermutation(const CornerCube& cube)
+	{
+		auto rank = 0u;
+
+		for (auto i = 1u; i < NUM_CORNERS; i++) {
+			auto smaller = 0u;
+
+			for (auto j = i + 1; j < NUM_CORNERS; j++) {
+				smaller += cube.cp[j] < cube.cp[i] ? 1u : 0u;
+			}
+			rank = rank * (NUM_CORNERS - i) + smaller;
+		}
+		return rank;
+	}
+
+	void SetPermutation(CornerCube& cube, unsigned int rank)
+	{
+		unsigned int digits[NUM_CORNERS] = {};
+
+		for (auto i = NUM_CORNERS; i-- > 1;) {
+			digits[i] = rank % (NUM_CORNERS - i);
+			rank /= NUM_CORNERS - i;
+		}
+
+		std::vector<uint8_t> available = { 1, 2, 3, 4, 5, 6, 7 };
+		cube.cp[0] = 0;
+
+		for (auto i = 1u; i < NUM_CORNERS; i++) {
+			cube.cp[i] = available[digits[i]];
+			available.erase(available.begin() + digits[i]);
+		}
+	}
+
+	// Orientations of corners 1 - 6 in base 3
+	unsigned int GetTwist(const CornerCube& cube)
+	{
+		auto twist = 0u;
+
+		for (auto i = 1u; i < NUM_CORNERS - 1; i++) {
+			twist = twist * 3 + cube.co[i];
+		}
+		return twist;
+	}
+
+	void SetTwist(CornerCube& cube, unsigned int twist)
+	{
+		auto sum = 0u;
+
+		for (auto i = NUM_CORNERS - 1; i-- > 1;) {
+			cube.co[i] = static_cast<uint8_t>(twist % 3);
+			sum += cube.co[i];
+			twist /= 3;
+		}
+		cube.co[0] = 0;
+		cube.co[NUM_CORNERS - 1] = static_cast<uint8_t>((3 - sum % 3) % 3);
+	}
+
+	unsigned int GetIndex(const CornerCube& cube)
+	{
+		return GetPermutation(cube) * PocketCubeSolver::NUM_TWISTS + GetTwist(cube);
+	}
+}
+
+std::string PocketCubeSolver::GetDefaultTablePath()
+{
+	return TABLE_PATH;
+}
+
+size_t PocketCubeSolver::GetTableSize()
+{
+	return TABLE_SIZE;
+}
+
+std::vector<char> PocketCubeSolver::GenerateTable(TaskPool& pool) const
+{
+	static const size_t NUM_DISTANCE_WORDS = (NUM_STATES + 31) / 32;
+	static const size_t NUM_FRONTIER_WORDS = (NUM_STATES + 63) / 64;
+
+	// 2 bits per state, all ones is unknown distance, so the first visit only clears bits
+	std::vector<std::atomic<uint64_t>> distances(NUM_DISTANCE_WORDS);
+	for (auto& word : distances) {
+		word.store(~uint64_t(0), std::memory_order_relaxed);
+	}
+
+	// Bitmaps of states of the current and the next level
+	std::vector<std::atomic<uint64_t>> frontier(NUM_FRONTIER_WORDS);
+	std::vector<std::atomic<uint64_t>> next(NUM_FRONTIER_WORDS);
+	for (size_t i = 0; i < NUM_FRONTIER_WORDS; i++) {
+		frontier[i].store(0, std::memory_order_relaxed);
+		next[i].store(0, std::memory_order_relaxed);
+	}
+
+	distances[0].fetch_and(~uint64_t(UNKNOWN_DISTANCE));
+	frontier[0].store(1);
+
+	auto numTasks = pool.GetNumWorkers() * TASKS_PER_WORKER;
+	auto chunkSize = (NUM_FRONTIER_WORDS + numTasks - 1) / numTasks;
+	auto maxDistance = 0u;
+
+	for (auto depth = 1u; ; depth++) {
+		std::atomic<size_t> numVisited(0);
+		auto distance = depth % 3;
+
+		for (size_t begin = 0; begin < NUM_FRONTIER_WORDS; begin += chunkSize) {
+			auto end = std::min(begin + chunkSize, NUM_FRONTIER_WORDS);
+
+			pool.Submit([&, begin, end, distance]() {
+				size_t visited = 0;
+
+				for (auto i = begin; i < end; i++) {
+					auto bits = frontier[i].load(std::memory_order_relaxed);
+
+					for (auto bit = 0u; bits != 0; bit++, bits >>= 1) {
+						if ((bits & 1) == 0) {
+							continue;
+						}
+						auto index = static_cast<unsigned int>(i * 64 + bit);
+
+						for (auto move = 0u; move < NUM_MOVES; move++) {
+							auto neighbour = GetNeighbour(index, move);
+							auto& word = distances[neighbour / 32];
+							auto shift = neighbour % 32 * 2;
+
+							// States of earlier levels are never written again, states of this level get the same value
+							if (((word.load(std::memory_order_relaxed) >> shift) & 3u) != UNKNOWN_DISTANCE) {
+								continue;
+							}
+							auto old = word.fetch_and(~(uint64_t(UNKNOWN_DISTANCE ^ distance) << shift), std::memory_order_relaxed);
+
+							if (((old >> shift) & 3u) == UNKNOWN_DISTANCE) {
+								next[neighbour / 64].fetch_or(uint64_t(1) << (neighbour % 64), std::memory_order_relaxed);
+								visited++;
+							}
+						}
+					}
+				}
+				numVisited += visited;
+			});
+		}
+
+		pool.Wait();
+
+		if (numVisited == 0) {
+			break;
+		}
+		maxDistance = depth;
+
+		for (size_t i = 0; i < NUM_FRONTIER_WORDS; i++) {
+			frontier[i].store(next[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			next[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	std::vector<char> table(TABLE_SIZE);
+	auto header = reinterpret_cast<PocketCubeTableHeader*>(table.data());
+	header->magic = MAGIC;
+	header->version = VERSION;
+	header->numStates = NUM_STATES;
+	header->maxDistance = maxDistance;
+
+	// Byte order of the file does not depend on the platform
+	auto bytes = reinterpret_cast<uint8_t*>(table.data() + DISTANCES_OFFSET);
+	for (size_t i = 0; i < TABLE_SIZE - DISTANCES_OFFSET; i++) {
+		bytes[i] = static_cast<uint8_t>(distances[i / 8].load(std::memory_order_relaxed) >> (i % 8 * 8));
+	}
+	return table;
+}
+
+bool PocketCubeSolver::WriteTable(const std::string& tablePath, const std::vector<char>& table)
+{
+	auto temporaryPath = Utils::GetTemporaryPath(tablePath);
+
+	try {
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			file.write(table.data(), table.size());
+
+			if (!file.good()) {
+				throw std::runtime_error("Unable to write pocket cube table: " + temporaryPath);
+			}
+		}
+
+		// Never leave half-written table behind
+		std::filesystem::rename(temporaryPath, tablePath);
+		return true;
+	}
+	catch (const std::exception&) {
+		std::error_code error;
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+}
+
+std::unique_ptr<MappedFile> PocketCubeSolver::OpenTable(const std::string& tablePath)
+{
+	std::error_code error;
+
+	if (!std::filesystem::exists(tablePath, error)) {
+		return nullptr;
+	}
+
+	try {
+		auto file = std::make_unique<MappedFile>(tablePath);
+
+		if (file->GetSize() != TABLE_SIZE) {
+			return nullptr;
+		}
+
+		auto header = reinterpret_cast<const PocketCubeTableHeader*>(file->GetData());
+
+		if (header->magic != MAGIC || header->version != VERSION || header->numStates != NUM_STATES) {
+			return nullptr;
+		}
+		return file;
+	}
+	catch (const std::exception&) {
+		// Unreadable table is as good as no table
+		return nullptr;
+	}
+}
+
+void PocketCubeSolver::SetTable(const char* data)
+{
+	m_distances = reinterpret_cast<const uint8_t*>(data + DISTANCES_OFFSET);
+	m_maxDistance = reinterpret_cast<const PocketCubeTableHeader*>(data)->maxDistance;
+}
+
+PocketCubeSolver::PocketCubeSolver(const std::string& tablePath, unsigned int numThreads)
+	: m_distances(nullptr),
+	m_maxDistance(0),
+	m_generated(false),
+	m_permutationMoves(NUM_PERMUTATIONS * NUM_MOVES),
+	m_twistMoves(NUM_TWISTS * NUM_MOVES)
+{
+	auto&& moveCorners = GetMoveCorners();
+	auto cube = GetSolvedCorners();
+
+	for (auto permutation = 0u; permutation < NUM_PERMUTATIONS; permutation++) {
+		SetPermutation(cube, permutation);
+		for (auto move = 0u; move < NUM_MOVES; move++) {
+			m_permutationMoves[permutation * NUM_MOVES + move] = static_cast<uint16_t>(GetPermutation(Multiply(cube, moveCorners[move])));
+		}
+	}
+
+	cube = GetSolvedCorners();
+
+	for (auto twist = 0u; twist < NUM_TWISTS; twist++) {
+		SetTwist(cube, twist);
+		for (auto move = 0u; move < NUM_MOVES; move++) {
+			m_twistMoves[twist * NUM_MOVES + move] = static_cast<uint16_t>(GetTwist(Multiply(cube, moveCorners[move])));
+		}
+	}
+
+	m_file = OpenTable(tablePath);
+
+	if (!m_file) {
+		TaskPool pool(numThreads);
+		m_buffer = GenerateTable(pool);
+		m_generated = true;
+
+		// Generated table stays in memory if it cannot be written, the next run generates it again
+		if (WriteTable(tablePath, m_buffer)) {
+			m_file = OpenTable(tablePath);
+		}
+	}
+
+	if (m_file) {
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+		SetTable(m_file->GetData());
+	}
+	else {
+		SetTable(m_buffer.data());
+	}
+}
+
+unsigned int PocketCubeSolver::GetNeighbour(unsigned int index, unsigned int move) const
+{
+	auto permutation = index / NUM_TWISTS;
+	auto twist = index % NUM_TWISTS;
+
+	return m_permutationMoves[permutation * NUM_MOVES + move] * NUM_TWISTS + m_twistMoves[twist * NUM_MOVES + move];
+}
+
+std::vector<unsigned int> PocketCubeSolver::GetFaceTurns(unsigned int index) const
+{
+	std::vector<unsigned int> faceTurns;
+
+	// Every state but the solved one has neighbour with distance one less, it's found by the distance modulo 3
+	while (index != 0) {
+		auto closer = (GetStoredDistance(index) + 2) % 3;
+		auto found = false;
+
+		for (auto move = 0u; move < NUM_MOVES && !found; move++) {
+			auto neighbour = GetNeighbour(index, move);
+
+			if (GetStoredDistance(neighbour) == closer) {
+				faceTurns.push_back(move);
+				index = neighbour;
+				found = true;
+			}
+		}
+
+		if (!found) {
+			throw std::runtime_error("Pocket cube table is corrupted");
+		}
+	}
+	return faceTurns;
+}
+
+unsigned int PocketCubeSolver::GetDistance(const CubeState& state) const
+{
+	return static_cast<unsigned int>(GetFaceTurns(GetIndex(GetCorners(state))).size());
+}
+
+void PocketCubeSolver::Solve(const CubeState& state, std::vector<CubeState::Move>& solution) const
+{
+	solution.clear();
+
+	for (auto move : GetFaceTurns(GetIndex(GetCorners(state)))) {
+		auto faceMove = FACE_MOVES[move / 3];
+		auto power = move % 3 + 1;
+
+		if (power == 3) {
+			faceMove.clockwise = false;
+			power = 1;
+		}
+		solution.insert(solution.end(), power, faceMove);
+	}
+}
\ No newline at end of file
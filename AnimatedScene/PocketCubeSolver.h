@@ -0,0 +1,99 @@
+#ifndef POCKET_CUBE_SOLVER_H
+#define POCKET_CUBE_SOLVER_H
+
+#include "CubeState.h"
+#include "MappedFile.h"
+#include "TaskPool.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Header of binary distance table file, 2 bits per state follow (4 states per byte, lowest bits first)
+struct PocketCubeTableHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numStates;
+	uint32_t maxDistance;
+};
+
+// Optimal solver of 2x2 cube by table of distances of all it's states
+// Corner at the left, bottom and back stays in place (only U, R and F faces turn),
+// so the state is given by permutation and orientation of the other 7 corners
+// Distances are stored modulo 3, neighbour one turn closer to the solved state is still recognized
+// The table is generated by parallel breadth first search once, written to disk and memory mapped on later runs
+class PocketCubeSolver final {
+public:
+
+	static constexpr uint32_t MAGIC = 0x43504341u; // "ACPC"
+	static constexpr uint32_t VERSION = 1u;
+
+	static constexpr unsigned int NUM_MOVES = 9; // U, R, F faces x 3 powers
+	static constexpr unsigned int NUM_PERMUTATIONS = 5040; // 7!
+	static constexpr unsigned int NUM_TWISTS = 729; // 3^6, twist of the last corner is given by the others
+	static constexpr unsigned int NUM_STATES = NUM_PERMUTATIONS * NUM_TWISTS;
+
+private:
+
+	std::unique_ptr<MappedFile> m_file;
+	std::vector<char> m_buffer;
+	const uint8_t* m_distances;
+	unsigned int m_maxDistance;
+	bool m_generated;
+
+	// Coordinate move tables are small enough to be built on every run
+	std::vector<uint16_t> m_permutationMoves;
+	std::vector<uint16_t> m_twistMoves;
+
+	// Generate the table into the buffer (header included) by tasks of the pool
+	std::vector<char> GenerateTable(TaskPool& pool) const;
+
+	// Return false if the table cannot be written, it's not fatal
+	static bool WriteTable(const std::string& tablePath, const std::vector<char>& table);
+
+	// Return nullptr if there is no table or if it's stale
+	static std::unique_ptr<MappedFile> OpenTable(const std::string& tablePath);
+
+	void SetTable(const char* data);
+
+	unsigned int GetStoredDistance(unsigned int index) const { return (m_distances[index / 4] >> (index % 4 * 2)) & 3u; }
+
+	// Index of the state after given move
+	unsigned int GetNeighbour(unsigned int index, unsigned int move) const;
+
+	// Face turns of optimal solution of the state with given index
+	std::vector<unsigned int> GetFaceTurns(unsigned int index) const;
+
+public:
+
+	// Table file next to the mesh caches
+	static std::string GetDefaultTablePath();
+
+	// Size of the table file in bytes
+	static size_t GetTableSize();
+
+	// Map the table from given file, generate (and write) it if the file is missing or stale
+	// Generation runs on given number of threads, zero means one per hardware thread
+	PocketCubeSolver(const std::string& tablePath = GetDefaultTablePath(), unsigned int numThreads = 0);
+
+	PocketCubeSolver(const PocketCubeSolver&) = delete;
+	PocketCubeSolver& operator=(const PocketCubeSolver&) = delete;
+
+	// True if the table was generated by this instance, not mapped from disk
+	bool WereTablesGenerated() const { return m_generated; }
+
+	// Largest distance of any state in face turns (God's number of the 2x2 cube)
+	unsigned int GetMaxDistance() const { return m_maxDistance; }
+
+	// Number of face turns of optimal solution
+	// May throw an exception if the state is not a valid 2x2 cube
+	unsigned int GetDistance(const CubeState& state) const;
+
+	// Optimal solution by turns of U, R and F faces, half turns are two moves of the solution
+	// The cube is solved in orientation given by the corner at the left, bottom and back
+	// May throw an exception if the state is not a valid 2x2 cube
+	void Solve(const CubeState& state, std::vector<CubeState::Move>& solution) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef RANDOM_GENERATOR_H
+#define RANDOM_GENERATOR_H
+
+#include <cstdint>
+#include <limits>
+
+// xoshiro256** pseudo random generator, state is seeded by splitmix64
+// Same seed gives the same sequence on every platform, unlike rand()
+// Satisfies UniformRandomBitGenerator, so it works with <random> distributions and std::shuffle
+class RandomGenerator final {
+private:
+
+	uint64_t m_state[4];
+
+	static uint64_t RotateLeft(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+
+	using result_type = uint64_t;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	RandomGenerator(uint64_t seed = 0) { Seed(seed); }
+
+	void Seed(uint64_t seed)
+	{
+		for (auto& word : m_state) {
+			seed += 0x9E3779B97F4A7C15ull;
+			auto z = seed;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			word = z ^ (z >> 31);
+		}
+	}
+
+	result_type operator()()
+	{
+		auto result = RotateLeft(m_state[1] * 5, 7) * 9;
+		auto t = m_state[1] << 17;
+
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = RotateLeft(m_state[3], 45);
+		return result;
+	}
+
+	// Unbiased number in [0, bound), bound must not be zero
+	// Multiply and shift of the upper 32 bits, rare values of the lower product are rejected
+	uint32_t Below(uint32_t bound)
+	{
+		auto product = ((*this)() >> 32) * bound;
+
+		if (static_cast<uint32_t>(product) < bound) {
+			auto threshold = (0u - bound) % bound;
+
+			while (static_cast<uint32_t>(product) < threshold) {
+				product = ((*this)() >> 32) * bound;
+			}
+		}
+		return static_cast<uint32_t>(product >> 32);
+	}
+};
+
+#endif
\ No newline at end of file
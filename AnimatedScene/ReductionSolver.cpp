@@ -0,0 +1,651 @@
+#include "ReductionSolver.h"
+#include "CubeGeometry.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+	// Piece of the cube is a set of stickers, center or edge wing pieces are permuted within their orbits
+	const unsigned int MAX_ORBIT_SLOTS = 24;
+
+	// Marks of setup table, other values are generator indices
+	const uint8_t NOT_VISITED = 0xFF;
+	const uint8_t CYCLE = 0xFE;
+	const uint8_t INVERSE_CYCLE = 0xFD;
+
+	typedef CubeGeometry::Vector Vector;
+	typedef CubeGeometry::Sticker Sticker;
+
+	// Stickers of one piece position, moves keep their order
+	typedef std::vector<Sticker> Slot;
+
+	// Positions of interchangeable pieces, moves map slots of orbit onto itself
+	struct Orbit {
+		std::vector<Slot> slots;
+
+		// Moves used by setups, generator 2k + 1 is inverse of generator 2k
+		std::vector<CubeState::Move> generators;
+
+		// Piece in slot i moves into slot permutations[g][i] by generator g
+		std::vector<std::array<uint8_t, MAX_ORBIT_SLOTS>> permutations;
+
+		// Pure commutator (generator indices) cycling pieces of slots a -> b -> c
+		std::vector<unsigned int> cycle;
+		std::array<uint8_t, 3> cycleSlots;
+
+		// First setup generator of every slot triple, setup moves the triple into cycle slots
+		// Orbits of the same shape share the table
+		std::shared_ptr<const std::vector<uint8_t>> setups;
+	};
+
+	// Outer layers and given inner layers of every axis, each move followed by it's inverse
+	std::vector<CubeState::Move> GetGenerators(unsigned int numStickersEdge, std::vector<unsigned int> layers)
+	{
+		layers.push_back(0);
+		layers.push_back(numStickersEdge - 1);
+		std::sort(layers.begin(), layers.end());
+		layers.erase(std::unique(layers.begin(), layers.end()), layers.end());
+
+		std::vector<CubeState::Move> generators;
+
+		for (auto layer : layers) {
+			for (auto axis : { CubeState::X_AXIS, CubeState::Y_AXIS, CubeState::Z_AXIS }) {
+				generators.push_back(CubeState::Move{ axis, layer, true });
+				generators.push_back(CubeState::Move{ axis, layer, false });
+			}
+		}
+		return generators;
+	}
+
+	unsigned int FindGenerator(const Orbit& orbit, const CubeState::Move& move)
+	{
+		for (size_t g = 0; g < orbit.generators.size(); g++) {
+			auto& generator = orbit.generators[g];
+
+			if (generator.axis == move.axis && generator.layer == move.layer && generator.clockwise == move.clockwise) {
+				return static_cast<unsigned int>(g);
+			}
+		}
+		throw std::runtime_error("Move is not a generator of the orbit");
+	}
+
+	// Orbit of the slot under given generators
+	Orbit BuildOrbit(const Slot& start, const std::vector<CubeState::Move>& generators, unsigned int numStickersEdge)
+	{
+		Orbit orbit;
+		orbit.generators = generators;
+		orbit.permutations.resize(generators.size());
+		orbit.slots.push_back(start);
+
+		for (size_t i = 0; i < orbit.slots.size(); i++) {
+			for (size_t g = 0; g < generators.size(); g++) {
+				Slot moved;
+
+				for (const auto& sticker : orbit.slots[i]) {
+					moved.push_back(CubeGeometry::MoveSticker(sticker, generators[g], numStickersEdge));
+				}
+
+				auto found = std::find_if(orbit.slots.begin(), orbit.slots.end(), [&](const Slot& slot) {
+					return std::find(slot.begin(), slot.end(), moved.front()) != slot.end();
+				});
+
+				if (found == orbit.slots.end()) {
+					if (orbit.slots.size() == MAX_ORBIT_SLOTS) {
+						throw std::runtime_error("Orbit of pieces is too large");
+					}
+					orbit.slots.push_back(moved);
+					found = orbit.slots.end() - 1;
+				}
+				else if (*found != moved) {
+					throw std::runtime_error("Pieces of orbit cannot be flipped");
+				}
+
+				orbit.permutations[g][i] = static_cast<uint8_t>(found - orbit.slots.begin());
+			}
+		}
+		return orbit;
+	}
+
+	// Commutator has to move exactly three slots
+	void SetCycle(Orbit& orbit, const std::vector<CubeState::Move>& moves)
+	{
+		std::array<uint8_t, MAX_ORBIT_SLOTS> permutation;
+
+		for (size_t i = 0; i < orbit.slots.size(); i++) {
+			permutation[i] = static_cast<uint8_t>(i);
+		}
+
+		orbit.cycle.clear();
+		for (const auto& move : moves) {
+			auto g = FindGenerator(orbit, move);
+			orbit.cycle.push_back(g);
+
+			for (size_t i = 0; i < orbit.slots.size(); i++) {
+				permutation[i] = orbit.permutations[g][permutation[i]];
+			}
+		}
+
+		std::vector<uint8_t> moved;
+		for (size_t i = 0; i < orbit.slots.size(); i++) {
+			if (permutation[i] != i) {
+				moved.push_back(static_cast<uint8_t>(i));
+			}
+		}
+
+		if (moved.size() != 3) {
+			throw std::runtime_error("Commutator does not cycle three pieces");
+		}
+		orbit.cycleSlots = { moved[0], permutation[moved[0]], permutation[permutation[moved[0]]] };
+	}
+
+	// Breadth first search from cycle slots over all slot triples
+	std::vector<uint8_t> BuildSetups(const Orbit& orbit)
+	{
+		auto numSlots = static_cast<unsigned int>(orbit.slots.size());
+		auto encode = [numSlots](unsigned int a, unsigned int b, unsigned int c) { return (a * numSlots + b) * numSlots + c; };
+
+		std::vector<uint8_t> setups(numSlots * numSlots * numSlots, NOT_VISITED);
+		std::vector<unsigned int> queue;
+
+		auto a = orbit.cycleSlots[0];
+		auto b = orbit.cycleSlots[1];
+		auto c = orbit.cycleSlots[2];
+
+		for (auto root : { encode(a, b, c), encode(b, c, a), encode(c, a, b) }) {
+			setups[root] = CYCLE;
+			queue.push_back(root);
+		}
+		for (auto root : { encode(a, c, b), encode(c, b, a), encode(b, a, c) }) {
+			setups[root] = INVERSE_CYCLE;
+			queue.push_back(root);
+		}
+
+		for (size_t head = 0; head < queue.size(); head++) {
+			auto triple = queue[head];
+			auto first = triple / (numSlots * numSlots);
+			auto second = triple / numSlots % numSlots;
+			auto third = triple % numSlots;
+
+			for (size_t g = 0; g < orbit.generators.size(); g++) {
+				// Generator g takes the previous triple into this one
+				auto& inverse = orbit.permutations[g ^ 1];
+				auto previous = encode(inverse[first], inverse[second], inverse[third]);
+
+				if (setups[previous] == NOT_VISITED) {
+					setups[previous] = static_cast<uint8_t>(g);
+					queue.push_back(previous);
+				}
+			}
+		}
+		return setups;
+	}
+
+	unsigned int GetPermutationParity(const std::vector<unsigned int>& permutation)
+	{
+		std::vector<bool> visited(permutation.size(), false);
+		auto parity = 0u;
+
+		for (size_t i = 0; i < permutation.size(); i++) {
+			for (auto j = i; !visited[j]; j = permutation[j]) {
+				visited[j] = true;
+				parity ^= (j != i) ? 1u : 0u;
+			}
+		}
+		return parity;
+	}
+}
+
+class ReductionSolver::Reduction final {
+private:
+
+	const CubeSolver& m_solver;
+	unsigned int m_numStickersEdge;
+	CubeState m_state;
+	std::vector<CubeState::Move>& m_solution;
+	std::array<unsigned char, CubeState::NUM_FACES> m_faceColors;
+
+	// Setup tables by orbit's shape (permutations and cycle)
+	std::map<std::vector<uint8_t>, std::shared_ptr<const std::vector<uint8_t>>> m_setups;
+
+	int GetExtent() const { return static_cast<int>(m_numStickersEdge) - 1; }
+
+	void Apply(const CubeState::Move& move)
+	{
+		m_state.RotateLayer(move);
+		m_solution.push_back(move);
+	}
+
+	// Colors of the piece in the slot and colors it should have
+	unsigned int GetKey(const Slot& slot) const
+	{
+		auto key = 0u;
+		for (const auto& sticker : slot) {
+			key = (key << 8) | m_state.Get(sticker.face, sticker.x, sticker.y);
+		}
+		return key;
+	}
+
+	unsigned int GetTargetKey(const Slot& slot) const
+	{
+		auto key = 0u;
+		for (const auto& sticker : slot) {
+			key = (key << 8) | m_faceColors[sticker.face];
+		}
+		return key;
+	}
+
+	std::vector<Slot> GetCornerSlots() const
+	{
+		std::vector<Slot> corners;
+		auto extent = GetExtent();
+
+		for (auto x : { -extent, extent }) {
+			for (auto y : { -extent, extent }) {
+				for (auto z : { -extent, extent }) {
+					corners.push_back(CubeGeometry::GetPieceStickers(Vector{ x, y, z }, extent));
+				}
+			}
+		}
+		return corners;
+	}
+
+	// Odd cubes keep their centers, even cubes take orientation of the right top front corner
+	void FindFaceColors()
+	{
+		auto n = m_numStickersEdge;
+
+		if (n % 2 == 1) {
+			for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+				m_faceColors[face] = m_state.Get(static_cast<CubeState::Face>(face), n / 2, n / 2);
+			}
+			return;
+		}
+
+		// Colors of opposite faces never meet on a corner
+		std::map<unsigned char, std::vector<unsigned char>> neighbours;
+		for (const auto& corner : GetCornerSlots()) {
+			for (const auto& a : corner) {
+				for (const auto& b : corner) {
+					neighbours[m_state.Get(a.face, a.x, a.y)].push_back(m_state.Get(b.face, b.x, b.y));
+				}
+			}
+		}
+
+		if (neighbours.size() != CubeState::NUM_FACES) {
+			throw std::runtime_error("Invalid cube state: corners do not have six colors");
+		}
+
+		auto getOpposite = [&](unsigned char color) {
+			auto& colors = neighbours[color];
+
+			for (const auto& other : neighbours) {
+				if (std::find(colors.begin(), colors.end(), other.first) == colors.end()) {
+					return other.first;
+				}
+			}
+			throw std::runtime_error("Invalid cube state: color has no opposite color");
+		};
+
+		auto extent = GetExtent();
+		auto&& corner = CubeGeometry::GetPieceStickers(Vector{ extent, extent, extent }, extent);
+
+		m_faceColors[CubeState::RIGHT] = m_state.Get(corner[0].face, corner[0].x, corner[0].y);
+		m_faceColors[CubeState::TOP] = m_state.Get(corner[1].face, corner[1].x, corner[1].y);
+		m_faceColors[CubeState::FRONT] = m_state.Get(corner[2].face, corner[2].x, corner[2].y);
+		m_faceColors[CubeState::LEFT] = getOpposite(m_faceColors[CubeState::RIGHT]);
+		m_faceColors[CubeState::BOTTOM] = getOpposite(m_faceColors[CubeState::TOP]);
+		m_faceColors[CubeState::BACK] = getOpposite(m_faceColors[CubeState::FRONT]);
+	}
+
+	unsigned int GetCornerParity() const
+	{
+		auto&& corners = GetCornerSlots();
+		std::vector<unsigned int> permutation;
+
+		auto getColors = [](unsigned int key) {
+			std::array<unsigned int, 3> colors = { key >> 16, (key >> 8) & 0xFFu, key & 0xFFu };
+			std::sort(colors.begin(), colors.end());
+			return colors;
+		};
+
+		for (const auto& corner : corners) {
+			auto&& colors = getColors(GetKey(corner));
+			auto home = std::find_if(corners.begin(), corners.end(), [&](const Slot& slot) { return getColors(GetTargetKey(slot)) == colors; });
+
+			if (home == corners.end()) {
+				throw std::runtime_error("Invalid cube state: unknown corner");
+			}
+			permutation.push_back(static_cast<unsigned int>(home - corners.begin()));
+		}
+		return GetPermutationParity(permutation);
+	}
+
+	// Corners and middle edges (odd cubes) are solved as 3x3 cube by outer layers
+	// Odd permutation of corners is made even by one face turn, edges of even cube are not part of 3x3 stage
+	void SolveCorners()
+	{
+		auto n = m_numStickersEdge;
+		auto odd = n % 2 == 1;
+
+		if (!odd && GetCornerParity() != 0) {
+			Apply(CubeState::Move{ CubeState::Y_AXIS, n - 1, true });
+		}
+
+		unsigned int coordinates[3] = { 0, n / 2, n - 1 };
+		CubeState cube;
+
+		for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+			for (auto x = 0u; x < 3; x++) {
+				for (auto y = 0u; y < 3; y++) {
+					auto f = static_cast<CubeState::Face>(face);
+					auto color = (!odd && (x == 1 || y == 1)) ? m_faceColors[face] : m_state.Get(f, coordinates[x], coordinates[y]);
+					cube.Set(f, x, y, color);
+				}
+			}
+		}
+
+		std::vector<CubeState::Move> moves;
+		if (!m_solver.Solve(cube, moves)) {
+			throw std::runtime_error("Unable to solve corners of the cube");
+		}
+
+		for (auto move : moves) {
+			move.layer = (move.layer == 0) ? 0 : n - 1;
+			Apply(move);
+		}
+	}
+
+	void SetSetups(Orbit& orbit)
+	{
+		std::vector<uint8_t> shape(orbit.cycleSlots.begin(), orbit.cycleSlots.end());
+		shape.push_back(static_cast<uint8_t>(orbit.slots.size()));
+
+		for (const auto& permutation : orbit.permutations) {
+			shape.insert(shape.end(), permutation.begin(), permutation.begin() + orbit.slots.size());
+		}
+
+		auto& setups = m_setups[shape];
+		if (!setups) {
+			setups = std::make_shared<const std::vector<uint8_t>>(BuildSetups(orbit));
+		}
+		orbit.setups = setups;
+	}
+
+	// Center pieces of orbit of top face's sticker [x][y]
+	// Commutator [slice, U slice U'] of two parallel slices crossing on top face is pure 3-cycle
+	Orbit BuildCenterOrbit(unsigned int x, unsigned int y)
+	{
+		auto n = m_numStickersEdge;
+		Sticker start{ CubeState::TOP, x, y };
+		auto&& orbit = BuildOrbit({ start }, GetGenerators(n, { x, y, n - 1 - x, n - 1 - y }), n);
+
+		for (auto clockwise : { true, false }) {
+			auto layer = CubeGeometry::MoveSticker(start, CubeState::Move{ CubeState::Y_AXIS, n - 1, clockwise }, n).x;
+
+			if (layer != x) {
+				CubeState::Move first{ CubeState::X_AXIS, x, true };
+				CubeState::Move second{ CubeState::X_AXIS, layer, true };
+				CubeState::Move turn{ CubeState::Y_AXIS, n - 1, clockwise };
+				SetCycle(orbit, GetCommutator({ first }, { turn, second, Inverse(turn) }));
+				break;
+			}
+		}
+
+		if (orbit.cycle.empty()) {
+			throw std::runtime_error("There is no commutator of the orbit");
+		}
+		SetSetups(orbit);
+		return orbit;
+	}
+
+	// Edge wings of orbit of top front wing at x and it's mirror wing
+	// Commutator [slice, U R U'] crossing at the top front edge is pure 3-cycle
+	Orbit BuildWingOrbit(unsigned int x)
+	{
+		auto n = m_numStickersEdge;
+		auto extent = GetExtent();
+		auto&& start = CubeGeometry::GetPieceStickers(Vector{ 2 * static_cast<int>(x) - extent, extent, extent }, extent);
+		auto&& orbit = BuildOrbit(start, GetGenerators(n, { x, n - 1 - x }), n);
+
+		for (auto clockwise : { true, false }) {
+			CubeState::Move turn{ CubeState::Y_AXIS, n - 1, clockwise };
+
+			if (CubeGeometry::MoveSticker(start.front(), turn, n).x == n - 1) {
+				CubeState::Move slice{ CubeState::X_AXIS, x, true };
+				CubeState::Move face{ CubeState::X_AXIS, n - 1, true };
+				SetCycle(orbit, GetCommutator({ slice }, { turn, face, Inverse(turn) }));
+				break;
+			}
+		}
+
+		if (orbit.cycle.empty()) {
+			throw std::runtime_error("There is no commutator of the orbit");
+		}
+		SetSetups(orbit);
+		return orbit;
+	}
+
+	static CubeState::Move Inverse(const CubeState::Move& move) { return CubeState::Move{ move.axis, move.layer, !move.clockwise }; }
+
+	static std::vector<CubeState::Move> GetCommutator(const std::vector<CubeState::Move>& a, const std::vector<CubeState::Move>& b)
+	{
+		std::vector<CubeState::Move> moves(a);
+		moves.insert(moves.end(), b.begin(), b.end());
+
+		for (auto it = a.rbegin(); it != a.rend(); it++) {
+			moves.push_back(Inverse(*it));
+		}
+		for (auto it = b.rbegin(); it != b.rend(); it++) {
+			moves.push_back(Inverse(*it));
+		}
+		return moves;
+	}
+
+	unsigned int EncodeTriple(const Orbit& orbit, unsigned int a, unsigned int b, unsigned int c) const
+	{
+		auto numSlots = static_cast<unsigned int>(orbit.slots.size());
+		return (a * numSlots + b) * numSlots + c;
+	}
+
+	// Generators of setup which takes slots into cycle slots, or nothing if there is no setup
+	bool GetSetup(const Orbit& orbit, unsigned int a, unsigned int b, unsigned int c, std::vector<unsigned int>& setup, bool& inverse) const
+	{
+		auto& setups = *orbit.setups;
+		setup.clear();
+
+		while (true) {
+			auto generator = setups[EncodeTriple(orbit, a, b, c)];
+
+			if (generator == NOT_VISITED) {
+				return false;
+			}
+			if (generator == CYCLE || generator == INVERSE_CYCLE) {
+				inverse = generator == INVERSE_CYCLE;
+				return true;
+			}
+
+			setup.push_back(generator);
+			auto& permutation = orbit.permutations[generator];
+			a = permutation[a];
+			b = permutation[b];
+			c = permutation[c];
+		}
+	}
+
+	// Move pieces a -> b -> c -> a
+	void CycleSlots(const Orbit& orbit, unsigned int a, unsigned int b, unsigned int c)
+	{
+		std::vector<unsigned int> setup;
+		auto inverse = false;
+		GetSetup(orbit, a, b, c, setup, inverse);
+
+		for (auto generator : setup) {
+			Apply(orbit.generators[generator]);
+		}
+
+		if (inverse) {
+			for (auto it = orbit.cycle.rbegin(); it != orbit.cycle.rend(); it++) {
+				Apply(orbit.generators[*it ^ 1]);
+			}
+		}
+		else {
+			for (auto generator : orbit.cycle) {
+				Apply(orbit.generators[generator]);
+			}
+		}
+
+		for (auto it = setup.rbegin(); it != setup.rend(); it++) {
+			Apply(orbit.generators[*it ^ 1]);
+		}
+	}
+
+	// Greedy 3-cycles, every one puts at least one more piece into place
+	void SolveOrbit(const Orbit& orbit)
+	{
+		auto numSlots = static_cast<unsigned int>(orbit.slots.size());
+		std::vector<unsigned int> keys(numSlots);
+		std::vector<unsigned int> targets(numSlots);
+		std::vector<unsigned int> setup;
+
+		while (true) {
+			for (auto i = 0u; i < numSlots; i++) {
+				keys[i] = GetKey(orbit.slots[i]);
+				targets[i] = GetTargetKey(orbit.slots[i]);
+			}
+
+			auto target = 0u;
+			while (target < numSlots && keys[target] == targets[target]) {
+				target++;
+			}
+			if (target == numSlots) {
+				return;
+			}
+
+			// Piece from wrong slot goes into the target, the third slot is chosen by gain and setup length
+			auto bestGain = 0;
+			auto bestLength = 0u;
+			unsigned int best[3] = {};
+
+			for (auto source = 0u; source < numSlots; source++) {
+				if (source == target || keys[source] != targets[target] || keys[source] == targets[source]) {
+					continue;
+				}
+
+				for (auto third = 0u; third < numSlots; third++) {
+					auto inverse = false;
+
+					if (third == source || third == target || !GetSetup(orbit, source, target, third, setup, inverse)) {
+						continue;
+					}
+
+					auto before = (keys[third] == targets[third]) ? 1 : 0;
+					auto after = 1 + (keys[target] == targets[third] ? 1 : 0) + (keys[third] == targets[source] ? 1 : 0);
+					auto gain = after - before;
+					auto length = static_cast<unsigned int>(setup.size());
+
+					if (gain > bestGain || (gain == bestGain && length < bestLength)) {
+						bestGain = gain;
+						bestLength = length;
+						best[0] = source;
+						best[1] = target;
+						best[2] = third;
+					}
+				}
+			}
+
+			if (bestGain <= 0) {
+				throw std::runtime_error("Invalid cube state: pieces of orbit cannot be solved");
+			}
+			CycleSlots(orbit, best[0], best[1], best[2]);
+		}
+	}
+
+	// Wings cannot be swapped by 3-cycles, odd permutation is fixed by slice quarter turn
+	void FixWingParity(const Orbit& orbit, unsigned int layer)
+	{
+		auto numSlots = orbit.slots.size();
+		std::vector<unsigned int> permutation;
+
+		for (size_t i = 0; i < numSlots; i++) {
+			auto key = GetKey(orbit.slots[i]);
+			auto home = std::find_if(orbit.slots.begin(), orbit.slots.end(), [&](const Slot& slot) { return GetTargetKey(slot) == key; });
+
+			if (home == orbit.slots.end()) {
+				throw std::runtime_error("Invalid cube state: unknown edge wing");
+			}
+			permutation.push_back(static_cast<unsigned int>(home - orbit.slots.begin()));
+		}
+
+		if (GetPermutationParity(permutation) != 0) {
+			Apply(CubeState::Move{ CubeState::X_AXIS, layer, true });
+		}
+	}
+
+public:
+
+	Reduction(const CubeSolver& solver, const CubeState& state, std::vector<CubeState::Move>& solution)
+		: m_solver(solver),
+		m_numStickersEdge(state.GetNumStickersPerEdge()),
+		m_state(state),
+		m_solution(solution)
+	{
+		m_solution.clear();
+	}
+
+	void Run()
+	{
+		auto n = m_numStickersEdge;
+
+		// Single piece is always solved
+		if (n < 2) {
+			return;
+		}
+
+		FindFaceColors();
+		SolveCorners();
+
+		// Wing orbits (x, N - 1 - x), middle edges of odd cube were solved with corners
+		std::vector<Orbit> wingOrbits;
+		for (auto x = 1u; x < n - 1 - x; x++) {
+			wingOrbits.push_back(BuildWingOrbit(x));
+			FixWingParity(wingOrbits.back(), x);
+		}
+
+		// Centers of odd cube keep their places
+		std::vector<bool> done(n * n, false);
+		for (auto x = 1u; x + 1 < n; x++) {
+			for (auto y = 1u; y + 1 < n; y++) {
+				if (done[x * n + y] || (n % 2 == 1 && x == n / 2 && y == n / 2)) {
+					continue;
+				}
+
+				auto&& orbit = BuildCenterOrbit(x, y);
+				for (const auto& slot : orbit.slots) {
+					if (slot.front().face == CubeState::TOP) {
+						done[slot.front().x * n + slot.front().y] = true;
+					}
+				}
+				SolveOrbit(orbit);
+			}
+		}
+
+		for (const auto& orbit : wingOrbits) {
+			SolveOrbit(orbit);
+		}
+	}
+};
+
+ReductionSolver::ReductionSolver(const CubeSolver& solver)
+	: m_solver(solver)
+{
+}
+
+void ReductionSolver::Solve(const CubeState& state, std::vector<CubeState::Move>& solution) const
+{
+	Reduction reduction(m_solver, state, solution);
+	reduction.Run();
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef REDUCTION_SOLVER_H
+#define REDUCTION_SOLVER_H
+
+#include "CubeSolver.h"
+#include "CubeState.h"
+
+#include <vector>
+
+// Reduction method solver of NxN cubes of any size
+// Corners (and middle edges of odd cubes) are solved as 3x3 cube by CubeSolver first
+// Parity of every edge wing orbit is then fixed by one slice turn, so no parity algorithms are needed later
+// Centers and edge wings are solved last by pure 3-cycles (commutators), they keep all other pieces in place
+class ReductionSolver final {
+private:
+
+	// State of one solve call
+	class Reduction;
+
+	const CubeSolver& m_solver;
+
+public:
+
+	// The solver has to outlive this object
+	ReductionSolver(const CubeSolver& solver);
+
+	ReductionSolver(const ReductionSolver&) = delete;
+	ReductionSolver& operator=(const ReductionSolver&) = delete;
+
+	// Solve by layer moves (as used by RubikCube::QueueMoves), every face ends with single color
+	// Odd cubes keep their centers, even cubes are solved in orientation given by one corner
+	// May throw an exception if the state is not a valid cube
+	void Solve(const CubeState& state, std::vector<CubeState::Move>& solution) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace {
+	const unsigned int RADIX_BITS = 8;
+	const unsigned int RADIX = 1u << RADIX_BITS;
+	const unsigned int KEY_DIGITS = 64 / RADIX_BITS;
+}
+
+RenderQueue::RenderQueue(GLint shaderVariantUniform,
+	GLint textureSamplerUniform,
+	const MatrixShaderUniforms& matrixUniforms,
+	const MaterialShaderUniforms& materialUniforms)
+	: m_shaderVariantUniform(shaderVariantUniform),
+	m_textureSamplerUniform(textureSamplerUniform),
+	m_matrixUniforms(matrixUniforms),
+	m_materialUniforms(materialUniforms)
+{
+}
+
+uint32_t RenderQueue::GetId(std::unordered_map<const void*, uint32_t>& ids, const void* object, uint32_t firstId)
+{
+	auto it = ids.find(object);
+	if (it != ids.end()) {
+		return it->second;
+	}
+
+	auto id = firstId + static_cast<uint32_t>(ids.size());
+	if (id >= MAX_IDS) {
+		throw std::runtime_error("Too many distinct objects in render queue");
+	}
+	ids.emplace(object, id);
+	return id;
+}
+
+void RenderQueue::Clear()
+{
+	m_items.clear();
+	m_entries.clear();
+	m_textureIds.clear();
+	m_materialIds.clear();
+	m_meshIds.clear();
+	m_stats = RenderStats();
+}
+
+void RenderQueue::Submit(unsigned int pass,
+	unsigned int shaderVariant,
+	const MeshObject& mesh,
+	const glm::mat4& modelMatrix,
+	unsigned int lod,
+	const SurfaceMaterial& material,
+	const Texture* texture)
+{
+	if (pass >= MAX_PASSES || shaderVariant >= MAX_SHADER_VARIANTS) {
+		throw std::runtime_error("Render pass or shader variant out of range");
+	}
+
+	auto textureId = texture ? GetId(m_textureIds, texture, 1) : 0;
+	auto materialId = GetId(m_materialIds, &material, 0);
+	auto meshId = GetId(m_meshIds, &mesh, 0);
+
+	auto key = (static_cast<uint64_t>(pass) << PASS_SHIFT)
+		| (static_cast<uint64_t>(shaderVariant) << SHADER_VARIANT_SHIFT)
+		| (static_cast<uint64_t>(textureId) << TEXTURE_SHIFT)
+		| (static_cast<uint64_t>(materialId) << MATERIAL_SHIFT)
+		| (static_cast<uint64_t>(meshId) << MESH_SHIFT);
+
+	m_entries.push_back(SortEntry{ key, static_cast<uint32_t>(m_items.size()) });
+	m_items.push_back(Item{ &mesh, &material, texture, modelMatrix, static_cast<GLint>(shaderVariant), lod });
+}
+
+void RenderQueue::Sort()
+{
+	auto numEntries = m_entries.size();
+	if (numEntries < 2) {
+		return;
+	}
+
+	// Histograms of all digits are counted in a single pass
+	std::array<std::array<uint32_t, RADIX>, KEY_DIGITS> histograms = {};
+
+	for (const auto& entry : m_entries) {
+		for (unsigned int digit = 0; digit < KEY_DIGITS; digit++) {
+			histograms[digit][(entry.key >> (digit * RADIX_BITS)) & (RADIX - 1)]++;
+		}
+	}
+
+	m_sortBuffer.resize(numEntries);
+	auto source = m_entries.data();
+	auto destination = m_sortBuffer.data();
+
+	for (unsigned int digit = 0; digit < KEY_DIGITS; digit++) {
+		auto shift = digit * RADIX_BITS;
+		auto& histogram = histograms[digit];
+
+		// All keys have the same digit, nothing would move
+		if (histogram[(source[0].key >> shift) & (RADIX - 1)] == numEntries) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (auto& count : histogram) {
+			auto bucketSize = count;
+			count = offset;
+			offset += bucketSize;
+		}
+
+		for (size_t i = 0; i < numEntries; i++) {
+			destination[histogram[(source[i].key >> shift) & (RADIX - 1)]++] = source[i];
+		}
+		std::swap(source, destination);
+	}
+
+	if (source != m_entries.data()) {
+		m_entries.swap(m_sortBuffer);
+	}
+}
+
+void RenderQueue::Execute(unsigned int pass, const Camera& camera)
+{
+	auto passKey = static_cast<uint64_t>(pass) << PASS_SHIFT;
+	auto compare = [](const SortEntry& entry, uint64_t key) { return entry.key < key; };
+
+	auto first = std::lower_bound(m_entries.begin(), m_entries.end(), passKey, compare);
+	auto last = (pass + 1 < MAX_PASSES)
+		? std::lower_bound(first, m_entries.end(), static_cast<uint64_t>(pass + 1) << PASS_SHIFT, compare)
+		: m_entries.end();
+
+	if (first == last) {
+		return;
+	}
+
+	// State left by others is unknown
+	GLint shaderVariant = -1;
+	const Texture* texture = nullptr;
+	const SurfaceMaterial* material = nullptr;
+	const MeshObject* mesh = nullptr;
+
+	glUniform1i(m_textureSamplerUniform, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	for (auto it = first; it != last; ++it) {
+		const auto& item = m_items[it->item];
+
+		if (item.shaderVariant != shaderVariant) {
+			shaderVariant = item.shaderVariant;
+			glUniform1i(m_shaderVariantUniform, shaderVariant);
+			m_stats.shaderVariantChanges++;
+		}
+
+		// Texture is left bound for untextured draws, variant without texture does not sample it
+		if (item.texture && item.texture != texture) {
+			texture = item.texture;
+			texture->Bind();
+			m_stats.textureBinds++;
+		}
+
+		if (item.material != material) {
+			material = item.material;
+			MeshObject::SendMaterial(*material, m_materialUniforms);
+			m_stats.materialChanges++;
+		}
+
+		if (item.mesh != mesh) {
+			mesh = item.mesh;
+			mesh->Bind();
+			m_stats.meshBinds++;
+		}
+
+		mesh->DrawBound(camera, item.modelMatrix, item.lod, m_matrixUniforms);
+		m_stats.drawCalls++;
+	}
+
+	if (texture) {
+		texture->Unbind();
+	}
+	MeshObject::Unbind();
+}
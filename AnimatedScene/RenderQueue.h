@@ -0,0 +1,118 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "MeshObject.h"
+#include "Texture.h"
+#include "Camera.h"
+#include "SurfaceMaterial.h"
+#include "MatrixShaderUniforms.h"
+#include "MaterialShaderUniforms.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Draw calls and GL state changes executed by render queue
+struct RenderStats {
+	unsigned int drawCalls;
+	unsigned int shaderVariantChanges;
+	unsigned int textureBinds;
+	unsigned int materialChanges;
+	unsigned int meshBinds;
+
+	RenderStats() : drawCalls(0), shaderVariantChanges(0), textureBinds(0), materialChanges(0), meshBinds(0) {}
+
+	unsigned int GetStateChanges() const { return shaderVariantChanges + textureBinds + materialChanges + meshBinds; }
+};
+
+// Mesh draws of a frame sorted by 64-bit keys (pass, shader variant, texture, material, mesh)
+// Draws sharing state are adjacent after sorting, so repeated binds and uniforms are skipped
+// Shader variant is the value of given uniform, texture is bound into texture unit 0
+class RenderQueue final {
+public:
+
+	static constexpr unsigned int MAX_PASSES = 16;
+	static constexpr unsigned int MAX_SHADER_VARIANTS = 16;
+
+private:
+
+	// Key fields from the most significant bits, the lowest byte is unused
+	static constexpr unsigned int PASS_SHIFT = 60;
+	static constexpr unsigned int SHADER_VARIANT_SHIFT = 56;
+	static constexpr unsigned int TEXTURE_SHIFT = 40;
+	static constexpr unsigned int MATERIAL_SHIFT = 24;
+	static constexpr unsigned int MESH_SHIFT = 8;
+	static constexpr unsigned int MAX_IDS = 1u << 16;
+
+	struct Item {
+		const MeshObject* mesh;
+		const SurfaceMaterial* material;
+		const Texture* texture;
+		glm::mat4 modelMatrix;
+		GLint shaderVariant;
+		unsigned int lod;
+	};
+
+	// Only keys are moved while sorting
+	struct SortEntry {
+		uint64_t key;
+		uint32_t item;
+	};
+
+	GLint m_shaderVariantUniform;
+	GLint m_textureSamplerUniform;
+	MatrixShaderUniforms m_matrixUniforms;
+	MaterialShaderUniforms m_materialUniforms;
+
+	std::vector<Item> m_items;
+	std::vector<SortEntry> m_entries;
+	std::vector<SortEntry> m_sortBuffer;
+
+	// Small ids of textures, materials and meshes for the keys, valid until Clear
+	// (released asset's address may be reused by another one), texture id 0 means no texture
+	std::unordered_map<const void*, uint32_t> m_textureIds;
+	std::unordered_map<const void*, uint32_t> m_materialIds;
+	std::unordered_map<const void*, uint32_t> m_meshIds;
+
+	RenderStats m_stats;
+
+	static uint32_t GetId(std::unordered_map<const void*, uint32_t>& ids, const void* object, uint32_t firstId);
+
+public:
+
+	RenderQueue(GLint shaderVariantUniform,
+		GLint textureSamplerUniform,
+		const MatrixShaderUniforms& matrixUniforms,
+		const MaterialShaderUniforms& materialUniforms);
+
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	// Remove all draws, their ids and stats, call at the beginning of every frame
+	void Clear();
+
+	// Record draw of mesh with given LOD, the mesh must be loaded
+	// Draws with the same key keep their order
+	void Submit(unsigned int pass,
+		unsigned int shaderVariant,
+		const MeshObject& mesh,
+		const glm::mat4& modelMatrix,
+		unsigned int lod,
+		const SurfaceMaterial& material,
+		const Texture* texture);
+
+	// Sort all recorded draws, call once after the last Submit
+	// Stable LSD radix sort by bytes of the keys, bytes equal in all keys are skipped
+	void Sort();
+
+	// Draw sorted draws of given pass, GL state is not cached between passes
+	// The shader must be active, texture unit 0 and VAO are unbound afterwards
+	void Execute(unsigned int pass, const Camera& camera);
+
+	size_t GetNumDraws() const { return m_items.size(); }
+
+	// Stats of all passes executed since Clear
+	const RenderStats& GetStats() const { return m_stats; }
+};
+
+#endif
\ No newline at end of file
@@ -1,12 +1,64 @@
 #include "RubikCube.h"
 #include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
-RubikCube::RubikCube(GLint positionShaderAttribute, GLint normalShaderAttribute, unsigned int numStickersEdge)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define RUBIK_CUBE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+	// Multiplication of many matrices by the same left matrix, it's columns are loaded only once
+	class LeftMultiplier final {
+	private:
+
+#ifdef RUBIK_CUBE_SSE
+		__m128 m_columns[4];
+#else
+		glm::mat4 m_left;
+#endif
+
+	public:
+
+		LeftMultiplier(const glm::mat4& left)
+		{
+#ifdef RUBIK_CUBE_SSE
+			for (auto i = 0; i < 4; i++) {
+				m_columns[i] = _mm_loadu_ps(&left[i][0]);
+			}
+#else
+			m_left = left;
+#endif
+		}
+
+		void Multiply(const glm::mat4& right, glm::mat4& result) const
+		{
+#ifdef RUBIK_CUBE_SSE
+			// Column j of the result is combination of the left columns by column j of the right matrix
+			for (auto j = 0; j < 4; j++) {
+				auto column = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(m_columns[0], _mm_set1_ps(right[j][0])), _mm_mul_ps(m_columns[1], _mm_set1_ps(right[j][1]))),
+					_mm_add_ps(_mm_mul_ps(m_columns[2], _mm_set1_ps(right[j][2])), _mm_mul_ps(m_columns[3], _mm_set1_ps(right[j][3]))));
+				_mm_storeu_ps(&result[j][0], column);
+			}
+#else
+			result = m_left * right;
+#endif
+		}
+	};
+}
+
+RubikCube::RubikCube(GLint positionShaderAttribute, GLint normalShaderAttribute, unsigned int numStickersEdge,
+	GLint instanceModelMatrixAttribute, GLint instanceMaterialIndexAttribute)
+	: m_moveQueue(ROTATION_TIME),
+	m_numSavedMoves(0)
 {
 	ResetAll();
 	m_unitCube = std::make_unique<UnitCube>(positionShaderAttribute, normalShaderAttribute);
-	m_sticker = std::make_unique<Sticker>(positionShaderAttribute, normalShaderAttribute);
+	m_sticker = std::make_unique<Sticker>(positionShaderAttribute, normalShaderAttribute,
+		instanceModelMatrixAttribute, instanceMaterialIndexAttribute);
 	NewCube(numStickersEdge);
 }
 
@@ -23,135 +75,142 @@ RubikCube::RubikCube(RubikCube&& r)
 RubikCube& RubikCube::operator=(RubikCube&& r)
 {
 	DestroyAll();
-	m_faces = std::move(r.m_faces);
+	m_state = std::move(r.m_state);
 	m_unitCube.swap(r.m_unitCube);
 	m_sticker.swap(r.m_sticker);
+	m_stickerSurface.swap(r.m_stickerSurface);
+	m_moveQueue = std::move(r.m_moveQueue);
+	m_numSavedMoves = r.m_numSavedMoves;
+	m_faceTransforms = r.m_faceTransforms;
+	m_stickerTransforms = std::move(r.m_stickerTransforms);
+	m_stickerBaseNormalMatrices = std::move(r.m_stickerBaseNormalMatrices);
 	r.ResetAll();
 	return *this;
 }
 
 void RubikCube::ResetAll()
 {
-	m_rotationType = NONE;
-	m_rotationTimer = 0.f;
-	m_rotationIndex = 0;
-	m_rotationClockwise = false;
+	m_moveQueue.Clear();
 }
 
 void RubikCube::DestroyAll()
 {
 	m_unitCube.reset();
 	m_sticker.reset();
+	m_stickerSurface.reset();
 	ResetAll();
 }
 
-void RubikCube::FillFaceWithColor(FaceIndex face, Sticker::Color c, unsigned int numStickersEdge)
+void RubikCube::MarkDirty(FaceIndex face, unsigned int startX, unsigned int startY, unsigned int endX, unsigned int endY)
 {
-	m_faces[face].reserve(numStickersEdge);
+	auto& rect = m_dirtyRects[face];
+	auto numStickers = GetNumStickersPerEdge();
+	auto orientation = m_state.GetOrientation(face);
 
-	for (unsigned int x = 0; x < numStickersEdge; x++) {
-		m_faces[face].push_back(StickerLine());
-		m_faces[face].back().reserve(numStickersEdge);
+	// Corners of the stickers' rectangle in storage
+	CubeState::MapToStorage(orientation, numStickers, startX, startY);
+	CubeState::MapToStorage(orientation, numStickers, endX, endY);
 
-		for (unsigned int y = 0; y < numStickersEdge; y++) {
-			m_faces[face].back().push_back(c);
-		}
+	if (startX > endX) {
+		std::swap(startX, endX);
+	}
+	if (startY > endY) {
+		std::swap(startY, endY);
+	}
+
+	if (rect.startX >= rect.endX || rect.startY >= rect.endY) {
+		rect = DirtyRect{ startX, startY, endX, endY };
+	}
+	else {
+		rect = DirtyRect{ std::min(rect.startX, startX), std::min(rect.startY, startY),
+			std::max(rect.endX, endX), std::max(rect.endY, endY) };
 	}
 }
 
-void RubikCube::RotateFace(FaceIndex face, bool clockwise)
+void RubikCube::MarkAllDirty()
 {
 	auto numStickers = GetNumStickersPerEdge();
-	auto& f = m_faces[face];
 
-	for (unsigned int i = 0; i < numStickers / 2; i++) {
-		for (unsigned int j = i; j < numStickers - i - 1; j++) {
-			auto& secondRow = clockwise ? f[numStickers - i - 1][j] : f[i][numStickers - j - 1];
-			auto& fourthRow = clockwise ? f[i][numStickers - j - 1] : f[numStickers - i - 1][j];
-			ShiftStickerColors(f[j][i], secondRow, f[numStickers - j - 1][numStickers - i - 1], fourthRow);
-		}
+	for (auto& rect : m_dirtyRects) {
+		rect = DirtyRect{ 0, 0, numStickers, numStickers };
 	}
 }
 
-void RubikCube::ShiftStickerColors(Sticker::Color& c1, Sticker::Color& c2, Sticker::Color& c3, Sticker::Color& c4)
-{
-	Sticker::Color tmp = c1;
-	c1 = c2;
-	c2 = c3;
-	c3 = c4;
-	c4 = tmp;
-}
-
-void RubikCube::SwapFacesXAxisRotation()
+void RubikCube::MarkRotationDirty(const CubeState::Move& move)
 {
 	auto numStickers = GetNumStickersPerEdge();
+	auto i = move.layer;
 
-	if (m_rotationIndex == 0) {
-		RotateFace(LEFT, !m_rotationClockwise);
+	if (move.axis == CubeState::X_AXIS) {
+		for (auto face : { CubeState::TOP, CubeState::BACK, CubeState::BOTTOM, CubeState::FRONT }) {
+			MarkDirty(face, i, 0, i + 1, numStickers);
+		}
 	}
-	else if (m_rotationIndex == numStickers - 1) {
-		RotateFace(RIGHT, m_rotationClockwise);
+	else if (move.axis == CubeState::Y_AXIS) {
+		MarkDirty(CubeState::LEFT, i, 0, i + 1, numStickers);
+		MarkDirty(CubeState::RIGHT, numStickers - i - 1, 0, numStickers - i, numStickers);
+		MarkDirty(CubeState::FRONT, 0, numStickers - i - 1, numStickers, numStickers - i);
+		MarkDirty(CubeState::BACK, 0, i, numStickers, i + 1);
+	}
+	else if (move.axis == CubeState::Z_AXIS) {
+		for (auto face : { CubeState::TOP, CubeState::RIGHT, CubeState::LEFT }) {
+			MarkDirty(face, 0, i, numStickers, i + 1);
+		}
+		MarkDirty(CubeState::BOTTOM, 0, numStickers - i - 1, numStickers, numStickers - i);
 	}
 
-	auto i = m_rotationIndex;
+	// Move tables permute stickers of the turned face instead of changing it's orientation
+	if (m_state.HasMoveTables()) {
+		static const CubeState::Face TURNED_FACES[][2] = {
+			{ CubeState::LEFT, CubeState::RIGHT },
+			{ CubeState::BOTTOM, CubeState::TOP },
+			{ CubeState::BACK, CubeState::FRONT },
+		};
 
-	for (auto y = 0u; y < numStickers; y++) {
-		auto& second = m_rotationClockwise ? m_faces[BACK][i][y] : m_faces[FRONT][i][y];
-		auto& fourth = m_rotationClockwise ? m_faces[FRONT][i][y] : m_faces[BACK][i][y];
-		ShiftStickerColors(m_faces[TOP][i][y], second, m_faces[BOTTOM][i][y], fourth);
+		if (i == 0) {
+			MarkDirty(TURNED_FACES[move.axis][0], 0, 0, numStickers, numStickers);
+		}
+		if (i == numStickers - 1) {
+			MarkDirty(TURNED_FACES[move.axis][1], 0, 0, numStickers, numStickers);
+		}
 	}
 }
 
-void RubikCube::SwapFacesYAxisRotation()
+void RubikCube::ApplyMove(const CubeState::Move& move)
 {
-	auto numStickers = GetNumStickersPerEdge();
-
-	if (m_rotationIndex == 0) {
-		RotateFace(BOTTOM, !m_rotationClockwise);
-	}
-	else if (m_rotationIndex == numStickers - 1) {
-		RotateFace(TOP, m_rotationClockwise);
-	}
-
-	auto i = m_rotationIndex;
-
-	for (auto x = 0u; x < numStickers; x++) {
-		auto& left = m_faces[LEFT][i][x];
-		auto& right = m_faces[RIGHT][numStickers - i - 1][numStickers - x - 1];
-		auto& second = m_rotationClockwise ? left : right;
-		auto& fourth = m_rotationClockwise ? right : left;
-
-		ShiftStickerColors(m_faces[FRONT][x][numStickers - i - 1], second, m_faces[BACK][numStickers - x - 1][i], fourth);
-	}
+	m_state.RotateLayer(move);
+	MarkRotationDirty(move);
 }
 
-void RubikCube::SwapFacesZAxisRotation()
+void RubikCube::UploadDirtyStickers() const
 {
 	auto numStickers = GetNumStickersPerEdge();
 
-	if (m_rotationIndex == 0) {
-		RotateFace(BACK, !m_rotationClockwise);
-	}
-	else if (m_rotationIndex == numStickers - 1) {
-		RotateFace(FRONT, m_rotationClockwise);
+	if (m_stickerSurface->GetNumStickersPerEdge() != numStickers) {
+		m_stickerSurface->Resize(numStickers);
+
+		for (auto& rect : m_dirtyRects) {
+			rect = DirtyRect{ 0, 0, numStickers, numStickers };
+		}
 	}
 
-	auto i = m_rotationIndex;
+	for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+		auto& rect = m_dirtyRects[face];
 
-	for (auto x = 0u; x < numStickers; x++) {
-		auto& second = m_rotationClockwise ? m_faces[RIGHT][x][i] : m_faces[LEFT][x][i];
-		auto& fourth = m_rotationClockwise ? m_faces[LEFT][x][i] : m_faces[RIGHT][x][i];
-		ShiftStickerColors(m_faces[TOP][x][i], second, m_faces[BOTTOM][numStickers - x - 1][numStickers - i - 1], fourth);
+		if (rect.startX >= rect.endX || rect.startY >= rect.endY) {
+			continue;
+		}
+
+		auto faceIndex = static_cast<FaceIndex>(face);
+		m_stickerSurface->Upload(face, rect.startX, rect.startY, rect.endX, rect.endY, m_state.GetFaceStorage(faceIndex));
+		rect = DirtyRect{ 0, 0, 0, 0 };
 	}
 }
 
 void RubikCube::DrawFace(FaceIndex face,
 	const glm::mat4& rotationMatrix,
 	unsigned int startX, unsigned int startY,
-	unsigned int endX, unsigned int endY,
-	const Camera& camera,
-	const MatrixShaderUniforms& matrixUniforms,
-	const MaterialShaderUniforms& materialUniforms) const
+	unsigned int endX, unsigned int endY) const
 {
 	auto numStickers = GetNumStickersPerEdge();
 	
@@ -165,193 +224,192 @@ void RubikCube::DrawFace(FaceIndex face,
 		return; // no throw
 	}
 
-	auto pi = glm::pi<float>();
-	glm::mat4 rotationMat;
-
-	switch (face) {
-	case TOP:
-		// Sticker's default face is top
-		break;
-	case BOTTOM:
-		rotationMat = glm::rotate(pi, glm::vec3(1.f, 0.f, 0.f));
-		break;
-	case LEFT:
-		rotationMat = glm::rotate(pi / 2.f, glm::vec3(0.f, 0.f, 1.f));
-		break;
-	case RIGHT:
-		rotationMat = glm::rotate(-pi / 2.f, glm::vec3(0.f, 0.f, 1.f));
-		break;
-	case FRONT:
-		rotationMat = glm::rotate(pi / 2.f, glm::vec3(1.f, 0.f, 0.f));
-		break;
-	case BACK:
-		rotationMat = glm::rotate(-pi / 2.f, glm::vec3(1.f, 0.f, 0.f));
-		break;
+	if (m_stickerSurface) {
+		m_stickerSurface->AddQuad(rotationMatrix * m_faceTransforms[face], face, m_state.GetOrientation(face), startX, startY, endX, endY);
+		return;
 	}
 
-	auto stickerSize = GetStickerSize();
-	auto scaleMat = glm::scale(glm::vec3(stickerSize*0.9f, 1.f, stickerSize*0.9f));
-	
-	for (auto x = startX; x < endX; x++) {
-		for (auto y = startY; y < endY; y++) {
-			auto&& surfaceMaterial = Sticker::GetStickerMaterial(m_faces[face][x][y]);
+	// Cached sticker transforms are only combined with the layer rotation
+	LeftMultiplier rotation(rotationMatrix);
+	auto instanced = m_sticker->IsInstanced();
+	auto&& normalRotation = glm::mat3(rotationMatrix);
 
-			float translateX = -stickerSize * numStickers / 2.f + stickerSize / 2.f + x * stickerSize;
-			float translateZ = -stickerSize * numStickers / 2.f + stickerSize / 2.f + y * stickerSize;
+	for (auto x = startX; x < endX; x++) {
+		auto index = (static_cast<size_t>(face) * numStickers + x) * numStickers + startY;
 
-			auto&& translationMat = glm::translate(glm::vec3(translateX, 0.001f, translateZ));
-			auto&& finalTransform = m_userTransformations * rotationMatrix * rotationMat * translationMat * scaleMat;
+		for (auto y = startY; y < endY; y++, index++) {
+			Sticker::Instance instance;
+			rotation.Multiply(m_stickerTransforms[index], instance.modelMatrix);
+			instance.color = static_cast<GLint>(m_state.Get(face, x, y));
+			m_stickerInstances.push_back(instance);
 
-			m_sticker->Draw(camera, finalTransform, surfaceMaterial, matrixUniforms, materialUniforms);
+			// Layer rotation is orthonormal, it's normal matrix is the rotation itself
+			if (!instanced) {
+				m_stickerNormalMatrices.push_back(normalRotation * m_stickerBaseNormalMatrices[index]);
+			}
 		}
 	}
 }
 
-void RubikCube::DrawCubeNoRotation(const Camera& camera,
-	const MatrixShaderUniforms& matrixUniforms,
-	const MaterialShaderUniforms& materialUniforms) const
+void RubikCube::UpdateStickerTransforms()
 {
-	m_unitCube->ApplyTransformations(m_userTransformations);
-	m_unitCube->Draw(camera, matrixUniforms, materialUniforms);
-	m_unitCube->ResetTransformations();
-
-	auto numStickers = GetNumStickersPerEdge();
+	auto pi = glm::pi<float>();
 
-	for (auto face = 0u; face < m_faces.size(); face++) {
-		DrawFace(static_cast<FaceIndex>(face), glm::mat4(1.f), 0, 0,
-			numStickers, numStickers, camera, matrixUniforms, materialUniforms);
-	}
+	// Sticker's default face is top
+	m_faceTransforms[CubeState::TOP] = glm::mat4(1.f);
+	m_faceTransforms[CubeState::BOTTOM] = glm::rotate(pi, glm::vec3(1.f, 0.f, 0.f));
+	m_faceTransforms[CubeState::LEFT] = glm::rotate(pi / 2.f, glm::vec3(0.f, 0.f, 1.f));
+	m_faceTransforms[CubeState::RIGHT] = glm::rotate(-pi / 2.f, glm::vec3(0.f, 0.f, 1.f));
+	m_faceTransforms[CubeState::FRONT] = glm::rotate(pi / 2.f, glm::vec3(1.f, 0.f, 0.f));
+	m_faceTransforms[CubeState::BACK] = glm::rotate(-pi / 2.f, glm::vec3(1.f, 0.f, 0.f));
+
+	// Built on demand by BuildStickerTransforms(), state texture needs none of the 6 * N * N matrices
+	m_stickerTransforms = std::vector<glm::mat4>();
+	m_stickerBaseNormalMatrices = std::vector<glm::mat3>();
 }
 
-void RubikCube::DrawCubeXAxisRotation(const Camera& camera,
-	const MatrixShaderUniforms& matrixUniforms,
-	const MaterialShaderUniforms& materialUniforms) const
+void RubikCube::BuildStickerTransforms() const
 {
-	auto numStickers = GetNumStickersPerEdge();
-	glm::vec3 rotationVec(1.f, 0.f, 0.f);
-	glm::mat4 identityMat(1.f);
-	auto rotationMat = glm::rotate(GetRotationAngle(), rotationVec);
-
-	DrawUnitCubeGenericRotation(camera, rotationVec, matrixUniforms, materialUniforms);
-
-	DrawFace(LEFT, m_rotationIndex == 0 ? rotationMat : identityMat, 0, 0,
-		numStickers, numStickers, camera, matrixUniforms, materialUniforms);
-	
-	DrawFace(RIGHT, (m_rotationIndex == numStickers - 1) ? rotationMat : identityMat, 0, 0,
-		numStickers, numStickers, camera, matrixUniforms, materialUniforms);
-	
-	for (auto face : { TOP, BACK, FRONT, BOTTOM }) {
-		auto i = m_rotationIndex;
-		DrawFace(face, rotationMat, i, 0, i + 1, numStickers, camera, matrixUniforms, materialUniforms);
-		DrawFace(face, identityMat, 0, 0, i, numStickers, camera, matrixUniforms, materialUniforms);
-		DrawFace(face, identityMat, i + 1, 0, numStickers, numStickers, camera, matrixUniforms, materialUniforms);
+	if (!m_stickerTransforms.empty()) {
+		return;
 	}
-}
 
-void RubikCube::DrawCubeYAxisRotation(const Camera& camera,
-	const MatrixShaderUniforms& matrixUniforms,
-	const MaterialShaderUniforms& materialUniforms) const
-{
 	auto numStickers = GetNumStickersPerEdge();
-	glm::vec3 rotationVec(0.f, 1.f, 0.f);
-	glm::mat4 identityMat(1.f);
-	auto rotationMat = glm::rotate(GetRotationAngle(), rotationVec);
+	auto stickerSize = GetStickerSize();
+	auto scaleMat = glm::scale(glm::vec3(stickerSize*0.9f, 1.f, stickerSize*0.9f));
+	auto normalMatrices = !m_sticker->IsInstanced();
 
-	DrawUnitCubeGenericRotation(camera, rotationVec, matrixUniforms, materialUniforms);
+	m_stickerTransforms.resize(CubeState::NUM_FACES * numStickers * numStickers);
+	if (normalMatrices) {
+		m_stickerBaseNormalMatrices.resize(m_stickerTransforms.size());
+	}
 
-	DrawFace(BOTTOM, m_rotationIndex == 0 ? rotationMat : identityMat, 0, 0,
-		numStickers, numStickers, camera, matrixUniforms, materialUniforms);
+	for (auto face = 0u; face < CubeState::NUM_FACES; face++) {
+		for (auto x = 0u; x < numStickers; x++) {
+			for (auto y = 0u; y < numStickers; y++) {
+				float translateX = -stickerSize * numStickers / 2.f + stickerSize / 2.f + x * stickerSize;
+				float translateZ = -stickerSize * numStickers / 2.f + stickerSize / 2.f + y * stickerSize;
 
-	DrawFace(TOP, (m_rotationIndex == numStickers - 1) ? rotationMat : identityMat, 0, 0,
-		numStickers, numStickers, camera, matrixUniforms, materialUniforms);
+				auto index = (face * numStickers + x) * numStickers + y;
+				auto&& translationMat = glm::translate(glm::vec3(translateX, 0.001f, translateZ));
 
-	// Unlike in rotation around X axis, [0, 0] points of faces aren't in straight line there
-	for (auto face : { FRONT, RIGHT, BACK, LEFT }) {
-		auto i = (face == FRONT || face == RIGHT) ? numStickers - m_rotationIndex - 1 : m_rotationIndex;
+				m_stickerTransforms[index] = m_faceTransforms[face] * translationMat * scaleMat;
 
-		if (face == FRONT || face == BACK) {
-			DrawFace(face, rotationMat, 0, i, numStickers, i + 1, camera, matrixUniforms, materialUniforms);
-			DrawFace(face, identityMat, 0, 0, numStickers, i, camera, matrixUniforms, materialUniforms);
-			DrawFace(face, identityMat, 0, i + 1, numStickers, numStickers, camera, matrixUniforms, materialUniforms);
-		}
-		else {
-			DrawFace(face, rotationMat, i, 0, i + 1, numStickers, camera, matrixUniforms, materialUniforms);
-			DrawFace(face, identityMat, 0, 0, i, numStickers, camera, matrixUniforms, materialUniforms);
-			DrawFace(face, identityMat, i + 1, 0, numStickers, numStickers, camera, matrixUniforms, materialUniforms);
+				if (normalMatrices) {
+					m_stickerBaseNormalMatrices[index] = glm::mat3(glm::inverse(glm::transpose(m_stickerTransforms[index])));
+				}
+			}
 		}
 	}
 }
 
-void RubikCube::DrawCubeZAxisRotation(const Camera& camera,
+void RubikCube::DrawUnitCubeLayers(const Camera& camera,
+	CubeState::Axis axis,
+	unsigned int start, unsigned int end,
+	float angle,
 	const MatrixShaderUniforms& matrixUniforms,
 	const MaterialShaderUniforms& materialUniforms) const
 {
-	auto numStickers = GetNumStickersPerEdge();
-	glm::vec3 rotationVec(0.f, 0.f, 1.f);
-	glm::mat4 identityMat(1.f);
-	auto rotationMat = glm::rotate(GetRotationAngle(), rotationVec);
-
-	DrawUnitCubeGenericRotation(camera, rotationVec, matrixUniforms, materialUniforms);
-
-	DrawFace(BACK, m_rotationIndex == 0 ? rotationMat : identityMat, 0, 0,
-		numStickers, numStickers, camera, matrixUniforms, materialUniforms);
-
-	DrawFace(FRONT, (m_rotationIndex == numStickers - 1) ? rotationMat : identityMat, 0, 0,
-		numStickers, numStickers, camera, matrixUniforms, materialUniforms);
-
-	for (auto face : { TOP, RIGHT, LEFT, BOTTOM }) {
-		auto i = (face == BOTTOM) ? numStickers - m_rotationIndex - 1 : m_rotationIndex;
+	// Scale only along the axis, keep the other two dimensions
+	glm::vec3 axisVec(axis == CubeState::X_AXIS, axis == CubeState::Y_AXIS, axis == CubeState::Z_AXIS);
+	auto stickerSize = GetStickerSize();
+	auto cubeSize = m_unitCube->CubeSize();
 
-		DrawFace(face, rotationMat, 0, i, numStickers, i + 1, camera, matrixUniforms, materialUniforms);
-		DrawFace(face, identityMat, 0, 0, numStickers, i, camera, matrixUniforms, materialUniforms);
-		DrawFace(face, identityMat, 0, i + 1, numStickers, numStickers, camera, matrixUniforms, materialUniforms);
+	m_unitCube->ApplyTransformations(m_userTransformations);
+	m_unitCube->Translate(axisVec * ((start + end) * stickerSize / 2.f - cubeSize / 2.f));
+	if (angle != 0.f) {
+		m_unitCube->Rotate(angle, axisVec);
 	}
+	m_unitCube->Scale(glm::vec3(1.f) + axisVec * ((end - start) * stickerSize - 1.f));
+	m_unitCube->Draw(camera, matrixUniforms, materialUniforms);
+	m_unitCube->ResetTransformations();
 }
 
-void RubikCube::DrawUnitCubeGenericRotation(const Camera& camera,
-	const glm::vec3& transformationVec,
+void RubikCube::DrawLayers(const Camera& camera,
+	CubeState::Axis axis,
+	unsigned int start, unsigned int end,
+	float angle,
 	const MatrixShaderUniforms& matrixUniforms,
 	const MaterialShaderUniforms& materialUniforms) const
 {
-	// Apply this function after transformationVec multiplication!
-	// We have no other option than pass zeros on specific axes where we don't wanna apply scaling
-	// and then reset these zeros back to one
-	static auto resetZerosScale = [](glm::vec3& scale) -> auto& {
-		scale.x = scale.x == 0.f ? 1.f : scale.x;
-		scale.y = scale.y == 0.f ? 1.f : scale.y;
-		scale.z = scale.z == 0.f ? 1.f : scale.z;
-		return scale;
+	// Faces turned by the first and the last layer of every axis
+	static const FaceIndex OUTER_FACES[][2] = {
+		{ CubeState::LEFT, CubeState::RIGHT },
+		{ CubeState::BOTTOM, CubeState::TOP },
+		{ CubeState::BACK, CubeState::FRONT },
 	};
 
 	auto numStickers = GetNumStickersPerEdge();
-	auto stickerSize = GetStickerSize();
-	auto cubeSize = m_unitCube->CubeSize();
+	glm::vec3 axisVec(axis == CubeState::X_AXIS, axis == CubeState::Y_AXIS, axis == CubeState::Z_AXIS);
+	auto&& rotationMat = (angle != 0.f) ? glm::rotate(angle, axisVec) : glm::mat4(1.f);
 
-	// Rotating part
-	m_unitCube->ApplyTransformations(m_userTransformations);
-	m_unitCube->Translate(transformationVec * (stickerSize / 2.f - cubeSize / 2.f + m_rotationIndex * stickerSize));
-	m_unitCube->Rotate(GetRotationAngle(), transformationVec);
-	m_unitCube->Scale(resetZerosScale(transformationVec * stickerSize));
-	m_unitCube->Draw(camera, matrixUniforms, materialUniforms);
-	m_unitCube->ResetTransformations();
+	DrawUnitCubeLayers(camera, axis, start, end, angle, matrixUniforms, materialUniforms);
+
+	if (start == 0) {
+		DrawFace(OUTER_FACES[axis][0], rotationMat, 0, 0, numStickers, numStickers);
+	}
+	if (end == numStickers) {
+		DrawFace(OUTER_FACES[axis][1], rotationMat, 0, 0, numStickers, numStickers);
+	}
 
-	// Static "left" side
-	if (m_rotationIndex > 0) {
-		m_unitCube->ApplyTransformations(m_userTransformations);
-		m_unitCube->Translate(transformationVec * (m_rotationIndex * stickerSize / 2.f - cubeSize / 2.f));
-		m_unitCube->Scale(resetZerosScale(transformationVec * (m_rotationIndex * stickerSize)));
-		m_unitCube->Draw(camera, matrixUniforms, materialUniforms);
-		m_unitCube->ResetTransformations();
+	// Unlike in rotation around X axis, [0, 0] points of faces aren't in straight line for the other axes
+	auto reversedStart = numStickers - end;
+	auto reversedEnd = numStickers - start;
+
+	switch (axis) {
+	case CubeState::X_AXIS:
+		for (auto face : { CubeState::TOP, CubeState::BACK, CubeState::FRONT, CubeState::BOTTOM }) {
+			DrawFace(face, rotationMat, start, 0, end, numStickers);
+		}
+		break;
+	case CubeState::Y_AXIS:
+		DrawFace(CubeState::FRONT, rotationMat, 0, reversedStart, numStickers, reversedEnd);
+		DrawFace(CubeState::BACK, rotationMat, 0, start, numStickers, end);
+		DrawFace(CubeState::RIGHT, rotationMat, reversedStart, 0, reversedEnd, numStickers);
+		DrawFace(CubeState::LEFT, rotationMat, start, 0, end, numStickers);
+		break;
+	case CubeState::Z_AXIS:
+		for (auto face : { CubeState::TOP, CubeState::RIGHT, CubeState::LEFT }) {
+			DrawFace(face, rotationMat, 0, start, numStickers, end);
+		}
+		DrawFace(CubeState::BOTTOM, rotationMat, 0, reversedStart, numStickers, reversedEnd);
+		break;
 	}
+}
+
+void RubikCube::GetBoundingSphere(glm::vec3& center, float& radius) const
+{
+	center = glm::vec3(m_userTransformations * glm::vec4(0.f, 0.f, 0.f, 1.f));
+
+	// Stickers lie slightly above the unit cube's faces
+	auto scale = std::max({
+		glm::length(glm::vec3(m_userTransformations[0])),
+		glm::length(glm::vec3(m_userTransformations[1])),
+		glm::length(glm::vec3(m_userTransformations[2])) });
+	radius = (m_unitCube->CubeSize() * 0.5f + 0.01f) * std::sqrt(3.f) * scale;
+}
 
-	// Static "right" side
-	if (m_rotationIndex < numStickers - 1) {
-		m_unitCube->ApplyTransformations(m_userTransformations);
-		m_unitCube->Translate(transformationVec * (cubeSize / 2.f - (numStickers - m_rotationIndex - 1) * stickerSize / 2.f));
-		m_unitCube->Scale(resetZerosScale(transformationVec * ((numStickers - m_rotationIndex - 1) * stickerSize)));
-		m_unitCube->Draw(camera, matrixUniforms, materialUniforms);
-		m_unitCube->ResetTransformations();
+void RubikCube::CheckMaxStickersPerEdge(unsigned int numStickersEdge) const
+{
+	if (numStickersEdge > MAX_STICKERS_PER_LINE) {
+		throw std::runtime_error("Reached maximum number of stickers per line");
 	}
+	if (m_stickerSurface && numStickersEdge > StickerSurface::GetMaxStickersPerEdge()) {
+		throw std::runtime_error("Cube is too large for sticker state texture of this GPU");
+	}
+}
+
+void RubikCube::EnableStateTexture(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute)
+{
+	if (GetNumStickersPerEdge() > StickerSurface::GetMaxStickersPerEdge()) {
+		throw std::runtime_error("Cube is too large for sticker state texture of this GPU");
+	}
+	m_stickerSurface = std::make_unique<StickerSurface>(positionShaderAttribute, normalShaderAttribute, texelShaderAttribute);
+	MarkAllDirty();
+
+	// Sticker transforms are not used anymore
+	m_stickerTransforms = std::vector<glm::mat4>();
+	m_stickerBaseNormalMatrices = std::vector<glm::mat3>();
 }
 
 void RubikCube::NewCube(unsigned int numStickersEdge)
@@ -359,21 +417,32 @@ void RubikCube::NewCube(unsigned int numStickersEdge)
 	if (numStickersEdge == 0) {
 		throw std::runtime_error("Number of stickers per edge cannot be zero");
 	}
-	if (numStickersEdge > MAX_STICKERS_PER_LINE) {
-		throw std::runtime_error("Reached maximum number of stickers per line");
-	}
+	CheckMaxStickersPerEdge(numStickersEdge);
+	ResetAll();
+
+	m_state.Reset(numStickersEdge);
+	m_state.Fill(CubeState::TOP, Sticker::WHITE);
+	m_state.Fill(CubeState::BOTTOM, Sticker::YELLOW);
+	m_state.Fill(CubeState::FRONT, Sticker::RED);
+	m_state.Fill(CubeState::BACK, Sticker::ORANGE);
+	m_state.Fill(CubeState::LEFT, Sticker::GREEN);
+	m_state.Fill(CubeState::RIGHT, Sticker::BLUE);
+	UpdateStickerTransforms();
+	MarkAllDirty();
+}
+
+void RubikCube::SetState(const CubeState& state)
+{
+	CheckMaxStickersPerEdge(state.GetNumStickersPerEdge());
 	ResetAll();
 
-	for (auto& face : m_faces) {
-		face.clear();
+	auto resized = state.GetNumStickersPerEdge() != GetNumStickersPerEdge();
+	m_state = state;
+
+	if (resized) {
+		UpdateStickerTransforms();
 	}
-	
-	FillFaceWithColor(TOP, Sticker::WHITE, numStickersEdge);
-	FillFaceWithColor(BOTTOM, Sticker::YELLOW, numStickersEdge);
-	FillFaceWithColor(FRONT, Sticker::RED, numStickersEdge);
-	FillFaceWithColor(BACK, Sticker::ORANGE, numStickersEdge);
-	FillFaceWithColor(LEFT, Sticker::GREEN, numStickersEdge);
-	FillFaceWithColor(RIGHT, Sticker::BLUE, numStickersEdge);
+	MarkAllDirty();
 }
 
 bool RubikCube::Rotate(RubikCube::RotationType rotationType, unsigned int rotationIndex, bool rotationClockwise)
@@ -381,54 +450,78 @@ bool RubikCube::Rotate(RubikCube::RotationType rotationType, unsigned int rotati
 	if (rotationIndex >= GetNumStickersPerEdge()) {
 		throw std::runtime_error("Rotation index is larger than number of stickers!");
 	}
-	if (m_rotationType != NONE) {
+	if (!m_moveQueue.IsIdle()) {
 		return false;
 	}
 
-	m_rotationType = rotationType;
-	m_rotationIndex = rotationIndex;
-	m_rotationClockwise = rotationClockwise;
-	m_rotationTimer = 0.f;
-
+	// Rotation types share values with CubeState's axes
+	m_moveQueue.Push(CubeState::Move{ static_cast<CubeState::Axis>(rotationType), rotationIndex, rotationClockwise });
 	return true;
 }
 
-void RubikCube::Update(float deltaTime)
+void RubikCube::QueueMoves(const std::vector<CubeState::Move>& moves)
 {
-	if (m_rotationType != NONE) {
-		m_rotationTimer += deltaTime;
-
-		if (m_rotationTimer >= ROTATION_TIME) {
-			if (m_rotationType == X_AXIS) {
-				SwapFacesXAxisRotation();
-			}
-			else if (m_rotationType == Y_AXIS) {
-				SwapFacesYAxisRotation();
-			}
-			else {
-				SwapFacesZAxisRotation();
-			}
-			m_rotationType = NONE;
+	for (const auto& move : moves) {
+		if (move.layer >= GetNumStickersPerEdge()) {
+			throw std::runtime_error("Rotation index is larger than number of stickers!");
 		}
 	}
+
+	auto canonical = moves;
+	m_numSavedMoves += MoveSequence::Canonicalize(canonical);
+	m_moveQueue.Push(canonical);
+}
+
+void RubikCube::Update(float deltaTime)
+{
+	m_moveQueue.Update(deltaTime, [this](const CubeState::Move& move) { ApplyMove(move); });
 }
 
 void RubikCube::Draw(const Camera& camera,
 	const MatrixShaderUniforms& matrixUniforms,
-	const MaterialShaderUniforms& materialUniforms) const
+	const MaterialShaderUniforms& materialUniforms,
+	const InstanceShaderUniforms& instanceUniforms) const
 {
-	switch (m_rotationType) {
-	case NONE:
-		DrawCubeNoRotation(camera, matrixUniforms, materialUniforms);
-		break;
-	case X_AXIS:
-		DrawCubeXAxisRotation(camera, matrixUniforms, materialUniforms);
-		break;
-	case Y_AXIS:
-		DrawCubeYAxisRotation(camera, matrixUniforms, materialUniforms);
-		break;
-	case Z_AXIS:
-		DrawCubeZAxisRotation(camera, matrixUniforms, materialUniforms);
-		break;
+	m_stickerInstances.clear();
+	m_stickerNormalMatrices.clear();
+
+	// Quads are built for the current size, so the surface is resized (and uploaded) first
+	if (m_stickerSurface) {
+		m_stickerSurface->ClearQuads();
+		UploadDirtyStickers();
+	}
+	else {
+		BuildStickerTransforms();
+	}
+
+	// Rotating layers split the cube into slabs along their axis, static runs of layers are drawn at once
+	auto active = m_moveQueue.GetActiveMoves();
+	auto axis = active.empty() ? CubeState::X_AXIS : active.front().move.axis;
+	unsigned int start = 0;
+
+	std::sort(active.begin(), active.end(), [](const MoveQueue::ActiveMove& a, const MoveQueue::ActiveMove& b) {
+		return a.move.layer < b.move.layer;
+	});
+
+	for (const auto& rotating : active) {
+		if (start < rotating.move.layer) {
+			DrawLayers(camera, axis, start, rotating.move.layer, 0.f, matrixUniforms, materialUniforms);
+		}
+		DrawLayers(camera, axis, rotating.move.layer, rotating.move.layer + 1, m_moveQueue.GetAngle(rotating),
+			matrixUniforms, materialUniforms);
+		start = rotating.move.layer + 1;
+	}
+	if (start < GetNumStickersPerEdge()) {
+		DrawLayers(camera, axis, start, GetNumStickersPerEdge(), 0.f, matrixUniforms, materialUniforms);
+	}
+
+	// Rotation of the rotating layer is already applied in instance matrices (quads)
+	if (m_stickerSurface) {
+		m_stickerSurface->Draw(camera, m_userTransformations, UnitCube::GetSurfaceMaterial(),
+			matrixUniforms, materialUniforms, instanceUniforms);
+	}
+	else {
+		m_sticker->DrawInstanced(camera, m_userTransformations, m_stickerInstances,
+			matrixUniforms, materialUniforms, instanceUniforms, m_sticker->IsInstanced() ? nullptr : &m_stickerNormalMatrices);
 	}
 }
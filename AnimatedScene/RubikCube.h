@@ -3,6 +3,10 @@
 
 #include "UnitCube.h"
 #include "Sticker.h"
+#include "StickerSurface.h"
+#include "CubeState.h"
+#include "MoveQueue.h"
+#include "MoveSequence.h"
 #include <memory>
 #include <vector>
 #include <array>
@@ -20,87 +24,112 @@ public:
 
 private:
 
-	enum FaceIndex {
-		TOP = 0,
-		BOTTOM,
-		LEFT,
-		RIGHT,
-		FRONT,
-		BACK
-	};
-
-	typedef std::vector<Sticker::Color> StickerLine;
-	typedef std::vector<StickerLine> Face;
+	typedef CubeState::Face FaceIndex;
 
-	static constexpr unsigned int MAX_STICKERS_PER_LINE = 15u;
+	// State texture has 6 * N rows, it's further limited by GL_MAX_TEXTURE_SIZE (see StickerSurface)
+	static constexpr unsigned int MAX_STICKERS_PER_LINE = 2048u;
 	static constexpr float ROTATION_TIME = 1.f;
 
-	std::array<Face, 6> m_faces;
+	// Sticker colors, Sticker::Color per byte
+	CubeState m_state;
 	std::unique_ptr<UnitCube> m_unitCube;
 	std::unique_ptr<Sticker> m_sticker;
 
 	// User's cube transformations
 	glm::mat4 m_userTransformations;
 
-	RotationType m_rotationType;
-	unsigned int m_rotationIndex;
-	bool m_rotationClockwise;
-	float m_rotationTimer;
+	// Stickers collected by DrawFace, drawn instanced at once
+	mutable std::vector<Sticker::Instance> m_stickerInstances;
+
+	// Normal matrices of collected stickers, needed only if the stickers are drawn one by one
+	mutable std::vector<glm::mat3> m_stickerNormalMatrices;
+
+	// Transforms of faces and stickers in cube's space without rotation of layers
+	// Sticker (face, x, y) is at (face * N + x) * N + y, sticker transforms are built on the first draw
+	// without state texture (normal matrices only if the stickers are drawn one by one)
+	std::array<glm::mat4, CubeState::NUM_FACES> m_faceTransforms;
+	mutable std::vector<glm::mat4> m_stickerTransforms;
+	mutable std::vector<glm::mat3> m_stickerBaseNormalMatrices;
+
+	// State texture drawing, see EnableStateTexture()
+	std::unique_ptr<StickerSurface> m_stickerSurface;
+
+	// Stickers changed since the last upload into state texture, empty if start >= end
+	// Coordinates are in face's storage (see CubeState)
+	struct DirtyRect {
+		unsigned int startX;
+		unsigned int startY;
+		unsigned int endX;
+		unsigned int endY;
+	};
+
+	mutable std::array<DirtyRect, 6> m_dirtyRects;
 
-	// Reset all rotation* values to "zero", do not destroy anything
+	// Moves waiting for or being animated
+	MoveQueue m_moveQueue;
+
+	// Moves removed from queued sequences by MoveSequence::Canonicalize
+	size_t m_numSavedMoves;
+
+	// Drop all queued moves, do not destroy anything
 	void ResetAll();
 
 	// Destroy cube's content
 	void DestroyAll();
 
-	void FillFaceWithColor(FaceIndex face, Sticker::Color c, unsigned int numStickersEdge);
-	
-	void RotateFace(FaceIndex face, bool clockwise);
-	void ShiftStickerColors(Sticker::Color& c1, Sticker::Color& c2, Sticker::Color& c3, Sticker::Color& c4);
+	// Mark face's stickers [startX, endX) x [startY, endY) as changed
+	void MarkDirty(FaceIndex face, unsigned int startX, unsigned int startY, unsigned int endX, unsigned int endY);
+	void MarkAllDirty();
+
+	// Mark stickers moved by the finished move, turned faces only change their orientation
+	void MarkRotationDirty(const CubeState::Move& move);
 
-	void SwapFacesXAxisRotation();
-	void SwapFacesYAxisRotation();
-	void SwapFacesZAxisRotation();
+	// Apply finished move to the state
+	void ApplyMove(const CubeState::Move& move);
 
-	float GetRotationAngle() const
-		{ return m_rotationTimer / ROTATION_TIME * glm::half_pi<float>() * ((m_rotationClockwise) ? 1.f : -1.f); }
+	// Throw an exception if the cube of given size cannot be created (or drawn by state texture)
+	void CheckMaxStickersPerEdge(unsigned int numStickersEdge) const;
+
+	// Upload dirty stickers into state texture, resize it if the cube changed it's size
+	void UploadDirtyStickers() const;
 
 	float GetStickerSize() const
 		{ return m_unitCube->CubeSize() / (GetNumStickersPerEdge() * m_sticker->StickerSize()); }
 
+	// Precompute face transforms, release sticker transforms of the previous number of stickers
+	void UpdateStickerTransforms();
+
+	// Build sticker transforms for the current number of stickers, if they are missing
+	void BuildStickerTransforms() const;
+
+	// Add stickers of the face's part into instances or quads of sticker surface (in cube's space)
 	void DrawFace(FaceIndex face,
 		const glm::mat4& rotationMatrix,
 		unsigned int startX, unsigned int startY,
-		unsigned int endX, unsigned int endY,
-		const Camera& camera,
-		const MatrixShaderUniforms& matrixUniforms, 
-		const MaterialShaderUniforms& materialUniforms) const;
+		unsigned int endX, unsigned int endY) const;
 
-	void DrawCubeNoRotation(const Camera& camera,
+	// Draw unit cube's slab of layers [start, end) along the axis rotated by the angle
+	void DrawUnitCubeLayers(const Camera& camera,
+		CubeState::Axis axis,
+		unsigned int start, unsigned int end,
+		float angle,
 		const MatrixShaderUniforms& matrixUniforms,
 		const MaterialShaderUniforms& materialUniforms) const;
 
-	void DrawCubeXAxisRotation(const Camera& camera,
-		const MatrixShaderUniforms& matrixUniforms,
-		const MaterialShaderUniforms& materialUniforms) const;
-
-	void DrawCubeYAxisRotation(const Camera& camera,
-		const MatrixShaderUniforms& matrixUniforms,
-		const MaterialShaderUniforms& materialUniforms) const;
-
-	void DrawCubeZAxisRotation(const Camera& camera,
-		const MatrixShaderUniforms& matrixUniforms,
-		const MaterialShaderUniforms& materialUniforms) const;
-
-	void DrawUnitCubeGenericRotation(const Camera& camera,
-		const glm::vec3& transformationVec,
+	// Draw layers [start, end) along the axis rotated by the angle, including their stickers
+	void DrawLayers(const Camera& camera,
+		CubeState::Axis axis,
+		unsigned int start, unsigned int end,
+		float angle,
 		const MatrixShaderUniforms& matrixUniforms,
 		const MaterialShaderUniforms& materialUniforms) const;
 
 public:
 
 	// Number of stickers per edge = Cube's level
-	RubikCube(GLint positionShaderAttribute, GLint normalShaderAttribute, unsigned int numStickersEdge = 3);
+	// Stickers are drawn instanced if instance attributes are given
+	RubikCube(GLint positionShaderAttribute, GLint normalShaderAttribute, unsigned int numStickersEdge = 3,
+		GLint instanceModelMatrixAttribute = -1, GLint instanceMaterialIndexAttribute = -1);
 	~RubikCube();
 
 	RubikCube(RubikCube&& r);
@@ -110,26 +139,58 @@ public:
 	RubikCube& operator=(const RubikCube&) = delete;
 
 	// Number of stickers per edge = Cube's level
-	unsigned int GetNumStickersPerEdge() const { return m_faces[0].size(); }
-	bool IsRotating() const { return m_rotationType != NONE; }
+	unsigned int GetNumStickersPerEdge() const { return m_state.GetNumStickersPerEdge(); }
+
+	const CubeState& GetState() const { return m_state; }
+	bool IsRotating() const { return !m_moveQueue.IsIdle(); }
+
+	// Draw stickers as one quad per face (or face slice) colored from state texture
+	// Drawing cost does not depend on the cube's size then
+	// Throw an exception if the state texture of the current cube exceeds GL_MAX_TEXTURE_SIZE
+	void EnableStateTexture(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute);
 
 	// Set/Reset user transformation matrix
 	// Due to initial camera's design the Cube can be transformed in world space only via this way
 	inline void SetUserTransformationMatrix(const glm::mat4& matrix = glm::mat4(1.f)) { m_userTransformations = matrix; }
 
+	// World space bounding sphere of the cube transformed by user transformation matrix
+	void GetBoundingSphere(glm::vec3& center, float& radius) const;
+
 	// Rotate one of the cube's faces
 	// May throw an exception if rotationIndex is greater than GetNumStickersPerEdge()
 	// Return false if the cube is unavailable (rotating), true if rotation started performing succesfully
 	bool Rotate(RotationType rotationType, unsigned int rotationIndex, bool rotationClockwise);
 
+	// Queue moves after the already queued ones
+	// The sequence is canonicalized first, moves cancelling each other are never animated
+	// Moves on the same axis and different layers are animated at the same time
+	// May throw an exception if any layer is not less than GetNumStickersPerEdge()
+	void QueueMoves(const std::vector<CubeState::Move>& moves);
+
+	size_t GetNumQueuedMoves() const { return m_moveQueue.GetNumPending(); }
+
+	// Number of moves removed from all queued sequences so far
+	size_t GetNumSavedMoves() const { return m_numSavedMoves; }
+
+	// Play moves faster (time compression) or slower, 1 is the default speed
+	void SetPlaybackSpeed(float speed) { m_moveQueue.SetSpeed(speed); }
+
+	// Animate only this many queued moves, the older ones are applied immediately
+	void SetAnimationLookahead(size_t numMoves = std::numeric_limits<size_t>::max()) { m_moveQueue.SetLookahead(numMoves); }
+
 	void Update(float deltaTime);
 
 	// Create new cube with given number of stickers per edge
 	void NewCube(unsigned int numStickersEdge = 3);
 
+	// Show given state (e.g. one cube of CubeBatch), colors are Sticker::Color values
+	// Running rotation is cancelled
+	void SetState(const CubeState& state);
+
 	void Draw(const Camera& camera,
 		const MatrixShaderUniforms& matrixUniforms,
-		const MaterialShaderUniforms& materialUniforms) const;
+		const MaterialShaderUniforms& materialUniforms,
+		const InstanceShaderUniforms& instanceUniforms) const;
 };
 
 #endif
\ No newline at end of file
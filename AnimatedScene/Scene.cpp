@@ -74,6 +74,8 @@ Scene::Scene()
 	ResetAll();
 	m_shader = std::make_unique<ShaderProgram>("VertexShader.glsl", "FragmentShader.glsl");
 	InitAttribsAndUniforms();
+	m_renderQueue = std::make_unique<RenderQueue>(m_textureTypeUniform, m_textureSamplerUniform, m_matrixUniforms, m_materialUniforms);
+	m_assetRegistry = std::make_unique<AssetRegistry>();
 	InitSceneObjects();
 	InitSceneTextures();
 	CreateLightContainerAndLights();
@@ -93,7 +95,12 @@ Scene& Scene::operator=(Scene&& scene)
 {
 	ResetAll();
 
+	m_assetRegistry = std::move(scene.m_assetRegistry);
 	m_rubikCube = std::move(scene.m_rubikCube);
+	m_cubeSolvers = std::move(scene.m_cubeSolvers);
+	m_solverPool = std::move(scene.m_solverPool);
+	m_cubeSolution = std::move(scene.m_cubeSolution);
+	m_cubeScrambler = std::move(scene.m_cubeScrambler);
 	m_wallMesh = std::move(scene.m_wallMesh);
 	m_binMesh = std::move(scene.m_binMesh);
 	m_boxMesh = std::move(scene.m_boxMesh);
@@ -122,16 +129,20 @@ Scene& Scene::operator=(Scene&& scene)
 
 	m_materialUniforms = scene.m_materialUniforms;
 	m_matrixUniforms = scene.m_matrixUniforms;
+	m_instanceUniforms = scene.m_instanceUniforms;
 
 	m_positionAttribute = scene.m_positionAttribute;
 	m_normalAttribute = scene.m_normalAttribute;
 	m_texelAttribute = scene.m_texelAttribute;
+	m_instanceModelMatrixAttribute = scene.m_instanceModelMatrixAttribute;
+	m_instanceMaterialIndexAttribute = scene.m_instanceMaterialIndexAttribute;
 	m_eyePositionUniform = scene.m_eyePositionUniform;
 	m_textureSamplerUniform = scene.m_textureSamplerUniform;
 	m_textureTypeUniform = scene.m_textureTypeUniform;
 
 	m_mirror = std::move(scene.m_mirror);
 	m_lightContainer = std::move(scene.m_lightContainer);
+	m_renderQueue = std::move(scene.m_renderQueue);
 
 	// Two point and two spot lights are used in this scene
 	m_pointLightsPositions = std::move(scene.m_pointLightsPositions);
@@ -147,10 +158,13 @@ void Scene::ResetAll()
 	m_rubikCubeDirection = 1.f;
 	m_rubikCubeHeightOffset = 0.f;
 	m_rubikCubeAngle = 0.f;
+	m_rubikCubeSolving = false;
 	m_bouncingBallDirection = 1.f;
 	m_bouncingBallHeightOffset = 0.f;
 	m_bouncingBallVelocity = 0.f;
 	m_bouncingBallBounceScale = 1.f;
+	m_submitTextureType = NO_TEXTURE;
+	m_submitTexture = nullptr;
 }
 
 void Scene::InitAttribsAndUniforms()
@@ -158,6 +172,8 @@ void Scene::InitAttribsAndUniforms()
 	m_positionAttribute = m_shader->GetAttribLocation("position");
 	m_normalAttribute = m_shader->GetAttribLocation("normal");
 	m_texelAttribute = m_shader->GetAttribLocation("texel");
+	m_instanceModelMatrixAttribute = m_shader->GetAttribLocation("instance_model_matrix");
+	m_instanceMaterialIndexAttribute = m_shader->GetAttribLocation("instance_material_index");
 
 	m_eyePositionUniform = m_shader->GetUniformLocation("eye_position");
 	m_textureSamplerUniform = m_shader->GetUniformLocation("texture_sampler");
@@ -173,41 +189,69 @@ void Scene::InitAttribsAndUniforms()
 	m_materialUniforms.diffuseColorUniform = m_shader->GetUniformLocation("material_diffuse_color");
 	m_materialUniforms.specularColorUniform = m_shader->GetUniformLocation("material_specular_color");
 	m_materialUniforms.shininessUniform = m_shader->GetUniformLocation("material_shininess");
+
+	// instancing
+	m_instanceUniforms.instancedUniform = m_shader->GetUniformLocation("instanced");
+	m_instanceUniforms.paletteAmbientColorsUniform = m_shader->GetUniformLocation("palette_ambient_colors");
+	m_instanceUniforms.paletteDiffuseColorsUniform = m_shader->GetUniformLocation("palette_diffuse_colors");
+	m_instanceUniforms.paletteSpecularColorsUniform = m_shader->GetUniformLocation("palette_specular_colors");
+	m_instanceUniforms.paletteShininessUniform = m_shader->GetUniformLocation("palette_shininess");
+	m_instanceUniforms.stickerStateUniform = m_shader->GetUniformLocation("sticker_state");
+	m_instanceUniforms.stickerStateSamplerUniform = m_shader->GetUniformLocation("sticker_state_sampler");
+
+	// Samplers of different types cannot share texture unit, even if unused
+	m_shader->SetActive();
+	glUniform1i(m_instanceUniforms.stickerStateSamplerUniform, StickerSurface::STATE_TEXTURE_UNIT);
+	m_shader->SetInactive();
 }
 
-// Bad ugly macro functions :-)
-#define LOAD_MESH(path) std::make_unique<MeshObject>(path, m_positionAttribute, m_normalAttribute, m_texelAttribute)
+std::shared_ptr<MeshObject> Scene::LoadMesh(const std::string& filepath)
+{
+	return m_assetRegistry->GetMesh(filepath, m_positionAttribute, m_normalAttribute, m_texelAttribute);
+}
+
+std::shared_ptr<Texture> Scene::LoadTexture(const std::string& filepath)
+{
+	return m_assetRegistry->GetTexture(filepath);
+}
 
 void Scene::InitSceneObjects()
 {
-	m_rubikCube = std::make_unique<RubikCube>(m_positionAttribute, m_normalAttribute, 3);
+	m_rubikCube = std::make_unique<RubikCube>(m_positionAttribute, m_normalAttribute, 3,
+		m_instanceModelMatrixAttribute, m_instanceMaterialIndexAttribute);
+	m_rubikCube->EnableStateTexture(m_positionAttribute, m_normalAttribute, m_texelAttribute);
+	LoadCubeSolvers();
+	m_solverPool = std::make_unique<TaskPool>(1);
+
+	// Fixed seed, every run shows the same scrambles, colors are taken from the new solved cube
+	m_cubeScrambler = std::make_unique<CubeScrambler>(m_rubikCube->GetState(), 0);
 	
-	m_wallMesh = LOAD_MESH("Data/Wall.obj");
-	m_binMesh = LOAD_MESH("Data/Bin.obj");
-	m_boxMesh = LOAD_MESH("Data/Box.obj");
-	m_chairMesh = LOAD_MESH("Data/Chair.obj");
-	m_tableMesh = LOAD_MESH("Data/Table.obj");
-	m_shelvesWithMiniTableMesh = LOAD_MESH("Data/ShelvesWithMiniTable.obj");
-	m_doorMesh = LOAD_MESH("Data/Door.obj");
-	m_sphereMesh = LOAD_MESH("Data/Sphere.obj");
-	m_cubeMesh = LOAD_MESH("Data/Cube.obj");
-	m_notebookMesh = LOAD_MESH("Data/Notebook.obj");
-	m_notebookDisplayMesh = LOAD_MESH("Data/NotebookDisplay.obj");
-	m_clockMesh = LOAD_MESH("Data/Clock.obj");
-	m_clockHandMesh = LOAD_MESH("Data/ClockHand.obj");
-	m_lampMesh = LOAD_MESH("Data/Lamp.obj");
-	m_bulbMesh = LOAD_MESH("Data/Bulb.obj");
+	m_wallMesh = LoadMesh("Data/Wall.obj");
+	m_binMesh = LoadMesh("Data/Bin.obj");
+	m_boxMesh = LoadMesh("Data/Box.obj");
+	m_chairMesh = LoadMesh("Data/Chair.obj");
+	m_tableMesh = LoadMesh("Data/Table.obj");
+	m_shelvesWithMiniTableMesh = LoadMesh("Data/ShelvesWithMiniTable.obj");
+	m_doorMesh = LoadMesh("Data/Door.obj");
+	m_sphereMesh = LoadMesh("Data/Sphere.obj");
+	m_cubeMesh = LoadMesh("Data/Cube.obj");
+	m_notebookMesh = LoadMesh("Data/Notebook.obj");
+	m_notebookDisplayMesh = LoadMesh("Data/NotebookDisplay.obj");
+	m_clockMesh = LoadMesh("Data/Clock.obj");
+	m_clockHandMesh = LoadMesh("Data/ClockHand.obj");
+	m_lampMesh = LoadMesh("Data/Lamp.obj");
+	m_bulbMesh = LoadMesh("Data/Bulb.obj");
 }
 
 void Scene::InitSceneTextures()
 {
-	m_binTexture = std::make_unique<Texture>("Data/Bin.png");
-	m_birchwoodTexture = std::make_unique<Texture>("Data/Birchwood.png");
-	m_metalTexture = std::make_unique<Texture>("Data/Metal.png");
-	m_boxTexture = std::make_unique<Texture>("Data/Box.png");
-	m_wallTexture = std::make_unique<Texture>("Data/Wall.png");
-	m_doorwoodTexture = std::make_unique<Texture>("Data/Doorwood.png");
-	m_notebookDisplayContentTexture = std::make_unique<Texture>("Data/NotebookDisplayContent.png");
+	m_binTexture = LoadTexture("Data/Bin.png");
+	m_birchwoodTexture = LoadTexture("Data/Birchwood.png");
+	m_metalTexture = LoadTexture("Data/Metal.png");
+	m_boxTexture = LoadTexture("Data/Box.png");
+	m_wallTexture = LoadTexture("Data/Wall.png");
+	m_doorwoodTexture = LoadTexture("Data/Doorwood.png");
+	m_notebookDisplayContentTexture = LoadTexture("Data/NotebookDisplayContent.png");
 }
 
 void Scene::CreateLightContainerAndLights()
@@ -261,6 +305,57 @@ void Scene::CreateLightContainerAndLights()
 		glm::quarter_pi<float>() / 2.f));
 }
 
+void Scene::LoadCubeSolvers()
+{
+	m_cubeSolvers = std::make_shared<CubeSolvers>();
+
+	std::weak_ptr<CubeSolvers> target = m_cubeSolvers;
+	auto pocketCube = m_rubikCube->GetNumStickersPerEdge() == 2;
+
+	m_assetRegistry->LoadJob([target, pocketCube]() -> AssetLoader::Task {
+		auto solvers = std::make_shared<CubeSolvers>();
+
+		if (pocketCube) {
+			solvers->pocketCubeSolver = std::make_unique<PocketCubeSolver>();
+		}
+		else {
+			solvers->cubeSolver = std::make_unique<CubeSolver>();
+			solvers->reductionSolver = std::make_unique<ReductionSolver>(*solvers->cubeSolver);
+		}
+
+		return [target, solvers]() {
+			if (auto cubeSolvers = target.lock()) {
+				*cubeSolvers = std::move(*solvers);
+			}
+		};
+	});
+}
+
+void Scene::StartCubeSolution()
+{
+	auto solvers = m_cubeSolvers;
+	auto state = m_rubikCube->GetState();
+	auto solution = std::make_shared<std::promise<std::vector<CubeState::Move>>>();
+
+	m_cubeSolution = solution->get_future();
+
+	m_solverPool->Submit([solvers, state, solution]() {
+		try {
+			std::vector<CubeState::Move> moves;
+			if (solvers->pocketCubeSolver) {
+				solvers->pocketCubeSolver->Solve(state, moves);
+			}
+			else {
+				solvers->reductionSolver->Solve(state, moves);
+			}
+			solution->set_value(std::move(moves));
+		}
+		catch (...) {
+			solution->set_exception(std::current_exception()); // rethrown on the main thread
+		}
+	});
+}
+
 void Scene::UpdateLevitatingRubikCube(float deltaTime)
 {
 	static const float velocity = .5f;
@@ -279,10 +374,33 @@ void Scene::UpdateLevitatingRubikCube(float deltaTime)
 		m_rubikCubeDirection *= -1.f;
 	}
 
-	if (!m_rubikCube->IsRotating()) {
-		m_rubikCube->Rotate(static_cast<RubikCube::RotationType>(rand() % 3),
-			static_cast<unsigned int>(rand() % 3), rand() % 2 == 1);
+	// The state is final once the last queued move finished
+	if (m_rubikCube->GetNumQueuedMoves() > 0 || m_rubikCube->IsRotating()) {
+		return;
+	}
+
+	// Scrambled cube is solved next, it keeps levitating until the tables and the solution are ready
+	if (!m_rubikCubeSolving) {
+		if (!m_cubeSolvers->IsLoaded()) {
+			return;
+		}
+		if (!m_cubeSolution.valid()) {
+			StartCubeSolution();
+			return;
+		}
+		if (m_cubeSolution.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return;
+		}
+		m_rubikCube->QueueMoves(m_cubeSolution.get());
+		m_rubikCubeSolving = true;
+		return;
 	}
+
+	// Solved cube jumps into uniformly random state
+	auto state = m_rubikCube->GetState();
+	m_cubeScrambler->Generate(state);
+	m_rubikCube->SetState(state);
+	m_rubikCubeSolving = false;
 }
 
 void Scene::UpdateBouncingBall(float deltaTime)
@@ -323,55 +441,101 @@ void Scene::UpdateBouncingBall(float deltaTime)
 
 void Scene::Update(float deltaTime)
 {
+	m_assetRegistry->Update(UPLOAD_BUDGET_MS);
 	m_rubikCube->Update(deltaTime);
 	UpdateLevitatingRubikCube(deltaTime);
 	UpdateBouncingBall(deltaTime);
 }
 
-void Scene::SetTextureTypeFragmentShader(TextureTypeFragmentShader type) const
+void Scene::SetTextureTypeFragmentShader(TextureTypeFragmentShader type, const Texture* texture) const
 {
-	glUniform1i(m_textureTypeUniform, static_cast<GLint>(type));
+	m_submitTextureType = type;
+	m_submitTexture = texture;
+}
 
-	if (type == LOADED_GL_TEXTURE) {
-		glUniform1i(m_textureSamplerUniform, 0);
-		glActiveTexture(GL_TEXTURE0);
+void Scene::SetTextureFragmentShader(const Texture& texture) const
+{
+	if (texture.IsLoaded()) {
+		SetTextureTypeFragmentShader(LOADED_GL_TEXTURE, &texture);
+	}
+	else {
+		SetTextureTypeFragmentShader(NO_TEXTURE);
 	}
 }
 
-void Scene::DrawRoom(const Camera& camera) const
+void Scene::Submit(const MeshObject& mesh, const SurfaceMaterial& material) const
+{
+	m_drawItems.push_back(DrawItem{ &mesh, mesh.GetModelMatrix(), &material, m_submitTextureType, m_submitTexture });
+}
+
+void Scene::QueueDrawItems(const Camera& camera, RenderPass pass) const
+{
+	auto numItems = m_drawItems.size();
+
+	// Bounding spheres in world space, meshes still loading have zero radius
+	m_drawItemSpheres.Clear();
+
+	for (const auto& item : m_drawItems) {
+		glm::vec3 center;
+		float radius;
+		item.mesh->GetBoundingSphere(item.modelMatrix, center, radius);
+		m_drawItemSpheres.Add(center, radius);
+	}
+
+	m_drawItemVisibility.resize(numItems);
+	Frustum(camera.GetMatrix()).CullSpheres(m_drawItemSpheres, m_drawItemVisibility.data());
+
+	auto& lods = m_drawItemLods[pass];
+	lods.resize(numItems, 0);
+
+	for (size_t i = 0; i < numItems; i++) {
+		const auto& item = m_drawItems[i];
+
+		// Culled meshes are not queued at all
+		if (!m_drawItemVisibility[i] || !item.mesh->IsLoaded()) {
+			continue;
+		}
+
+		lods[i] = static_cast<unsigned char>(item.mesh->SelectLod(camera, item.modelMatrix, lods[i]));
+
+		m_renderQueue->Submit(pass, item.textureType, *item.mesh, item.modelMatrix, lods[i], *item.material, item.texture);
+	}
+
+	m_drawItems.clear();
+}
+
+void Scene::DrawRoom() const
 {
 	// "Room"
 	SetTextureTypeFragmentShader(PROCEDURAL_BRICKS_TEXTURE);
 	m_cubeMesh->Scale(ROOM_WIDTH, ROOM_HEIGHT, ROOM_LENGTH);
-	m_cubeMesh->Draw(camera, materials[WALL], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_cubeMesh, materials[WALL]);
 	m_cubeMesh->ResetTransformations();
 
 	// Floor
 	SetTextureTypeFragmentShader(PROCEDURAL_CARPET_TEXTURE);
 	m_wallMesh->Translate(0.f, -ROOM_HEIGHT / 2.f + 0.01f, 0.f);
 	m_wallMesh->Scale(ROOM_WIDTH / 2.f, 1.f, ROOM_LENGTH / 2.f);
-	m_wallMesh->Draw(camera, materials[WALL], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_wallMesh, materials[WALL]);
 	m_wallMesh->ResetTransformations();
 
 	// Ceiling
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_wallTexture->Bind();
+	SetTextureFragmentShader(*m_wallTexture);
 	m_wallMesh->Rotate(glm::pi<float>(), 1.f, 0.f, 0.f);
 	m_wallMesh->Translate(0.f, -ROOM_HEIGHT / 2.f + 0.01f, 0.f);
 	m_wallMesh->Scale(ROOM_WIDTH / 2.f, 1.f, ROOM_LENGTH / 1.f);
-	m_wallMesh->Draw(camera, materials[WALL], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_wallMesh, materials[WALL]);
 	m_wallMesh->ResetTransformations();
-	m_wallTexture->Unbind();
 }
 
-void Scene::DrawClock(const Camera& camera) const
+void Scene::DrawClock() const
 {
 	// Clock with actual local time
 	SetTextureTypeFragmentShader(NO_TEXTURE);
 	m_clockMesh->Rotate(glm::pi<float>(), 0.f, 1.f, 0.f);
 	m_clockMesh->Translate(0.f, 4.f, -ROOM_LENGTH / 2.f);
 	m_clockMesh->Scale(0.05f, 0.05f, 0.05f);
-	m_clockMesh->Draw(camera, materials[PLASTIC], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_clockMesh, materials[PLASTIC]);
 	m_clockMesh->ResetTransformations();
 
 	SYSTEMTIME sysTime;
@@ -387,7 +551,7 @@ void Scene::DrawClock(const Camera& camera) const
 	m_clockHandMesh->Rotate(hourhandAngle, 0.f, 0.f, 1.f);
 	m_clockHandMesh->Translate(0.f, 0.15f, 0.f);
 	m_clockHandMesh->Scale(0.05f, 0.05f, 0.05f);
-	m_clockHandMesh->Draw(camera, materials[DARK_PLASTIC], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_clockHandMesh, materials[DARK_PLASTIC]);
 	m_clockHandMesh->ResetTransformations();
 
 	// Minutes
@@ -397,7 +561,7 @@ void Scene::DrawClock(const Camera& camera) const
 	m_clockHandMesh->Rotate(minutehandAngle, 0.f, 0.f, 1.f);
 	m_clockHandMesh->Translate(0.f, 0.15f, 0.f);
 	m_clockHandMesh->Scale(0.05f, 0.06f, 0.05f);
-	m_clockHandMesh->Draw(camera, materials[DARK_PLASTIC], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_clockHandMesh, materials[DARK_PLASTIC]);
 	m_clockHandMesh->ResetTransformations();
 
 	// Seconds
@@ -407,167 +571,149 @@ void Scene::DrawClock(const Camera& camera) const
 	m_clockHandMesh->Rotate(secondhandAngle, 0.f, 0.f, 1.f);
 	m_clockHandMesh->Translate(0.f, 0.15f, 0.f);
 	m_clockHandMesh->Scale(0.02f, 0.09f, 0.05f);
-	m_clockHandMesh->Draw(camera, materials[DARK_PLASTIC], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_clockHandMesh, materials[DARK_PLASTIC]);
 	m_clockHandMesh->ResetTransformations();
 }
 
-void Scene::DrawShelvesWithMiniTable(const Camera& camera) const
+void Scene::DrawShelvesWithMiniTable() const
 {
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_birchwoodTexture->Bind();
+	SetTextureFragmentShader(*m_birchwoodTexture);
 	m_shelvesWithMiniTableMesh->Translate(4.f, -ROOM_HEIGHT / 2.f, 2.5f);
 	m_shelvesWithMiniTableMesh->Scale(4.f, 4.f, 4.f);
-	m_shelvesWithMiniTableMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_shelvesWithMiniTableMesh, materials[WOOD]);
 	m_shelvesWithMiniTableMesh->ResetTransformations();
-	m_birchwoodTexture->Unbind();
 }
 
-void Scene::DrawLaptop(const Camera& camera) const
+void Scene::DrawLaptop() const
 {
 	// Notebook + Display + Display Content
 	SetTextureTypeFragmentShader(NO_TEXTURE);
 	m_notebookMesh->Rotate(glm::pi<float>(), 0.f, 1.f, 0.f);
 	m_notebookMesh->Translate(0.f, -3.5f, -12.f);
 	m_notebookMesh->Scale(0.05f, 0.05f, 0.05f);
-	m_notebookMesh->Draw(camera, materials[PLASTIC], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_notebookMesh, materials[PLASTIC]);
 	m_notebookMesh->ResetTransformations();
 
 	SetTextureTypeFragmentShader(NO_TEXTURE);
 	m_notebookDisplayMesh->Rotate(glm::pi<float>(), 0.f, 1.f, 0.f);
 	m_notebookDisplayMesh->Translate(0.f, -3.5f, -12.f);
 	m_notebookDisplayMesh->Scale(0.05f, 0.05f, 0.05f);
-	m_notebookDisplayMesh->Draw(camera, materials[PLASTIC], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_notebookDisplayMesh, materials[PLASTIC]);
 	m_notebookDisplayMesh->ResetTransformations();
 
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_notebookDisplayContentTexture->Bind();
+	SetTextureFragmentShader(*m_notebookDisplayContentTexture);
 	m_wallMesh->Rotate(glm::pi<float>(), 0.f, 1.f, 0.f);
 	m_wallMesh->Translate(0.f, -3.5f, -12.f);
 	m_wallMesh->Rotate(glm::quarter_pi<float>()* 1.45f, 1.f, 0.f, 0.f);
 	m_wallMesh->Translate(0.f, 0.f, -0.62f);
 	m_wallMesh->Scale(0.85f, 1.f, .58f);
-	m_wallMesh->Draw(camera, materials[PLASTIC], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_wallMesh, materials[PLASTIC]);
 	m_wallMesh->ResetTransformations();
-	m_notebookDisplayContentTexture->Unbind();
 }
 
-void Scene::DrawBin(const Camera& camera) const
+void Scene::DrawBin() const
 {
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_binTexture->Bind();
+	SetTextureFragmentShader(*m_binTexture);
 	m_binMesh->Translate(ROOM_WIDTH / 2.f - 2.f, -ROOM_HEIGHT / 2.f, -ROOM_LENGTH / 2.f + 2.f);
 	m_binMesh->Scale(0.08f, 0.08f, 0.08f);
-	m_binMesh->Draw(camera, materials[SILVER], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_binMesh, materials[SILVER]);
 	m_binMesh->ResetTransformations();
-	m_binTexture->Unbind();
 }
 
-void Scene::DrawDoor(const Camera& camera) const
+void Scene::DrawDoor() const
 {
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_doorwoodTexture->Bind();
+	SetTextureFragmentShader(*m_doorwoodTexture);
 	m_doorMesh->Translate(ROOM_WIDTH / 2.f, -ROOM_HEIGHT / 2.f, 0.f);
 	m_doorMesh->Rotate(glm::half_pi<float>(), 0.f, 1.f, 0.f);
 	m_doorMesh->Scale(8.f, 5.f, 4.f);
-	m_doorMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_doorMesh, materials[WOOD]);
 	m_doorMesh->ResetTransformations();
-	m_doorwoodTexture->Unbind();
 }
 
-void Scene::DrawTable(const Camera& camera) const
+void Scene::DrawTable() const
 {
 	SetTextureTypeFragmentShader(PROCEDURAL_WOOD_TEXTURE);
 	m_tableMesh->Translate(0.f, -ROOM_HEIGHT / 2.f, ROOM_LENGTH / 2.f - 3.f);
 	m_tableMesh->Scale(0.07f, 0.07f, 0.07f);
-	m_tableMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_tableMesh, materials[WOOD]);
 	m_tableMesh->ResetTransformations();
 }
 
-void Scene::DrawChairs(const Camera& camera) const
+void Scene::DrawChairs() const
 {
 	// Chair 1
 	SetTextureTypeFragmentShader(PROCEDURAL_WOOD_TEXTURE);
 	m_chairMesh->Translate(0.f, -ROOM_HEIGHT / 2.f + 1.5f, 3.f);
 	m_chairMesh->Rotate(-glm::half_pi<float>(), 0.f, 1.f, 0.f);
 	m_chairMesh->Scale(1.8f, 1.8f, 1.8f);
-	m_chairMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_chairMesh, materials[WOOD]);
 	m_chairMesh->ResetTransformations();
 
 	// Chair 2
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_doorwoodTexture->Bind();
+	SetTextureFragmentShader(*m_doorwoodTexture);
 	m_chairMesh->Translate(-6.f, -ROOM_HEIGHT / 2.f + 1.5f, 5.f);
 	m_chairMesh->Rotate(-glm::quarter_pi<float>(), 0.f, 1.f, 0.f);
 	m_chairMesh->Scale(1.8f, 1.8f, 1.8f);
-	m_chairMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_chairMesh, materials[WOOD]);
 	m_chairMesh->ResetTransformations();
-	m_doorwoodTexture->Unbind();
 
 	// Chair 3
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_birchwoodTexture->Bind();
+	SetTextureFragmentShader(*m_birchwoodTexture);
 	m_chairMesh->Translate(6.f, -ROOM_HEIGHT / 2.f + 1.5f, 5.f);
 	m_chairMesh->Rotate(-glm::pi<float>() + glm::quarter_pi<float>(), 0.f, 1.f, 0.f);
 	m_chairMesh->Scale(1.8f, 1.8f, 1.8f);
-	m_chairMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_chairMesh, materials[WOOD]);
 	m_chairMesh->ResetTransformations();
-	m_birchwoodTexture->Unbind();
 }
 
-void Scene::DrawBoxes(const Camera& camera) const
+void Scene::DrawBoxes() const
 {
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_boxTexture->Bind();
+	SetTextureFragmentShader(*m_boxTexture);
 	m_boxMesh->Translate(-ROOM_WIDTH / 2.f + 3.f, -ROOM_HEIGHT / 2.f, ROOM_LENGTH / 2.f - 3.f);
 	m_boxMesh->Rotate(glm::quarter_pi<float>(), 0.f, 1.f, 0.f);
 	m_boxMesh->Scale(0.07f, 0.07f, 0.07f);
-	m_boxMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_boxMesh, materials[WOOD]);
 	m_boxMesh->ResetTransformations();
 	
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
+	SetTextureFragmentShader(*m_boxTexture);
 	m_boxMesh->Translate(ROOM_WIDTH / 2.f - 3.f, -ROOM_HEIGHT / 2.f, ROOM_LENGTH / 2.f - 3.f);
 	m_boxMesh->Rotate(glm::quarter_pi<float>(), 0.f, 1.f, 0.f);
 	m_boxMesh->Scale(0.04f, 0.04f, 0.04f);
-	m_boxMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_boxMesh, materials[WOOD]);
 	m_boxMesh->ResetTransformations();
-	m_boxTexture->Unbind();
 
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_birchwoodTexture->Bind();
+	SetTextureFragmentShader(*m_birchwoodTexture);
 	m_boxMesh->Translate(ROOM_WIDTH / 2.f - 3.f, -ROOM_HEIGHT / 2.f + 2.5f, ROOM_LENGTH / 2.f - 3.f);
 	m_boxMesh->Rotate(glm::half_pi<float>(), 0.f, 1.f, 0.f);
 	m_boxMesh->Scale(0.03f, 0.03f, 0.04f);
-	m_boxMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_boxMesh, materials[WOOD]);
 	m_boxMesh->ResetTransformations();
-	m_birchwoodTexture->Unbind();
 
 	SetTextureTypeFragmentShader(PROCEDURAL_WOOD_TEXTURE);
 	m_boxMesh->Translate(ROOM_WIDTH / 2.f - 3.f, -ROOM_HEIGHT / 2.f, ROOM_LENGTH / 2.f - 8.f);
 	m_boxMesh->Rotate(glm::half_pi<float>() + 1.f, 0.f, 1.f, 0.f);
 	m_boxMesh->Scale(0.05f, 0.05f, 0.05f);
-	m_boxMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_boxMesh, materials[WOOD]);
 	m_boxMesh->ResetTransformations();
 
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_doorwoodTexture->Bind();
+	SetTextureFragmentShader(*m_doorwoodTexture);
 	m_boxMesh->Translate(ROOM_WIDTH / 2.f - 3.f, -ROOM_HEIGHT / 2.f + 3.f, ROOM_LENGTH / 2.f - 7.f);
 	m_boxMesh->Rotate(glm::quarter_pi<float>(), 0.f, 1.f, 0.f);
 	m_boxMesh->Scale(0.06f, 0.06f, 0.06f);
-	m_boxMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_boxMesh, materials[WOOD]);
 	m_boxMesh->ResetTransformations();
-	m_doorwoodTexture->Bind();
 }
 
-void Scene::DrawBulb(const Camera& camera, const glm::vec3& bulbPosition) const
+void Scene::DrawBulb(const glm::vec3& bulbPosition) const
 {
 	SetTextureTypeFragmentShader(NO_TEXTURE);
 	m_bulbMesh->Translate(bulbPosition);
 	m_bulbMesh->Scale(0.02f, 0.02f, 0.02f);
-	m_bulbMesh->Draw(camera, materials[GLASS], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_bulbMesh, materials[GLASS]);
 	m_bulbMesh->ResetTransformations();
 }
 
-void Scene::DrawLamp(const Camera& camera, const glm::vec3& lampPosition) const
+void Scene::DrawLamp(const glm::vec3& lampPosition) const
 {
 	// Lamp + bulb (which is a little bit rotated and translated for our needs, so we cannot use DrawBulb() method
 	SetTextureTypeFragmentShader(NO_TEXTURE);
@@ -576,22 +722,19 @@ void Scene::DrawLamp(const Camera& camera, const glm::vec3& lampPosition) const
 	m_bulbMesh->Translate(-0.5f, 1.7f, 0.f);
 	m_bulbMesh->Rotate(-0.5f, glm::vec3(0.f, 0.f, 1.f));
 	m_bulbMesh->Scale(0.02f, 0.02f, 0.02f);
-	m_bulbMesh->Draw(camera, materials[GLASS], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_bulbMesh, materials[GLASS]);
 	m_bulbMesh->ResetTransformations();
 
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_binTexture->Bind();
+	SetTextureFragmentShader(*m_binTexture);
 	m_lampMesh->Translate(lampPosition);
 	m_lampMesh->Rotate(glm::pi<float>() - .5f, glm::vec3(0.f, 1.f, 0.f));
 	m_lampMesh->Scale(0.1f, 0.1f, 0.1f);
-	m_lampMesh->Draw(camera, materials[BRONZE], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_lampMesh, materials[BRONZE]);
 	m_lampMesh->ResetTransformations();
-	m_binTexture->Unbind();
 }
 
 void Scene::DrawLevitatingRubikCube(const Camera& camera) const
 {
-	SetTextureTypeFragmentShader(NO_TEXTURE);
 	auto&& translateVec = glm::vec3(-ROOM_WIDTH / 2.f + 3.f, m_rubikCubeHeightOffset, ROOM_LENGTH / 2.f - 3.f);
 	auto&& rotateVec = glm::vec3(1.f, 1.f, 1.f);
 	auto&& scaleVec = glm::vec3(2.f, 2.f, 2.f);
@@ -601,64 +744,66 @@ void Scene::DrawLevitatingRubikCube(const Camera& camera) const
 	transformationMat = glm::scale(transformationMat, scaleVec);
 
 	m_rubikCube->SetUserTransformationMatrix(transformationMat);
-	m_rubikCube->Draw(camera, m_matrixUniforms, m_materialUniforms);
+
+	glm::vec3 center;
+	float radius;
+	m_rubikCube->GetBoundingSphere(center, radius);
+
+	if (Frustum(camera.GetMatrix()).IsSphereVisible(center, radius)) {
+		glUniform1i(m_textureTypeUniform, static_cast<GLint>(NO_TEXTURE));
+		m_rubikCube->Draw(camera, m_matrixUniforms, m_materialUniforms, m_instanceUniforms);
+	}
 	m_rubikCube->SetUserTransformationMatrix();
 }
 
-void Scene::DrawBouncingBalls(const Camera& camera) const
+void Scene::DrawBouncingBalls() const
 {
 	SetTextureTypeFragmentShader(NO_TEXTURE);
 	m_sphereMesh->Translate(-ROOM_WIDTH / 4.f, -m_bouncingBallHeightOffset, -ROOM_LENGTH / 2.f + 2.f);
 	m_sphereMesh->Scale(1.f, m_bouncingBallBounceScale, 1.f);
-	m_sphereMesh->Draw(camera, materials[BRONZE], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_sphereMesh, materials[BRONZE]);
 	m_sphereMesh->ResetTransformations();
 
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_binTexture->Bind();
+	SetTextureFragmentShader(*m_binTexture);
 	m_sphereMesh->Translate(-ROOM_WIDTH / 6.f, -m_bouncingBallHeightOffset, -ROOM_LENGTH / 2.f + 2.f);
 	m_sphereMesh->Scale(1.f, m_bouncingBallBounceScale, 1.f);
-	m_sphereMesh->Draw(camera, materials[BRONZE], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_sphereMesh, materials[BRONZE]);
 	m_sphereMesh->ResetTransformations();
-	m_binTexture->Bind();
 
 	SetTextureTypeFragmentShader(PROCEDURAL_WOOD_TEXTURE);
-	m_binTexture->Bind();
 	m_sphereMesh->Translate(-ROOM_WIDTH / 10.f, -m_bouncingBallHeightOffset, -ROOM_LENGTH / 2.f + 2.f);
 	m_sphereMesh->Scale(1.f, m_bouncingBallBounceScale, 1.f);
-	m_sphereMesh->Draw(camera, materials[WOOD], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_sphereMesh, materials[WOOD]);
 	m_sphereMesh->ResetTransformations();
-	m_binTexture->Bind();
 }
 
-void Scene::DrawMirror(const Camera& camera) const
+void Scene::DrawMirror() const
 {
-	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE);
-	m_mirror->BindMirrorAsTexture();
+	SetTextureTypeFragmentShader(LOADED_GL_TEXTURE, &m_mirror->GetTexture());
 	m_wallMesh->Translate(-10.f, 0.f, ROOM_LENGTH / 2.f - 0.5f);
 	m_wallMesh->Rotate(glm::half_pi<float>(), glm::vec3(1.f, 0.f, 0.f));
 	m_wallMesh->Scale(5.f, 1.f, 3.f);
-	m_wallMesh->Draw(camera, materials[GLASS], m_matrixUniforms, m_materialUniforms);
+	Submit(*m_wallMesh, materials[GLASS]);
 	m_wallMesh->ResetTransformations();
-	m_mirror->UnbindMirrorAsTexture();
-}
-
-void Scene::DrawSceneWithoutMirror(const Camera& camera) const
-{
-	DrawRoom(camera);
-	DrawShelvesWithMiniTable(camera);
-	DrawBin(camera);
-	DrawDoor(camera);
-	DrawTable(camera);
-	DrawChairs(camera);
-	DrawLaptop(camera);
-	DrawClock(camera);
-	DrawBoxes(camera);
-	DrawLamp(camera, m_spotLightsPositions[0]);
-	DrawLamp(camera, m_spotLightsPositions[1]);
-	DrawBulb(camera, m_pointLightsPositions[0]);
-	DrawBulb(camera, m_pointLightsPositions[1]);
-	DrawLevitatingRubikCube(camera);
-	DrawBouncingBalls(camera);
+}
+
+void Scene::QueueSceneWithoutMirror(const Camera& camera, RenderPass pass) const
+{
+	DrawRoom();
+	DrawShelvesWithMiniTable();
+	DrawBin();
+	DrawDoor();
+	DrawTable();
+	DrawChairs();
+	DrawLaptop();
+	DrawClock();
+	DrawBoxes();
+	DrawLamp(m_spotLightsPositions[0]);
+	DrawLamp(m_spotLightsPositions[1]);
+	DrawBulb(m_pointLightsPositions[0]);
+	DrawBulb(m_pointLightsPositions[1]);
+	DrawBouncingBalls();
+	QueueDrawItems(camera, pass);
 }
 
 void Scene::Draw(const Camera& camera) const
@@ -670,14 +815,27 @@ void Scene::Draw(const Camera& camera) const
 	// Send eye position into shader
 	glUniform3fv(m_eyePositionUniform, 1, glm::value_ptr(camera.GetEyePosition()));
 
+	// Both passes are sorted together, mirror pass goes first
+	auto&& reflectedCamera = m_mirror->GetReflectedCamera(camera, glm::vec3(1.f, 1.f, -1.f));
+
+	m_renderQueue->Clear();
+	QueueSceneWithoutMirror(reflectedCamera, MIRROR_PASS);
+
+	// Mirror is culled together with the rest of the scene
+	DrawMirror();
+	QueueSceneWithoutMirror(camera, MAIN_PASS);
+
+	m_renderQueue->Sort();
+
 	// Mirrored scene
 	m_mirror->SetActive();
-	DrawSceneWithoutMirror(m_mirror->GetReflectedCamera(camera, glm::vec3(1.f, 1.f, -1.f)));
+	m_renderQueue->Execute(MIRROR_PASS, reflectedCamera);
+	DrawLevitatingRubikCube(reflectedCamera);
 	m_mirror->SetInactive();
 
 	// Normal scene
-	DrawSceneWithoutMirror(camera);
-	DrawMirror(camera);
+	m_renderQueue->Execute(MAIN_PASS, camera);
+	DrawLevitatingRubikCube(camera);
 	
 	m_shader->SetInactive();
 }
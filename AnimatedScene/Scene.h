@@ -5,17 +5,27 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include <future>
 #include <memory>
 #include "Camera.h"
 #include "RubikCube.h"
+#include "ReductionSolver.h"
+#include "PocketCubeSolver.h"
+#include "CubeScrambler.h"
+#include "TaskPool.h"
 #include "MeshObject.h"
 #include "ShaderProgram.h"
 #include "MaterialShaderUniforms.h"
 #include "SurfaceMaterial.h"
 #include "MaterialShaderUniforms.h"
+#include "InstanceShaderUniforms.h"
 #include "Texture.h"
 #include "LightContainer.h"
 #include "Mirror.h"
+#include "AssetRegistry.h"
+#include "Frustum.h"
+#include "RenderQueue.h"
+#include <vector>
 
 class Scene final {
 private:
@@ -24,42 +34,52 @@ private:
 	static constexpr float ROOM_HEIGHT = 17.f;
 	static constexpr float ROOM_LENGTH = 30.f;
 
+	// Time spent with GL uploads of loaded assets each frame
+	static constexpr float UPLOAD_BUDGET_MS = 4.f;
+
+	// Every mesh and texture is loaded through the registry
+	std::unique_ptr<AssetRegistry> m_assetRegistry;
+
 	// In-Scene objects (ugly solution)
 	std::unique_ptr<RubikCube> m_rubikCube;
-	std::unique_ptr<MeshObject> m_wallMesh;
-	std::unique_ptr<MeshObject> m_binMesh;
-	std::unique_ptr<MeshObject> m_boxMesh;
-	std::unique_ptr<MeshObject> m_chairMesh;
-	std::unique_ptr<MeshObject> m_tableMesh;
-	std::unique_ptr<MeshObject> m_shelvesWithMiniTableMesh;
-	std::unique_ptr<MeshObject> m_doorMesh;
-	std::unique_ptr<MeshObject> m_sphereMesh;
-	std::unique_ptr<MeshObject> m_cubeMesh;
-	std::unique_ptr<MeshObject> m_notebookMesh;
-	std::unique_ptr<MeshObject> m_notebookDisplayMesh;
-	std::unique_ptr<MeshObject> m_clockMesh;
-	std::unique_ptr<MeshObject> m_clockHandMesh;
-	std::unique_ptr<MeshObject> m_lampMesh;
-	std::unique_ptr<MeshObject> m_bulbMesh;
+	std::unique_ptr<CubeScrambler> m_cubeScrambler;
+	std::shared_ptr<MeshObject> m_wallMesh;
+	std::shared_ptr<MeshObject> m_binMesh;
+	std::shared_ptr<MeshObject> m_boxMesh;
+	std::shared_ptr<MeshObject> m_chairMesh;
+	std::shared_ptr<MeshObject> m_tableMesh;
+	std::shared_ptr<MeshObject> m_shelvesWithMiniTableMesh;
+	std::shared_ptr<MeshObject> m_doorMesh;
+	std::shared_ptr<MeshObject> m_sphereMesh;
+	std::shared_ptr<MeshObject> m_cubeMesh;
+	std::shared_ptr<MeshObject> m_notebookMesh;
+	std::shared_ptr<MeshObject> m_notebookDisplayMesh;
+	std::shared_ptr<MeshObject> m_clockMesh;
+	std::shared_ptr<MeshObject> m_clockHandMesh;
+	std::shared_ptr<MeshObject> m_lampMesh;
+	std::shared_ptr<MeshObject> m_bulbMesh;
 
 	// In-Scene textures (ugly solution)
-	std::unique_ptr<Texture> m_binTexture;
-	std::unique_ptr<Texture> m_birchwoodTexture;
-	std::unique_ptr<Texture> m_doorwoodTexture;
-	std::unique_ptr<Texture> m_metalTexture;
-	std::unique_ptr<Texture> m_boxTexture;
-	std::unique_ptr<Texture> m_wallTexture;
-	std::unique_ptr<Texture> m_notebookDisplayContentTexture;
+	std::shared_ptr<Texture> m_binTexture;
+	std::shared_ptr<Texture> m_birchwoodTexture;
+	std::shared_ptr<Texture> m_doorwoodTexture;
+	std::shared_ptr<Texture> m_metalTexture;
+	std::shared_ptr<Texture> m_boxTexture;
+	std::shared_ptr<Texture> m_wallTexture;
+	std::shared_ptr<Texture> m_notebookDisplayContentTexture;
 
 	// Our shader and it's variables
 	std::unique_ptr<ShaderProgram> m_shader;
 
 	MaterialShaderUniforms m_materialUniforms;
 	MatrixShaderUniforms m_matrixUniforms;
+	InstanceShaderUniforms m_instanceUniforms;
 
 	GLint m_positionAttribute;
 	GLint m_normalAttribute;
 	GLint m_texelAttribute;
+	GLint m_instanceModelMatrixAttribute;
+	GLint m_instanceMaterialIndexAttribute;
 	GLint m_eyePositionUniform;
 	GLint m_textureSamplerUniform;
 	GLint m_textureTypeUniform;
@@ -67,14 +87,34 @@ private:
 	std::unique_ptr<Mirror> m_mirror;
 	std::unique_ptr<LightContainer> m_lightContainer;
 
+	// Culled meshes of both passes, sorted and drawn with redundant state changes skipped
+	std::unique_ptr<RenderQueue> m_renderQueue;
+
 	// Two point and two spot lights are used in this scene
 	std::array<glm::vec3, 2> m_pointLightsPositions;
 	std::array<glm::vec3, 2> m_spotLightsPositions;
 
+	// Solvers of the levitating cube, their tables may have to be generated on the first run
+	struct CubeSolvers {
+		std::unique_ptr<CubeSolver> cubeSolver;
+		std::unique_ptr<ReductionSolver> reductionSolver;
+		std::unique_ptr<PocketCubeSolver> pocketCubeSolver; // optimal solutions of 2x2 cube
+
+		bool IsLoaded() const { return reductionSolver || pocketCubeSolver; }
+	};
+
+	// Loaded in the background, empty until then
+	std::shared_ptr<CubeSolvers> m_cubeSolvers;
+
+	// Cube is solved off the main thread, moves are queued once the solution is ready
+	std::unique_ptr<TaskPool> m_solverPool;
+	std::future<std::vector<CubeState::Move>> m_cubeSolution;
+
 	// Levitating Rubik's Cube animation parameters
 	float m_rubikCubeDirection;
 	float m_rubikCubeHeightOffset;
 	float m_rubikCubeAngle;
+	bool m_rubikCubeSolving; // queued moves solve the cube, random state follows
 
 	// Bouncing balls animation parameters
 	float m_bouncingBallHeightOffset;
@@ -91,35 +131,84 @@ private:
 		NO_TEXTURE
 	};
 
-	void SetTextureTypeFragmentShader(TextureTypeFragmentShader type) const;
+	// The scene is rendered twice, the mirror's reflection first
+	enum RenderPass {
+		MIRROR_PASS = 0,
+		MAIN_PASS,
+		NUM_RENDER_PASSES
+	};
+
+	// Mesh draw recorded by Draw* methods, queued after frustum culling of the whole pass
+	struct DrawItem {
+		const MeshObject* mesh;
+		glm::mat4 modelMatrix;
+		const SurfaceMaterial* material;
+		TextureTypeFragmentShader textureType;
+		const Texture* texture;
+	};
+
+	mutable std::vector<DrawItem> m_drawItems;
+	mutable BoundingSphereArray m_drawItemSpheres;
+	mutable std::vector<unsigned char> m_drawItemVisibility;
+
+	// LODs of draw items from the previous frame, for hysteresis
+	// Draw items are recorded in the same order every frame
+	mutable std::array<std::vector<unsigned char>, NUM_RENDER_PASSES> m_drawItemLods;
+
+	// Texture used by the next submitted mesh
+	mutable TextureTypeFragmentShader m_submitTextureType;
+	mutable const Texture* m_submitTexture;
+
+	void SetTextureTypeFragmentShader(TextureTypeFragmentShader type, const Texture* texture = nullptr) const;
+
+	// Use loaded texture, use no texture at all while it's still loading
+	void SetTextureFragmentShader(const Texture& texture) const;
+
+	// Record mesh with it's current transformations and texture
+	void Submit(const MeshObject& mesh, const SurfaceMaterial& material) const;
+
+	// Cull recorded meshes against the camera's frustum and queue the visible ones
+	void QueueDrawItems(const Camera& camera, RenderPass pass) const;
 
 	// Initialization
 	void ResetAll();
 	void InitAttribsAndUniforms();
+	std::shared_ptr<MeshObject> LoadMesh(const std::string& filepath);
+	std::shared_ptr<Texture> LoadTexture(const std::string& filepath);
 	void InitSceneObjects();
 	void InitSceneTextures();
 	void CreateLightContainerAndLights();
 
+	// Load solver tables through the asset loader
+	void LoadCubeSolvers();
+
+	// Solve current state of the cube on the solver pool
+	void StartCubeSolution();
+
 	void UpdateLevitatingRubikCube(float deltaTime);
 	void UpdateBouncingBall(float deltaTime);
 
 	// Draw methods (ugly solution)
-	void DrawRoom(const Camera& camera) const;
-	void DrawClock(const Camera& camera) const;
-	void DrawShelvesWithMiniTable(const Camera& camera) const;
-	void DrawLaptop(const Camera& camera) const;
-	void DrawBin(const Camera& camera) const;
-	void DrawDoor(const Camera& camera) const;
-	void DrawTable(const Camera& camera) const;
-	void DrawChairs(const Camera& camera) const;
-	void DrawBoxes(const Camera& camera) const;
-	void DrawBulb(const Camera& camera, const glm::vec3& bulbPosition) const;
-	void DrawLamp(const Camera& camera, const glm::vec3& lampPosition) const;
+	// Meshes are only submitted, see QueueDrawItems()
+	void DrawRoom() const;
+	void DrawClock() const;
+	void DrawShelvesWithMiniTable() const;
+	void DrawLaptop() const;
+	void DrawBin() const;
+	void DrawDoor() const;
+	void DrawTable() const;
+	void DrawChairs() const;
+	void DrawBoxes() const;
+	void DrawBulb(const glm::vec3& bulbPosition) const;
+	void DrawLamp(const glm::vec3& lampPosition) const;
+	void DrawBouncingBalls() const;
+	void DrawMirror() const;
+
+	// Rubik's Cube is drawn immediately (culled as a whole)
 	void DrawLevitatingRubikCube(const Camera& camera) const;
-	void DrawBouncingBalls(const Camera& camera) const;
-	void DrawMirror(const Camera& camera) const;
 
-	void DrawSceneWithoutMirror(const Camera& camera) const;
+	// Queue meshes of the scene into given pass
+	void QueueSceneWithoutMirror(const Camera& camera, RenderPass pass) const;
 
 public:
 
@@ -135,6 +224,14 @@ public:
 
 	void Update(float deltaTime);
 	void Draw(const Camera& camera) const;
+
+	// Draw calls and state changes of meshes in the last frame (Rubik's Cube excluded)
+	const RenderStats& GetRenderStats() const { return m_renderQueue->GetStats(); }
+
+	AssetMemoryStats GetAssetMemoryStats() const { return m_assetRegistry->GetMemoryStats(); }
+
+	// Moves of the levitating cube removed by canonicalization of queued sequences
+	size_t GetNumSavedCubeMoves() const { return m_rubikCube->GetNumSavedMoves(); }
 };
 
 #endif
\ No newline at end of file
@@ -3,9 +3,10 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <stdexcept>
 #include <array>
+#include <cstddef>
 
 namespace {
-	std::array<SurfaceMaterial, 6> stickerMaterials = {
+	std::array<SurfaceMaterial, Sticker::NUM_COLORS> stickerMaterials = {
 		// White
 		SurfaceMaterial(
 			glm::vec3(.05f, .05f, .05f),
@@ -49,10 +50,15 @@ const SurfaceMaterial& Sticker::GetStickerMaterial(Sticker::Color color)
 	return stickerMaterials[static_cast<unsigned int>(color)];
 }
 
-Sticker::Sticker(GLint positionShaderAttribute, GLint normalShaderAttribute)
+Sticker::Sticker(GLint positionShaderAttribute, GLint normalShaderAttribute,
+	GLint instanceModelMatrixAttribute, GLint instanceColorAttribute)
 {
 	ResetAll();
 	CreateMesh(positionShaderAttribute, normalShaderAttribute);
+
+	if (instanceModelMatrixAttribute >= 0 && instanceColorAttribute >= 0) {
+		CreateInstanceBuffer(instanceModelMatrixAttribute, instanceColorAttribute);
+	}
 }
 
 Sticker::~Sticker()
@@ -71,6 +77,9 @@ Sticker& Sticker::operator=(Sticker&& s)
 	m_verticesAndNormalsVBO = s.m_verticesAndNormalsVBO;
 	m_verticesAndNormalsCount = s.m_verticesAndNormalsCount;
 	m_stickerVAO = s.m_stickerVAO;
+	m_instanceVBO = s.m_instanceVBO;
+	m_instanceCapacity = s.m_instanceCapacity;
+	m_instanced = s.m_instanced;
 	s.ResetAll();
 	return *this;
 }
@@ -80,6 +89,9 @@ void Sticker::ResetAll()
 	m_stickerVAO = 0;
 	m_verticesAndNormalsVBO = 0;
 	m_verticesAndNormalsCount = 0;
+	m_instanceVBO = 0;
+	m_instanceCapacity = 0;
+	m_instanced = false;
 }
 
 void Sticker::DestroyAll()
@@ -87,6 +99,9 @@ void Sticker::DestroyAll()
 	if (m_verticesAndNormalsVBO > 0) {
 		glDeleteBuffers(1, &m_verticesAndNormalsVBO);
 	}
+	if (m_instanceVBO > 0) {
+		glDeleteBuffers(1, &m_instanceVBO);
+	}
 	if (m_stickerVAO > 0) {
 		glDeleteVertexArrays(1, &m_stickerVAO);
 	}
@@ -113,7 +128,7 @@ void Sticker::CreateMesh(GLint positionShaderAttribute, GLint normalShaderAttrib
 		s, s, -s, 0.f, 1.f, 0.f
 	};
 
-	m_verticesAndNormalsCount = sizeof(vertices) / sizeof(*vertices);
+	m_verticesAndNormalsCount = sizeof(vertices) / (sizeof(*vertices) * 6);
 
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -142,14 +157,76 @@ void Sticker::CreateMesh(GLint positionShaderAttribute, GLint normalShaderAttrib
 	glBindBuffer(GL_ARRAY_BUFFER, m_verticesAndNormalsVBO);
 }
 
+void Sticker::CreateInstanceBuffer(GLint instanceModelMatrixAttribute, GLint instanceColorAttribute)
+{
+	glGenBuffers(1, &m_instanceVBO);
+
+	if (m_instanceVBO == 0) {
+		DestroyAll();
+		throw std::runtime_error("Unable to create sticker instance vbo");
+	}
+
+	glBindVertexArray(m_stickerVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+
+	// Matrix attribute takes four consecutive locations, one per column
+	for (GLuint column = 0; column < 4; column++) {
+		auto attribute = static_cast<GLuint>(instanceModelMatrixAttribute) + column;
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+			reinterpret_cast<const void*>(offsetof(Instance, modelMatrix) + sizeof(glm::vec4) * column));
+		glVertexAttribDivisor(attribute, 1);
+	}
+
+	glEnableVertexAttribArray(instanceColorAttribute);
+	glVertexAttribIPointer(instanceColorAttribute, 1, GL_INT, sizeof(Instance),
+		reinterpret_cast<const void*>(offsetof(Instance, color)));
+	glVertexAttribDivisor(instanceColorAttribute, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_instanced = true;
+}
+
+void Sticker::SetPaletteUniforms(const InstanceShaderUniforms& instanceUniforms)
+{
+	std::array<glm::vec3, NUM_COLORS> ambientColors;
+	std::array<glm::vec3, NUM_COLORS> diffuseColors;
+	std::array<glm::vec3, NUM_COLORS> specularColors;
+	std::array<GLfloat, NUM_COLORS> shininess;
+
+	for (auto color = 0u; color < NUM_COLORS; color++) {
+		const auto& material = stickerMaterials[color];
+		ambientColors[color] = material.ambientColor;
+		diffuseColors[color] = material.diffuseColor;
+		specularColors[color] = material.specularColor;
+		shininess[color] = material.shininess;
+	}
+
+	glUniform3fv(instanceUniforms.paletteAmbientColorsUniform, NUM_COLORS, glm::value_ptr(ambientColors[0]));
+	glUniform3fv(instanceUniforms.paletteDiffuseColorsUniform, NUM_COLORS, glm::value_ptr(diffuseColors[0]));
+	glUniform3fv(instanceUniforms.paletteSpecularColorsUniform, NUM_COLORS, glm::value_ptr(specularColors[0]));
+	glUniform1fv(instanceUniforms.paletteShininessUniform, NUM_COLORS, shininess.data());
+}
+
 void Sticker::Draw(const Camera& camera, 
 	const glm::mat4& modelMatrix,
 	const SurfaceMaterial& surfaceMaterial,
 	const MatrixShaderUniforms& matrixUniforms,
 	const MaterialShaderUniforms& materialUniforms) const
+{
+	Draw(camera, modelMatrix, glm::mat3(glm::inverse(glm::transpose(modelMatrix))), surfaceMaterial, matrixUniforms, materialUniforms);
+}
+
+void Sticker::Draw(const Camera& camera,
+	const glm::mat4& modelMatrix,
+	const glm::mat3& normalMatrix,
+	const SurfaceMaterial& surfaceMaterial,
+	const MatrixShaderUniforms& matrixUniforms,
+	const MaterialShaderUniforms& materialUniforms) const
 {
 	auto pvmMatrix = camera.GetMatrix() * modelMatrix;
-	auto normalMatrix = glm::mat3(glm::inverse(glm::transpose(modelMatrix)));
 
 	glUniformMatrix4fv(matrixUniforms.pvmMatrixUniform, 1, GL_FALSE, glm::value_ptr(pvmMatrix));
 	glUniformMatrix3fv(matrixUniforms.normalMatrixUniform, 1, GL_FALSE, glm::value_ptr(normalMatrix));
@@ -164,3 +241,61 @@ void Sticker::Draw(const Camera& camera,
 	glDrawArrays(GL_QUADS, 0, m_verticesAndNormalsCount);
 	glBindVertexArray(0);
 }
+
+void Sticker::DrawInstanced(const Camera& camera,
+	const glm::mat4& modelMatrix,
+	const std::vector<Instance>& instances,
+	const MatrixShaderUniforms& matrixUniforms,
+	const MaterialShaderUniforms& materialUniforms,
+	const InstanceShaderUniforms& instanceUniforms,
+	const std::vector<glm::mat3>* instanceNormalMatrices) const
+{
+	if (instances.empty()) {
+		return;
+	}
+
+	if (!m_instanced) {
+		auto normalMatrix = glm::mat3(glm::inverse(glm::transpose(modelMatrix)));
+
+		for (size_t i = 0; i < instances.size(); i++) {
+			auto& instance = instances[i];
+			auto& material = GetStickerMaterial(static_cast<Color>(instance.color));
+
+			if (instanceNormalMatrices) {
+				Draw(camera, modelMatrix * instance.modelMatrix, normalMatrix * (*instanceNormalMatrices)[i],
+					material, matrixUniforms, materialUniforms);
+			}
+			else {
+				Draw(camera, modelMatrix * instance.modelMatrix, material, matrixUniforms, materialUniforms);
+			}
+		}
+		return;
+	}
+
+	// Normal matrix is computed per instance in vertex shader
+	auto pvmMatrix = camera.GetMatrix() * modelMatrix;
+
+	glUniformMatrix4fv(matrixUniforms.pvmMatrixUniform, 1, GL_FALSE, glm::value_ptr(pvmMatrix));
+	glUniformMatrix4fv(matrixUniforms.modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+	SetPaletteUniforms(instanceUniforms);
+	glUniform1i(instanceUniforms.instancedUniform, GL_TRUE);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+
+	if (instances.size() > m_instanceCapacity) {
+		m_instanceCapacity = instances.size();
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * m_instanceCapacity, instances.data(), GL_STREAM_DRAW);
+	}
+	else {
+		// Orphan the previous storage, it may be still in use by the previous draw
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * m_instanceCapacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Instance) * instances.size(), instances.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(m_stickerVAO);
+	glDrawArraysInstanced(GL_QUADS, 0, m_verticesAndNormalsCount, static_cast<GLsizei>(instances.size()));
+	glBindVertexArray(0);
+
+	glUniform1i(instanceUniforms.instancedUniform, GL_FALSE);
+}
@@ -6,9 +6,12 @@
 
 #include "MaterialShaderUniforms.h"
 #include "MatrixShaderUniforms.h"
+#include "InstanceShaderUniforms.h"
 #include "SurfaceMaterial.h"
 #include "Camera.h"
 
+#include <vector>
+
 // Generic top-faced sticker used as surface on rubik cube
 class Sticker final {
 public:
@@ -22,14 +25,30 @@ public:
 		YELLOW
 	};
 
+	static constexpr unsigned int NUM_COLORS = 6;
+
 	static const SurfaceMaterial& GetStickerMaterial(Color color);
 
+	// Upload sticker materials into shader's palette
+	static void SetPaletteUniforms(const InstanceShaderUniforms& instanceUniforms);
+
+	// Per-instance vertex data of instanced drawing
+	struct Instance {
+		glm::mat4 modelMatrix;
+		GLint color;
+	};
+
 private:
 
 	GLuint m_verticesAndNormalsVBO;
 	GLuint m_verticesAndNormalsCount;
 	GLuint m_stickerVAO;
 
+	// Instance data are streamed every draw, the buffer only grows
+	GLuint m_instanceVBO;
+	mutable size_t m_instanceCapacity;
+	bool m_instanced;
+
 	// Reset all values to zero, do not destroy anything
 	void ResetAll();
 
@@ -39,9 +58,14 @@ private:
 	// Setup sticker's vbo and vao
 	void CreateMesh(GLint positionShaderAttribute, GLint normalShaderAttribute);
 
+	// Setup instance vbo and it's attributes in sticker's vao
+	void CreateInstanceBuffer(GLint instanceModelMatrixAttribute, GLint instanceColorAttribute);
+
 public:
 
-	Sticker(GLint positionShaderAttribute, GLint normalShaderAttribute);
+	// Instanced drawing is available only if both instance attributes are given
+	Sticker(GLint positionShaderAttribute, GLint normalShaderAttribute,
+		GLint instanceModelMatrixAttribute = -1, GLint instanceColorAttribute = -1);
 	~Sticker();
 
 	Sticker(Sticker&& s);
@@ -53,12 +77,34 @@ public:
 
 	float StickerSize() const { return 1.f; }
 
+	// Instanced drawing is available, instances are not drawn one by one
+	bool IsInstanced() const { return m_instanced; }
+
 	// Draw this sticker on given position
 	void Draw(const Camera& camera,
 		const glm::mat4& modelMatrix,
 		const SurfaceMaterial& surfaceMaterial,
 		const MatrixShaderUniforms& matrixUniforms,
 		const MaterialShaderUniforms& materialUniforms) const;
+
+	// Same as above with known normal matrix (inverse transpose of the model matrix)
+	void Draw(const Camera& camera,
+		const glm::mat4& modelMatrix,
+		const glm::mat3& normalMatrix,
+		const SurfaceMaterial& surfaceMaterial,
+		const MatrixShaderUniforms& matrixUniforms,
+		const MaterialShaderUniforms& materialUniforms) const;
+
+	// Draw all instances with single draw call, instance matrices are applied before the model matrix
+	// Falls back to one draw per instance if instanced drawing is not available,
+	// normal matrices of instances (if given) then save inversion of every instance's matrix
+	void DrawInstanced(const Camera& camera,
+		const glm::mat4& modelMatrix,
+		const std::vector<Instance>& instances,
+		const MatrixShaderUniforms& matrixUniforms,
+		const MaterialShaderUniforms& materialUniforms,
+		const InstanceShaderUniforms& instanceUniforms,
+		const std::vector<glm::mat3>* instanceNormalMatrices = nullptr) const;
 };
 
 #endif
\ No newline at end of file
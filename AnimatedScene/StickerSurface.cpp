@@ -0,0 +1,228 @@
+#include "StickerSurface.h"
+#include "Sticker.h"
+#include "CubeState.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <cstddef>
+#include <stdexcept>
+
+namespace {
+	// Stickers lie slightly above the unit cube's faces
+	const float STICKER_HEIGHT = 0.501f;
+}
+
+StickerSurface::StickerSurface(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute)
+{
+	ResetAll();
+	CreateQuadsVAO(positionShaderAttribute, normalShaderAttribute, texelShaderAttribute);
+
+	// Integer textures cannot be filtered
+	m_stateTexture.SetMinMagNearestFilter();
+	m_stateTexture.SetWrapClampToEdge();
+}
+
+StickerSurface::~StickerSurface()
+{
+	DestroyAll();
+}
+
+StickerSurface::StickerSurface(StickerSurface&& s)
+{
+	ResetAll();
+	*this = std::move(s);
+}
+
+StickerSurface& StickerSurface::operator=(StickerSurface&& s)
+{
+	DestroyAll();
+	m_stateTexture = std::move(s.m_stateTexture);
+	m_numStickersEdge = s.m_numStickersEdge;
+	m_quadsVBO = s.m_quadsVBO;
+	m_quadsVAO = s.m_quadsVAO;
+	m_quadsCapacity = s.m_quadsCapacity;
+	m_quads = std::move(s.m_quads);
+	s.ResetAll();
+	return *this;
+}
+
+void StickerSurface::ResetAll()
+{
+	m_numStickersEdge = 0;
+	m_quadsVBO = 0;
+	m_quadsVAO = 0;
+	m_quadsCapacity = 0;
+	m_quads.clear();
+}
+
+void StickerSurface::DestroyAll()
+{
+	if (m_quadsVBO > 0) {
+		glDeleteBuffers(1, &m_quadsVBO);
+	}
+	if (m_quadsVAO > 0) {
+		glDeleteVertexArrays(1, &m_quadsVAO);
+	}
+	ResetAll();
+}
+
+void StickerSurface::CreateQuadsVAO(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute)
+{
+	glGenBuffers(1, &m_quadsVBO);
+
+	if (m_quadsVBO == 0) {
+		DestroyAll();
+		throw std::runtime_error("Unable to create sticker surface vbo");
+	}
+
+	glGenVertexArrays(1, &m_quadsVAO);
+
+	if (m_quadsVAO == 0) {
+		DestroyAll();
+		throw std::runtime_error("Unable to create sticker surface vao");
+	}
+
+	glBindVertexArray(m_quadsVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_quadsVBO);
+
+	if (positionShaderAttribute >= 0) {
+		glEnableVertexAttribArray(positionShaderAttribute);
+		glVertexAttribPointer(positionShaderAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			reinterpret_cast<const void*>(offsetof(Vertex, position)));
+	}
+	if (normalShaderAttribute >= 0) {
+		glEnableVertexAttribArray(normalShaderAttribute);
+		glVertexAttribPointer(normalShaderAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			reinterpret_cast<const void*>(offsetof(Vertex, normal)));
+	}
+	if (texelShaderAttribute >= 0) {
+		glEnableVertexAttribArray(texelShaderAttribute);
+		glVertexAttribPointer(texelShaderAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			reinterpret_cast<const void*>(offsetof(Vertex, texel)));
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+unsigned int StickerSurface::GetMaxStickersPerEdge()
+{
+	GLint maxTextureSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	return static_cast<unsigned int>(maxTextureSize) / CubeState::NUM_FACES;
+}
+
+void StickerSurface::Resize(unsigned int numStickersEdge)
+{
+	if (numStickersEdge > GetMaxStickersPerEdge()) {
+		throw std::runtime_error("Sticker state texture exceeds GL_MAX_TEXTURE_SIZE");
+	}
+	m_numStickersEdge = numStickersEdge;
+
+	m_stateTexture.Bind();
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, numStickersEdge, numStickersEdge * 6, 0,
+		GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+	m_stateTexture.Unbind();
+}
+
+void StickerSurface::Upload(unsigned int face,
+	unsigned int startX, unsigned int startY,
+	unsigned int endX, unsigned int endY,
+	const GLubyte* faceStorage)
+{
+	if (endX > m_numStickersEdge || endY > m_numStickersEdge || face >= 6) {
+		throw std::runtime_error("Sticker surface upload is out of the cube proportions");
+	}
+	if (startX >= endX || startY >= endY) {
+		return; // no throw
+	}
+
+	// Rows of the rectangle are read directly from the storage
+	m_stateTexture.Bind();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, m_numStickersEdge);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, startY, face * m_numStickersEdge + startX, endY - startY, endX - startX,
+		GL_RED_INTEGER, GL_UNSIGNED_BYTE, faceStorage + startX * m_numStickersEdge + startY);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	m_stateTexture.Unbind();
+}
+
+void StickerSurface::AddQuad(const glm::mat4& faceMatrix,
+	unsigned int face,
+	unsigned int orientation,
+	unsigned int startX, unsigned int startY,
+	unsigned int endX, unsigned int endY)
+{
+	if (startX >= endX || startY >= endY) {
+		return;
+	}
+
+	auto stickerSize = 1.f / m_numStickersEdge;
+	auto&& normal = glm::normalize(glm::vec3(faceMatrix * glm::vec4(0.f, 1.f, 0.f, 0.f)));
+	auto faceRow = static_cast<float>(face * m_numStickersEdge);
+	auto faceSize = static_cast<float>(m_numStickersEdge);
+
+	// Same winding as single sticker
+	unsigned int corners[4][2] = { { endX, endY }, { startX, endY }, { startX, startY }, { endX, startY } };
+
+	for (auto& corner : corners) {
+		auto x = static_cast<float>(corner[0]);
+		auto y = static_cast<float>(corner[1]);
+		auto&& position = faceMatrix * glm::vec4(-0.5f + x * stickerSize, STICKER_HEIGHT, -0.5f + y * stickerSize, 1.f);
+
+		// Texel coordinates are in storage stickers
+		CubeState::MapToStorage(orientation, faceSize, x, y);
+		m_quads.push_back(Vertex{ glm::vec3(position), normal, glm::vec2(y, faceRow + x) });
+	}
+}
+
+void StickerSurface::Draw(const Camera& camera,
+	const glm::mat4& modelMatrix,
+	const SurfaceMaterial& gapMaterial,
+	const MatrixShaderUniforms& matrixUniforms,
+	const MaterialShaderUniforms& materialUniforms,
+	const InstanceShaderUniforms& instanceUniforms) const
+{
+	if (m_quads.empty()) {
+		return;
+	}
+
+	auto pvmMatrix = camera.GetMatrix() * modelMatrix;
+	auto normalMatrix = glm::mat3(glm::inverse(glm::transpose(modelMatrix)));
+
+	glUniformMatrix4fv(matrixUniforms.pvmMatrixUniform, 1, GL_FALSE, glm::value_ptr(pvmMatrix));
+	glUniformMatrix3fv(matrixUniforms.normalMatrixUniform, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+	glUniformMatrix4fv(matrixUniforms.modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+
+	glUniform3fv(materialUniforms.ambientColorUniform, 1, glm::value_ptr(gapMaterial.ambientColor));
+	glUniform3fv(materialUniforms.diffuseColorUniform, 1, glm::value_ptr(gapMaterial.diffuseColor));
+	glUniform3fv(materialUniforms.specularColorUniform, 1, glm::value_ptr(gapMaterial.specularColor));
+	glUniform1f(materialUniforms.shininessUniform, gapMaterial.shininess);
+
+	Sticker::SetPaletteUniforms(instanceUniforms);
+	glUniform1i(instanceUniforms.stickerStateUniform, GL_TRUE);
+	glUniform1i(instanceUniforms.stickerStateSamplerUniform, STATE_TEXTURE_UNIT);
+
+	glActiveTexture(GL_TEXTURE0 + STATE_TEXTURE_UNIT);
+	m_stateTexture.Bind();
+
+	// Few vertices only, streamed every draw
+	glBindBuffer(GL_ARRAY_BUFFER, m_quadsVBO);
+
+	if (m_quads.size() > m_quadsCapacity) {
+		m_quadsCapacity = m_quads.size();
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * m_quadsCapacity, m_quads.data(), GL_STREAM_DRAW);
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * m_quadsCapacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * m_quads.size(), m_quads.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(m_quadsVAO);
+	glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(m_quads.size()));
+	glBindVertexArray(0);
+
+	m_stateTexture.Unbind();
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(instanceUniforms.stickerStateUniform, GL_FALSE);
+}
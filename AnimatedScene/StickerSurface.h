@@ -0,0 +1,100 @@
+#ifndef STICKER_SURFACE_H
+#define STICKER_SURFACE_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "Camera.h"
+#include "Texture.h"
+#include "SurfaceMaterial.h"
+#include "MaterialShaderUniforms.h"
+#include "MatrixShaderUniforms.h"
+#include "InstanceShaderUniforms.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+// Rubik's cube stickers drawn as few large quads, one per face or face slice
+// Sticker colors live in integer texture (one texel per sticker), fragment shader draws the gaps
+// Texture mirrors CubeState's storage: sticker [x][y] of face f is at column y and row f * N + x
+class StickerSurface final {
+public:
+
+	// Texture unit 0 is used by scene textures
+	static constexpr GLint STATE_TEXTURE_UNIT = 1;
+
+private:
+
+	struct Vertex {
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 texel;
+	};
+
+	Texture m_stateTexture;
+	unsigned int m_numStickersEdge;
+
+	GLuint m_quadsVBO;
+	GLuint m_quadsVAO;
+	mutable size_t m_quadsCapacity;
+	std::vector<Vertex> m_quads;
+
+	// Reset all values to zero, do not destroy anything
+	void ResetAll();
+
+	// Remove and free it's content
+	void DestroyAll();
+
+	void CreateQuadsVAO(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute);
+
+public:
+
+	StickerSurface(GLint positionShaderAttribute, GLint normalShaderAttribute, GLint texelShaderAttribute);
+	~StickerSurface();
+
+	StickerSurface(StickerSurface&& s);
+	StickerSurface& operator=(StickerSurface&& s);
+
+	// FYI: OpenGL mesh
+	StickerSurface(const StickerSurface&) = delete;
+	StickerSurface& operator=(const StickerSurface&) = delete;
+
+	unsigned int GetNumStickersPerEdge() const { return m_numStickersEdge; }
+
+	// Largest cube whose state texture (N x 6N texels) fits into GL_MAX_TEXTURE_SIZE, needs GL context
+	static unsigned int GetMaxStickersPerEdge();
+
+	// Allocate state texture for new cube size, content is undefined until uploaded
+	// Throw an exception if the texture would exceed GL_MAX_TEXTURE_SIZE
+	void Resize(unsigned int numStickersEdge);
+
+	// Upload face's stickers [startX, endX) x [startY, endY) (in storage coordinates)
+	// Face storage contains all N * N stickers of the face
+	void Upload(unsigned int face,
+		unsigned int startX, unsigned int startY,
+		unsigned int endX, unsigned int endY,
+		const GLubyte* faceStorage);
+
+	void ClearQuads() { m_quads.clear(); }
+
+	// Add quad covering face's stickers [startX, endX) x [startY, endY)
+	// Face matrix moves top face (in cube's space) onto it's place
+	// Orientation maps the stickers into face's storage, see CubeState::MapToStorage
+	void AddQuad(const glm::mat4& faceMatrix,
+		unsigned int face,
+		unsigned int orientation,
+		unsigned int startX, unsigned int startY,
+		unsigned int endX, unsigned int endY);
+
+	// Draw all quads with single draw call, gaps between stickers use given material
+	void Draw(const Camera& camera,
+		const glm::mat4& modelMatrix,
+		const SurfaceMaterial& gapMaterial,
+		const MatrixShaderUniforms& matrixUniforms,
+		const MaterialShaderUniforms& materialUniforms,
+		const InstanceShaderUniforms& instanceUniforms) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "TaskPool.h"
+
+#include <algorithm>
+
+namespace {
+	// Pool and queue of the worker running on this thread
+	thread_local const TaskPool* currentPool = nullptr;
+	thread_local size_t currentQueue = 0;
+}
+
+TaskPool::TaskPool(unsigned int numWorkers)
+	: m_stop(false),
+	m_numQueued(0),
+	m_numUnfinished(0),
+	m_nextQueue(0)
+{
+	if (numWorkers == 0) {
+		numWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	for (auto i = 0u; i < numWorkers; i++) {
+		m_queues.push_back(std::make_unique<Queue>());
+	}
+	for (size_t i = 0; i < numWorkers; i++) {
+		m_workers.emplace_back(&TaskPool::WorkerLoop, this, i);
+	}
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_workCondition.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+bool TaskPool::PopTask(size_t queue, Task& task)
+{
+	{
+		auto& own = *m_queues[queue];
+		std::lock_guard<std::mutex> lock(own.mutex);
+
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			m_numQueued--;
+			return true;
+		}
+	}
+
+	// Oldest tasks are the largest parts of split work
+	for (size_t i = 1; i < m_queues.size(); i++) {
+		auto& victim = *m_queues[(queue + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			m_numQueued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void TaskPool::WorkerLoop(size_t queue)
+{
+	currentPool = this;
+	currentQueue = queue;
+
+	while (true) {
+		Task task;
+
+		if (PopTask(queue, task)) {
+			try {
+				task();
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!m_error) {
+					m_error = std::current_exception();
+				}
+			}
+
+			if (--m_numUnfinished == 0) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_doneCondition.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_workCondition.wait(lock, [this]() { return m_stop || m_numQueued > 0; });
+
+		if (m_stop) {
+			return;
+		}
+	}
+}
+
+void TaskPool::Submit(Task task)
+{
+	auto queue = (currentPool == this) ? currentQueue : m_nextQueue++ % m_queues.size();
+
+	m_numUnfinished++;
+	{
+		auto& target = *m_queues[queue];
+		std::lock_guard<std::mutex> lock(target.mutex);
+		target.tasks.push_back(std::move(task));
+	}
+	m_numQueued++;
+
+	// Sleeping worker checks the counter under the mutex
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+	}
+	m_workCondition.notify_one();
+}
+
+void TaskPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this]() { return m_numUnfinished == 0; });
+
+	if (m_error) {
+		auto error = m_error;
+		m_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for CPU bound tasks
+// Every worker has it's own queue, tasks submitted by a task go into the queue of it's worker
+// Worker takes the newest task of it's queue, idle worker steals the oldest task of another queue
+class TaskPool final {
+public:
+
+	using Task = std::function<void()>;
+
+private:
+
+	struct Queue {
+		std::deque<Task> tasks;
+		std::mutex mutex;
+	};
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	// Guards sleeping of workers and waiting for tasks
+	std::mutex m_mutex;
+	std::condition_variable m_workCondition;
+	std::condition_variable m_doneCondition;
+	std::exception_ptr m_error;
+	bool m_stop;
+
+	std::atomic<size_t> m_numQueued;
+	std::atomic<size_t> m_numUnfinished;
+	std::atomic<size_t> m_nextQueue;
+
+	bool PopTask(size_t queue, Task& task);
+	void WorkerLoop(size_t queue);
+
+public:
+
+	// Zero means one worker per hardware thread
+	TaskPool(unsigned int numWorkers = 0);
+
+	// Unfinished tasks are dropped
+	~TaskPool();
+
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	unsigned int GetNumWorkers() const { return static_cast<unsigned int>(m_workers.size()); }
+
+	// Thread safe, tasks may submit more tasks
+	void Submit(Task task);
+
+	// Block until all submitted tasks (and tasks submitted by them) are finished
+	// Must not be called from a task, rethrows the first exception thrown by a task
+	void Wait();
+};
+
+#endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 Texture::Texture()
 {
+	ResetAll();
 	glGenTextures(1, &m_texture);
 	if (m_texture == 0) {
 		throw std::runtime_error("Unable to generate texture");
@@ -10,8 +11,9 @@ Texture::Texture()
 }
 
 Texture::Texture(const std::string& filepath)
-	: m_texture(Utils::LoadTexture(filepath))
+	: Texture()
 {
+	SetImage(Utils::LoadTextureImage(filepath));
 	SetMinMagBilinearFilter();
 	SetWrapRepeat();
 }
@@ -23,6 +25,7 @@ Texture::~Texture()
 
 Texture::Texture(Texture&& texture)
 {
+	ResetAll();
 	*this = std::move(texture);
 }
 
@@ -30,6 +33,7 @@ Texture& Texture::operator=(Texture&& texture)
 {
 	DestroyAll();
 	m_texture = texture.m_texture;
+	m_gpuSize = texture.m_gpuSize;
 	texture.ResetAll();
 	return *this;
 }
@@ -41,6 +45,19 @@ void Texture::DestroyAll()
 	}
 }
 
+void Texture::SetImage(const Utils::TextureImage& image)
+{
+	Bind();
+
+	// FMI: https://www.khronos.org/opengl/wiki/Pixel_Transfer#Pixel_layout
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, image.format, image.width, image.height, 0, image.format,
+		image.type, reinterpret_cast<const void*>(image.pixels.data()));
+
+	Unbind();
+	m_gpuSize = image.pixels.size();
+}
+
 void Texture::CreateMipmap() const
 {
 	Bind();
@@ -6,12 +6,15 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "Utils.h"
+
 class Texture {
 private:
 
 	GLuint m_texture;
+	size_t m_gpuSize;
 
-	void ResetAll() { m_texture = 0; }
+	void ResetAll() { m_texture = 0; m_gpuSize = 0; }
 	void DestroyAll();
 
 public:
@@ -30,6 +33,15 @@ public:
 	Texture(const Texture&) = delete;
 	Texture& operator=(const Texture&) = delete;
 
+	// Upload decoded image into the texture (level 0)
+	void SetImage(const Utils::TextureImage& image);
+
+	// Has any image been uploaded by SetImage?
+	bool IsLoaded() const { return m_gpuSize > 0; }
+
+	// Size of uploaded image in bytes (mipmaps are not counted)
+	size_t GetGpuSize() const { return m_gpuSize; }
+
 	GLuint GetTexture() const { return m_texture; }
 	void Bind() const { glBindTexture(GL_TEXTURE_2D, m_texture); }
 	void Unbind() const { glBindTexture(GL_TEXTURE_2D, 0); }
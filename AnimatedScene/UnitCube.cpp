@@ -4,6 +4,18 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <stdexcept>
 
+namespace {
+	const SurfaceMaterial cubeMaterial(
+		glm::vec3(.1f, .1f, .1f),
+		glm::vec3(.3f, .3f, .3f),
+		glm::vec3(.8f, .8f, .8f), 32.f);
+}
+
+const SurfaceMaterial& UnitCube::GetSurfaceMaterial()
+{
+	return cubeMaterial;
+}
+
 UnitCube::UnitCube(GLint positionShaderAttribute, GLint normalShaderAttribute)
 {
 	ResetAll();
@@ -173,10 +185,10 @@ void UnitCube::Draw(const Camera& camera,
 	glUniformMatrix3fv(matrixUniforms.normalMatrixUniform, 1, GL_FALSE, glm::value_ptr(glm::mat3(GetNormalMatrix())));
 	glUniformMatrix4fv(matrixUniforms.modelMatrixUniform, 1, GL_FALSE, glm::value_ptr(m_modelMatrix));
 
-	glUniform3f(materialUniforms.ambientColorUniform, .1f, .1f, .1f);
-	glUniform3f(materialUniforms.diffuseColorUniform, .3f, .3f, .3f);
-	glUniform3f(materialUniforms.specularColorUniform, .8f, .8f, .8f);
-	glUniform1f(materialUniforms.shininessUniform, 32.f);
+	glUniform3fv(materialUniforms.ambientColorUniform, 1, glm::value_ptr(cubeMaterial.ambientColor));
+	glUniform3fv(materialUniforms.diffuseColorUniform, 1, glm::value_ptr(cubeMaterial.diffuseColor));
+	glUniform3fv(materialUniforms.specularColorUniform, 1, glm::value_ptr(cubeMaterial.specularColor));
+	glUniform1f(materialUniforms.shininessUniform, cubeMaterial.shininess);
 
 	glBindVertexArray(m_cubeVAO);
 	glDrawElements(GL_QUADS, m_numIndices, GL_UNSIGNED_INT, nullptr);
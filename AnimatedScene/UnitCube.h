@@ -8,6 +8,7 @@
 #include "MatrixShaderUniforms.h"
 #include "MaterialShaderUniforms.h"
 #include "ModelObject.h"
+#include "SurfaceMaterial.h"
 
 // Simple unit cube which is used for drawing Rubik's cube parts (after specific transformations ofc.)
 class UnitCube final : public ModelObject {
@@ -42,6 +43,8 @@ public:
 
 	float CubeSize() const { return 1.f; }
 
+	static const SurfaceMaterial& GetSurfaceMaterial();
+
 	void Draw(const Camera& camera,
 		const MatrixShaderUniforms& matrixUniforms,
 		const MaterialShaderUniforms& materialUniforms) const;
@@ -1,9 +1,25 @@
 #include "Utils.h"
+#include "MappedFile.h"
 
 #include <fstream>
 #include <array>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <glm/glm.hpp>
 
+#ifdef _WIN32
+#include <process.h>
+#define GET_PROCESS_ID _getpid
+#else
+#include <unistd.h>
+#define GET_PROCESS_ID getpid
+#endif
+
 #ifndef _UNICODE
 #define _UNICODE
 #include <IL/il.h>
@@ -14,29 +30,386 @@
 
 namespace {
 	const auto VERTEX_RESERVE_COUNT = 1024u;
-}
 
-void Utils::LoadObjFile(const std::string& filepath,
-	std::vector<GLfloat>& verticesArray,
-	std::vector<GLfloat>& normalsArray,
-	std::vector<GLfloat>& texelsArray)
-{
-	std::fstream file(filepath, std::fstream::in);
+	// Files larger than this are parsed on multiple threads in AUTO mode
+	const size_t PARALLEL_PARSE_THRESHOLD = 4u * 1024u * 1024u;
 
-	if (!file.good()) {
-		throw std::runtime_error("Unable to open .obj file: " + filepath);
-	}
+	// Do not bother with spawning a thread for less than this
+	const size_t MIN_CHUNK_SIZE = 1024u * 1024u;
+
+	// Optional components of face corner ("v", "v/t", "v//n" or "v/t/n")
+	// and indices relative to the chunk they were parsed in (negative .obj indices)
+	enum FaceComponents : unsigned char {
+		FACE_TEXEL = 1,
+		FACE_NORMAL = 2,
+		FACE_RELATIVE_VERTEX = 4,
+		FACE_RELATIVE_TEXEL = 8,
+		FACE_RELATIVE_NORMAL = 16,
+	};
 
 	struct Face {
 		GLuint vertexIndex;
 		GLuint texelIndex;
 		GLuint normalIndex;
+		unsigned char components;
 	};
 
 	typedef glm::vec3 Vertex;
 	typedef glm::vec2 Texel;
 	typedef std::array<Face, 3> Triangle;
 
+	// Indexed content of .obj file (or it's chunk) before it's flattened for OpenGL
+	struct ObjData {
+		std::vector<Vertex> vertices;
+		std::vector<Vertex> normals;
+		std::vector<Texel> texels;
+		std::vector<Triangle> triangles;
+		bool hasRelativeIndices = false;
+
+		void Reserve(size_t bytes)
+		{
+			// Rough estimate from the size, avoids most of the reallocations
+			auto estimatedCount = std::max<size_t>(VERTEX_RESERVE_COUNT, bytes / 128);
+			vertices.reserve(estimatedCount);
+			normals.reserve(estimatedCount);
+			texels.reserve(estimatedCount);
+			triangles.reserve(estimatedCount);
+		}
+	};
+
+	// Where chunk's data start in the merged arrays
+	struct ObjDataOffset {
+		size_t vertices = 0;
+		size_t normals = 0;
+		size_t texels = 0;
+		size_t triangles = 0;
+	};
+
+	inline bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* SkipBlanks(const char* it, const char* end)
+	{
+		while (it < end && IsBlank(*it)) {
+			it++;
+		}
+		return it;
+	}
+
+	inline const char* SkipLine(const char* it, const char* end)
+	{
+		auto eol = static_cast<const char*>(std::memchr(it, '\n', end - it));
+		return (eol == nullptr) ? end : eol + 1;
+	}
+
+	inline const char* ParseFloat(const char* it, const char* end, float& value)
+	{
+		it = SkipBlanks(it, end);
+
+		// from_chars does not accept explicit plus sign
+		if (it < end && *it == '+') {
+			it++;
+		}
+
+		value = 0.f;
+		return std::from_chars(it, end, value).ptr;
+	}
+
+	// Parse one .obj index and convert it into 0-based index
+	// Negative index is stored as signed position within the chunk (it may point into previous chunks)
+	// and flagged, it's fixed during merge
+	inline const char* ParseIndex(const char* it, const char* end, size_t count, unsigned char relativeFlag,
+		ObjData& data, Face& face, GLuint& index)
+	{
+		long long value = 0;
+		it = std::from_chars(it, end, value).ptr;
+
+		if (value < 0) {
+			index = static_cast<GLuint>(static_cast<GLint>(static_cast<long long>(count) + value));
+			face.components |= relativeFlag;
+			data.hasRelativeIndices = true;
+		}
+		else {
+			index = static_cast<GLuint>(value - 1);
+		}
+		return it;
+	}
+
+	// Parse "v", "v/t", "v//n" or "v/t/n" face corner
+	inline const char* ParseFace(const char* it, const char* end, ObjData& data, Face& face)
+	{
+		it = SkipBlanks(it, end);
+		face.texelIndex = 0;
+		face.normalIndex = 0;
+		face.components = 0;
+		it = ParseIndex(it, end, data.vertices.size(), FACE_RELATIVE_VERTEX, data, face, face.vertexIndex);
+
+		if (it < end && *it == '/') {
+			it++;
+			if (it < end && *it != '/') {
+				it = ParseIndex(it, end, data.texels.size(), FACE_RELATIVE_TEXEL, data, face, face.texelIndex);
+				face.components |= FACE_TEXEL;
+			}
+			if (it < end && *it == '/') {
+				it = ParseIndex(it + 1, end, data.normals.size(), FACE_RELATIVE_NORMAL, data, face, face.normalIndex);
+				face.components |= FACE_NORMAL;
+			}
+		}
+		return it;
+	}
+
+	// Tokenize .obj content in place, no heap allocation per line
+	void ParseObjData(const char* it, const char* end, ObjData& data)
+	{
+		while (it < end) {
+			it = SkipBlanks(it, end);
+
+			if (end - it > 2 && it[0] == 'v' && IsBlank(it[1])) {
+				Vertex vertex;
+				it = ParseFloat(it + 2, end, vertex.x);
+				it = ParseFloat(it, end, vertex.y);
+				it = ParseFloat(it, end, vertex.z);
+				data.vertices.push_back(vertex);
+			}
+			else if (end - it > 3 && it[0] == 'v' && it[1] == 'n' && IsBlank(it[2])) {
+				Vertex normal;
+				it = ParseFloat(it + 3, end, normal.x);
+				it = ParseFloat(it, end, normal.y);
+				it = ParseFloat(it, end, normal.z);
+				data.normals.push_back(normal);
+			}
+			else if (end - it > 3 && it[0] == 'v' && it[1] == 't' && IsBlank(it[2])) {
+				Texel texel;
+				it = ParseFloat(it + 3, end, texel.x);
+				it = ParseFloat(it, end, texel.y);
+				data.texels.push_back(texel);
+			}
+			else if (end - it > 2 && it[0] == 'f' && IsBlank(it[1])) {
+				data.triangles.emplace_back();
+				it += 2;
+
+				for (auto&& face : data.triangles.back()) {
+					it = ParseFace(it, end, data, face);
+				}
+			}
+
+			// ignore rest
+			it = SkipLine(it, end);
+		}
+	}
+
+	// Turn chunk-relative indices into global ones
+	void FixRelativeIndices(ObjData& data, const ObjDataOffset& offset)
+	{
+		static auto fixIndex = [](Face& face, unsigned char relativeFlag, GLuint& index, size_t chunkOffset) {
+			if (face.components & relativeFlag) {
+				index = static_cast<GLuint>(static_cast<long long>(chunkOffset) + static_cast<GLint>(index));
+			}
+		};
+
+		for (auto& triangle : data.triangles) {
+			for (auto& face : triangle) {
+				fixIndex(face, FACE_RELATIVE_VERTEX, face.vertexIndex, offset.vertices);
+				fixIndex(face, FACE_RELATIVE_NORMAL, face.normalIndex, offset.normals);
+				fixIndex(face, FACE_RELATIVE_TEXEL, face.texelIndex, offset.texels);
+				face.components &= FACE_TEXEL | FACE_NORMAL;
+			}
+		}
+		data.hasRelativeIndices = false;
+	}
+
+	// Normal of the triangle's plane, used for corners without normal
+	inline Vertex GetFaceNormal(const Triangle& triangle, const ObjData& data)
+	{
+		const auto& a = data.vertices[triangle[0].vertexIndex];
+		const auto& b = data.vertices[triangle[1].vertexIndex];
+		const auto& c = data.vertices[triangle[2].vertexIndex];
+
+		auto&& normal = glm::cross(b - a, c - a);
+		auto length = glm::length(normal);
+		return (length > 0.f) ? normal / length : Vertex(0.f, 0.f, 1.f); // degenerate triangle
+	}
+
+	// Parse triangles into something readable in OpenGL
+	// Missing texels are zero, missing normals are replaced by the face normal
+	// Output arrays must be already large enough, writing starts at given triangle offset
+	void FlattenTriangles(const std::vector<Triangle>& triangles,
+		const ObjData& data,
+		size_t triangleOffset,
+		std::vector<GLfloat>& verticesArray,
+		std::vector<GLfloat>& normalsArray,
+		std::vector<GLfloat>& texelsArray)
+	{
+		auto vertexOut = verticesArray.data() + triangleOffset * 3 * 3;
+		auto normalOut = normalsArray.data() + triangleOffset * 3 * 3;
+		auto texelOut = texelsArray.data() + triangleOffset * 3 * 2;
+
+		const Texel defaultTexel(0.f, 0.f);
+
+		for (const auto& triangle : triangles) {
+			auto hasAllNormals = (triangle[0].components & triangle[1].components & triangle[2].components & FACE_NORMAL) != 0;
+			auto faceNormal = hasAllNormals ? Vertex() : GetFaceNormal(triangle, data);
+
+			for (const auto& face : triangle) {
+				const auto& vertex = data.vertices[face.vertexIndex];
+				const auto& normal = (face.components & FACE_NORMAL) ? data.normals[face.normalIndex] : faceNormal;
+				const auto& texel = (face.components & FACE_TEXEL) ? data.texels[face.texelIndex] : defaultTexel;
+
+				*vertexOut++ = vertex.x;
+				*vertexOut++ = vertex.y;
+				*vertexOut++ = vertex.z;
+
+				*normalOut++ = normal.x;
+				*normalOut++ = normal.y;
+				*normalOut++ = normal.z;
+
+				*texelOut++ = texel.s;
+				*texelOut++ = texel.t;
+			}
+		}
+	}
+
+	void ResizeOutputArrays(size_t numTriangles,
+		std::vector<GLfloat>& verticesArray,
+		std::vector<GLfloat>& normalsArray,
+		std::vector<GLfloat>& texelsArray)
+	{
+		verticesArray.resize(numTriangles * 3 * 3);
+		normalsArray.resize(numTriangles * 3 * 3);
+		texelsArray.resize(numTriangles * 3 * 2);
+	}
+
+	void LoadObjSequential(const char* begin, const char* end,
+		std::vector<GLfloat>& verticesArray,
+		std::vector<GLfloat>& normalsArray,
+		std::vector<GLfloat>& texelsArray)
+	{
+		ObjData data;
+		data.Reserve(end - begin);
+		ParseObjData(begin, end, data);
+
+		if (data.hasRelativeIndices) {
+			FixRelativeIndices(data, ObjDataOffset());
+		}
+
+		ResizeOutputArrays(data.triangles.size(), verticesArray, normalsArray, texelsArray);
+		FlattenTriangles(data.triangles, data, 0, verticesArray, normalsArray, texelsArray);
+	}
+
+	// Split the file at line boundaries, parse chunks on worker threads,
+	// merge vertex data in file order and flatten triangles in parallel again
+	void LoadObjParallel(const char* begin, const char* end, unsigned int numChunks,
+		std::vector<GLfloat>& verticesArray,
+		std::vector<GLfloat>& normalsArray,
+		std::vector<GLfloat>& texelsArray)
+	{
+		auto size = static_cast<size_t>(end - begin);
+
+		std::vector<const char*> bounds = { begin };
+		for (auto i = 1u; i < numChunks; i++) {
+			auto split = std::max(bounds.back(), begin + size / numChunks * i);
+			bounds.push_back(SkipLine(split, end));
+		}
+		bounds.push_back(end);
+
+		// Parse
+		std::vector<ObjData> chunks(numChunks);
+		std::vector<std::future<void>> tasks;
+
+		for (auto i = 0u; i < numChunks; i++) {
+			tasks.push_back(std::async(std::launch::async, [&, i]() {
+				chunks[i].Reserve(bounds[i + 1] - bounds[i]);
+				ParseObjData(bounds[i], bounds[i + 1], chunks[i]);
+			}));
+		}
+		for (auto& task : tasks) {
+			task.get(); // rethrows
+		}
+
+		// Merge vertex data, faces already use global indices (except relative ones)
+		std::vector<ObjDataOffset> offsets(numChunks);
+		ObjDataOffset total;
+
+		for (auto i = 0u; i < numChunks; i++) {
+			offsets[i] = total;
+			total.vertices += chunks[i].vertices.size();
+			total.normals += chunks[i].normals.size();
+			total.texels += chunks[i].texels.size();
+			total.triangles += chunks[i].triangles.size();
+		}
+
+		ObjData merged;
+		merged.vertices.reserve(total.vertices);
+		merged.normals.reserve(total.normals);
+		merged.texels.reserve(total.texels);
+
+		for (auto& chunk : chunks) {
+			merged.vertices.insert(merged.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+			merged.normals.insert(merged.normals.end(), chunk.normals.begin(), chunk.normals.end());
+			merged.texels.insert(merged.texels.end(), chunk.texels.begin(), chunk.texels.end());
+			chunk.vertices = std::vector<Vertex>();
+			chunk.normals = std::vector<Vertex>();
+			chunk.texels = std::vector<Texel>();
+		}
+
+		// Flatten
+		ResizeOutputArrays(total.triangles, verticesArray, normalsArray, texelsArray);
+		tasks.clear();
+
+		for (auto i = 0u; i < numChunks; i++) {
+			tasks.push_back(std::async(std::launch::async, [&, i]() {
+				if (chunks[i].hasRelativeIndices) {
+					FixRelativeIndices(chunks[i], offsets[i]);
+				}
+				FlattenTriangles(chunks[i].triangles, merged, offsets[i].triangles,
+					verticesArray, normalsArray, texelsArray);
+			}));
+		}
+		for (auto& task : tasks) {
+			task.get();
+		}
+	}
+}
+
+void Utils::LoadObjFile(const std::string& filepath,
+	std::vector<GLfloat>& verticesArray,
+	std::vector<GLfloat>& normalsArray,
+	std::vector<GLfloat>& texelsArray,
+	ObjLoadMode mode)
+{
+	MappedFile file(filepath);
+
+	auto begin = file.GetData();
+	auto end = begin + file.GetSize();
+
+	auto maxChunks = std::max(1u, std::thread::hardware_concurrency());
+	auto numChunks = static_cast<unsigned int>(std::min<size_t>(maxChunks, file.GetSize() / MIN_CHUNK_SIZE));
+
+	if (mode == ObjLoadMode::AUTO) {
+		mode = (file.GetSize() >= PARALLEL_PARSE_THRESHOLD) ? ObjLoadMode::PARALLEL : ObjLoadMode::SEQUENTIAL;
+	}
+
+	if (mode == ObjLoadMode::PARALLEL && numChunks > 1) {
+		LoadObjParallel(begin, end, numChunks, verticesArray, normalsArray, texelsArray);
+	}
+	else {
+		LoadObjSequential(begin, end, verticesArray, normalsArray, texelsArray);
+	}
+}
+
+void Utils::LoadObjFileStream(const std::string& filepath,
+	std::vector<GLfloat>& verticesArray,
+	std::vector<GLfloat>& normalsArray,
+	std::vector<GLfloat>& texelsArray)
+{
+	std::fstream file(filepath, std::fstream::in);
+
+	if (!file.good()) {
+		throw std::runtime_error("Unable to open .obj file: " + filepath);
+	}
+
 	std::vector<Vertex> vertices;
 	std::vector<Vertex> normals;
 	std::vector<Texel> texels;
@@ -84,6 +457,7 @@ void Utils::LoadObjFile(const std::string& filepath,
 				face.vertexIndex = vertexIndex - 1;
 				face.normalIndex = normalIndex - 1;
 				face.texelIndex = texelIndex - 1;
+				face.components = FACE_TEXEL | FACE_NORMAL;
 			}
 		}
 
@@ -133,13 +507,24 @@ void Utils::LoadObjFile(const std::string& filepath,
 	texelsArray.shrink_to_fit();
 }
 
+std::string Utils::GetTemporaryPath(const std::string& filepath)
+{
+	std::ostringstream path;
+	path << filepath << '.' << GET_PROCESS_ID() << '.' << std::this_thread::get_id() << ".tmp";
+	return path.str();
+}
+
 void Utils::InitTextureLoader()
 {
 	ilInit();
 }
 
-GLuint Utils::LoadTexture(const std::string& filepath)
+Utils::TextureImage Utils::LoadTextureImage(const std::string& filepath)
 {
+	// DevIL keeps global state (bound image), it's not thread-safe
+	static std::mutex devilMutex;
+	std::lock_guard<std::mutex> lock(devilMutex);
+
 	auto image = ilGenImage();
 
 	if (image == 0) {
@@ -150,7 +535,7 @@ GLuint Utils::LoadTexture(const std::string& filepath)
 	ilEnable(IL_ORIGIN_SET);
 	ilOriginFunc(IL_ORIGIN_LOWER_LEFT);
 
-	static auto freeContent = [&]() {
+	auto freeContent = [&]() {
 		ilBindImage(0);
 		ilDeleteImage(image);
 	};
@@ -163,17 +548,18 @@ GLuint Utils::LoadTexture(const std::string& filepath)
 		throw std::runtime_error("Unable to load image: " + filepath);
 	}
 
-	auto imageW = ilGetInteger(IL_IMAGE_WIDTH);
-	auto imageH = ilGetInteger(IL_IMAGE_HEIGHT);
+	TextureImage result;
+	result.width = ilGetInteger(IL_IMAGE_WIDTH);
+	result.height = ilGetInteger(IL_IMAGE_HEIGHT);
+	result.type = static_cast<GLenum>(ilGetInteger(IL_IMAGE_TYPE));
+
 	auto imageFormat = ilGetInteger(IL_IMAGE_FORMAT);
-	auto pixelDataType = ilGetInteger(IL_IMAGE_TYPE);
-	GLint textureFormat;
 
 	if (imageFormat == IL_RGB) {
-		textureFormat = GL_RGB;
+		result.format = GL_RGB;
 	}
 	else if (imageFormat == IL_RGBA) {
-		textureFormat = GL_RGBA;
+		result.format = GL_RGBA;
 	}
 	else {
 		// screw other formats
@@ -181,24 +567,9 @@ GLuint Utils::LoadTexture(const std::string& filepath)
 		throw std::runtime_error("Unsupported image format: " + filepath);
 	}
 
-	GLuint texture;
-	glGenTextures(1, &texture);
-
-	if (texture == 0) {
-		freeContent();
-		throw std::runtime_error("Unable to generate texture: " + filepath);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	// FMI: https://www.khronos.org/opengl/wiki/Pixel_Transfer#Pixel_layout
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	// ADD glTexParameter*
-	glTexImage2D(GL_TEXTURE_2D, 0, textureFormat, imageW, imageH, 0, static_cast<GLenum>(textureFormat),
-		static_cast<GLenum>(pixelDataType), reinterpret_cast<const void*>(ilGetData()));
-
-	glBindTexture(GL_TEXTURE_2D, 0);
+	auto data = reinterpret_cast<const unsigned char*>(ilGetData());
+	result.pixels.assign(data, data + ilGetInteger(IL_IMAGE_SIZE_OF_DATA));
 
 	freeContent();
-	return texture;
+	return result;
 }
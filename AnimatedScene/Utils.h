@@ -7,18 +7,48 @@
 
 namespace Utils {
 
+	enum class ObjLoadMode {
+		AUTO, // parallel for large files only
+		SEQUENTIAL,
+		PARALLEL,
+	};
+
 	// Load .obj file
+	// The file is memory mapped and tokenized in place
+	// Large files are split at line boundaries and parsed on multiple threads
 	// This function does not check for bad .obj file format!
 	void LoadObjFile(const std::string& filepath,
+		std::vector<GLfloat>& verticesArray,
+		std::vector<GLfloat>& normalsArray,
+		std::vector<GLfloat>& texelsArray,
+		ObjLoadMode mode = ObjLoadMode::AUTO);
+
+	// Load .obj file using iostreams
+	// Slow reference implementation, kept for benchmarking and comparison
+	void LoadObjFileStream(const std::string& filepath,
 		std::vector<GLfloat>& verticesArray,
 		std::vector<GLfloat>& normalsArray,
 		std::vector<GLfloat>& texelsArray);
 
-	// Must be called before LoadTexture is used
+	// Temporary file next to given one, unique to the calling process and thread
+	// Content is written there first and renamed into place, so concurrent writers never share it
+	std::string GetTemporaryPath(const std::string& filepath);
+
+	// Decoded image ready for glTexImage2D
+	struct TextureImage {
+		GLsizei width;
+		GLsizei height;
+		GLenum format; // GL_RGB or GL_RGBA
+		GLenum type;
+		std::vector<unsigned char> pixels;
+	};
+
+	// Must be called before LoadTextureImage is used
 	void InitTextureLoader();
 
-	// Load texture from given filename
-	GLuint LoadTexture(const std::string& filepath);
+	// Load image from given filename, no GL calls are made
+	// May be called from any thread, DevIL calls are serialized
+	TextureImage LoadTextureImage(const std::string& filepath);
 }
 
 #endif
\ No newline at end of file
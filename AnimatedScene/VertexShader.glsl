@@ -4,18 +4,35 @@ in vec4 position;
 in vec3 normal;
 in vec2 texel;
 
+// instanced drawing only
+in mat4 instance_model_matrix;
+in int instance_material_index;
+
 out vec3 vertex_position;
 out vec3 vertex_normal_vec;
 out vec2 vertex_texel;
+flat out int vertex_material_index; // -1 = use material uniforms
 
 uniform mat4 pvm_matrix;
 uniform mat3 normal_matrix;
 uniform mat4 model_matrix; // for vertex position in world space
 
+// Instance matrix is applied before the shared model matrix
+uniform bool instanced;
+
 void main()
 {
-	vertex_position = (model_matrix * position).xyz;
-	vertex_normal_vec = normalize(normal_matrix * normal);
+	if (instanced) {
+		mat4 instance_matrix = model_matrix * instance_model_matrix;
+		vertex_position = (instance_matrix * position).xyz;
+		vertex_normal_vec = normalize(transpose(inverse(mat3(instance_matrix))) * normal);
+		vertex_material_index = instance_material_index;
+		gl_Position = pvm_matrix * instance_model_matrix * position;
+	} else {
+		vertex_position = (model_matrix * position).xyz;
+		vertex_normal_vec = normalize(normal_matrix * normal);
+		vertex_material_index = -1;
+		gl_Position = pvm_matrix * position;
+	}
 	vertex_texel = texel;
-	gl_Position = pvm_matrix * position;
 }